@@ -0,0 +1,377 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include "shared/JuicinessAnalyzer.h"
+#include "shared/JuicyStageProfiler.h"
+#include "shared/JuicyTrace.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <vector>
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+// One parameter setup to measure: the defaults, one of the plugin's programs, or one value of
+// one of its choice parameters (Texture's material, the chain's slot order, ...).
+struct Preset
+{
+    juce::String name;
+    int program = -1;
+    juce::String choiceId;
+    int choiceIndex = 0;
+};
+
+struct BenchmarkSettings
+{
+    juce::StringArray signals { "drums", "pads", "noise", "silence" };
+    juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    juce::Array<int> blockSizes { 16, 64, 256, 1024, 4096 };
+    juce::Array<int> channelCounts { 2 };
+    juce::String presetFilter;
+    double seconds = 1.0;
+    int runs = 3;
+    bool offline = false;
+};
+
+constexpr const char* profileStageNames[] = { "preAnalysis", "dsp", "postAnalysis", "hostNotification" };
+constexpr const char* tierNames[] = { "full", "postAnalysisOnly", "decimatedAnalysis", "reducedDsp" };
+
+// Per-block cost in ns per sample (all channels), summarised.
+struct StageTiming
+{
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+StageTiming summarise(std::vector<double>& nsPerSample, double totalNs, double totalSamples)
+{
+    StageTiming timing;
+    if (nsPerSample.empty())
+        return timing;
+
+    std::sort(nsPerSample.begin(), nsPerSample.end());
+    const auto percentile = [&nsPerSample](double p)
+    {
+        const auto index = static_cast<size_t>(p * static_cast<double>(nsPerSample.size() - 1) + 0.5);
+        return nsPerSample[index];
+    };
+    timing.mean = totalNs / juce::jmax(1.0, totalSamples);
+    timing.p50 = percentile(0.5);
+    timing.p90 = percentile(0.9);
+    timing.p99 = percentile(0.99);
+    timing.max = nsPerSample.back();
+    return timing;
+}
+
+juce::var toVar(const StageTiming& timing)
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty("meanNsPerSample", timing.mean);
+    object->setProperty("p50NsPerSample", timing.p50);
+    object->setProperty("p90NsPerSample", timing.p90);
+    object->setProperty("p99NsPerSample", timing.p99);
+    object->setProperty("maxNsPerSample", timing.max);
+    return juce::var(object);
+}
+
+// The profiler's loads are shares of the block deadline, not ns per sample. Means are averaged
+// over the runs, p99 and max are the worst run's.
+juce::var toVar(const std::array<JuicyStageLoad, juicyNumProfileStages>& loads)
+{
+    auto* object = new juce::DynamicObject();
+    for (size_t stage = 0; stage < loads.size(); ++stage)
+    {
+        auto* load = new juce::DynamicObject();
+        load->setProperty("meanPercent", loads[stage].mean);
+        load->setProperty("p99Percent", loads[stage].p99);
+        load->setProperty("maxPercent", loads[stage].max);
+        object->setProperty(profileStageNames[stage], juce::var(load));
+    }
+    return juce::var(object);
+}
+
+juce::RangedAudioParameter* findTierParameter(juce::AudioProcessor& processor)
+{
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == "qualitytier")
+            return ranged;
+    return nullptr;
+}
+
+void fillSignal(juce::AudioBuffer<float>& buffer, const juce::String& signal, double sampleRate)
+{
+    buffer.clear();
+    juce::Random random(0x4d494352);
+    const auto sr = static_cast<float>(sampleRate);
+
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        const float t = static_cast<float>(i) / sr;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            float x = 0.0f;
+            if (signal == "drums")
+            {
+                // Kick on every beat at 120 bpm, hat on the off-beats.
+                const float beat = std::fmod(t, 0.5f);
+                const float offBeat = std::fmod(t + 0.25f, 0.5f);
+                const float kick = std::sin(juce::MathConstants<float>::twoPi * (50.0f + 120.0f * std::exp(-beat * 40.0f)) * beat)
+                                 * std::exp(-beat * 12.0f);
+                const float hat = (2.0f * random.nextFloat() - 1.0f) * std::exp(-offBeat * 90.0f);
+                x = 0.8f * kick + 0.35f * hat;
+            }
+            else if (signal == "pads")
+            {
+                // Slow-swelling detuned chord, slightly different per channel.
+                const float swell = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * 0.25f * t);
+                const float detune = 1.0f + 0.002f * static_cast<float>(ch);
+                for (const float hz : { 220.0f, 277.18f, 329.63f })
+                    x += std::sin(juce::MathConstants<float>::twoPi * hz * detune * t);
+                x *= 0.18f * swell;
+            }
+            else if (signal == "noise")
+            {
+                x = 0.5f * (2.0f * random.nextFloat() - 1.0f);
+            }
+            buffer.setSample(ch, i, x);
+        }
+    }
+}
+
+std::vector<Preset> listPresets(juce::AudioProcessor& processor)
+{
+    std::vector<Preset> presets;
+    presets.push_back({ "default", -1, {}, 0 });
+
+    if (processor.getNumPrograms() > 1)
+        for (int program = 0; program < processor.getNumPrograms(); ++program)
+            presets.push_back({ "program:" + processor.getProgramName(program), program, {}, 0 });
+
+    for (auto* parameter : processor.getParameters())
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter))
+            for (int index = 0; index < choice->choices.size(); ++index)
+                presets.push_back({ choice->paramID + "=" + choice->choices[index], -1, choice->paramID, index });
+    return presets;
+}
+
+void applyPreset(juce::AudioProcessor& processor, const Preset& preset)
+{
+    if (preset.program >= 0)
+        processor.setCurrentProgram(preset.program);
+
+    if (preset.choiceId.isNotEmpty())
+        for (auto* parameter : processor.getParameters())
+            if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter); choice != nullptr && choice->paramID == preset.choiceId)
+                choice->setValueNotifyingHost(choice->convertTo0to1(static_cast<float>(preset.choiceIndex)));
+}
+
+// Times processBlock, processBlockBypassed and a stand-alone JuicinessAnalyzer block by block
+// over the same input. The analyzer row is what one of the processor's two analysis passes
+// costs on its own. Real-time runs keep the quality governor active, so the tier of every
+// processed block is counted: a case that left the full tier measured less work.
+juce::var runCase(const juce::AudioBuffer<float>& input, const Preset& preset, double sampleRate, int blockSize,
+                  int numChannels, int runs, bool offline)
+{
+    std::vector<double> processTimes, bypassTimes, analyzerTimes;
+    double processNs = 0.0, bypassNs = 0.0, analyzerNs = 0.0, totalSamples = 0.0;
+    std::array<JuicyStageLoad, juicyNumProfileStages> stageLoads {};
+    std::array<int, std::size(tierNames)> tierBlocks {};
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    for (int run = 0; run < runs; ++run)
+    {
+        std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+        processor->setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        processor->setNonRealtime(offline);
+        applyPreset(*processor, preset);
+        processor->prepareToPlay(sampleRate, blockSize);
+        auto* tierParameter = findTierParameter(*processor);
+
+        std::unique_ptr<juce::AudioProcessor> bypassed(createPluginFilter());
+        bypassed->setPlayConfigDetails(numChannels, numChannels, sampleRate, blockSize);
+        bypassed->setNonRealtime(offline);
+        applyPreset(*bypassed, preset);
+        bypassed->prepareToPlay(sampleRate, blockSize);
+
+        JuicinessAnalyzer analyzer;
+        analyzer.prepare(sampleRate, blockSize, numChannels);
+
+        const auto time = [&block](std::vector<double>& times, double& totalNs, int num, auto&& work)
+        {
+            const auto before = juce::Time::getHighResolutionTicks();
+            work();
+            const double ns = 1.0e9 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - before);
+            const double samples = static_cast<double>(num) * block.getNumChannels();
+            times.push_back(ns / samples);
+            totalNs += ns;
+        };
+
+        for (int start = 0; start < input.getNumSamples(); start += blockSize)
+        {
+            const int num = juce::jmin(blockSize, input.getNumSamples() - start);
+            const auto load = [&]
+            {
+                block.setSize(numChannels, num, false, false, true);
+                for (int ch = 0; ch < numChannels; ++ch)
+                    block.copyFrom(ch, 0, input, ch, start, num);
+            };
+
+            load();
+            time(processTimes, processNs, num, [&] { processor->processBlock(block, midi); });
+            if (tierParameter != nullptr)
+            {
+                const int tier = juce::roundToInt(tierParameter->convertFrom0to1(tierParameter->getValue()));
+                ++tierBlocks[static_cast<size_t>(juce::jlimit(0, static_cast<int>(tierBlocks.size()) - 1, tier))];
+            }
+            load();
+            time(bypassTimes, bypassNs, num, [&] { bypassed->processBlockBypassed(block, midi); });
+            load();
+            time(analyzerTimes, analyzerNs, num, [&] { juce::ignoreUnused(analyzer.analyze(block)); });
+            totalSamples += static_cast<double>(num) * numChannels;
+        }
+
+        if (const auto* profiled = dynamic_cast<const JuicyProfiledProcessor*>(processor.get()))
+        {
+            for (size_t stage = 0; stage < stageLoads.size(); ++stage)
+            {
+                const auto load = profiled->getStageProfiler().getLoad(static_cast<JuicyProfileStage>(stage));
+                stageLoads[stage].mean += load.mean / static_cast<float>(runs);
+                stageLoads[stage].p99 = juce::jmax(stageLoads[stage].p99, load.p99);
+                stageLoads[stage].max = juce::jmax(stageLoads[stage].max, load.max);
+            }
+        }
+    }
+
+    auto* stages = new juce::DynamicObject();
+    stages->setProperty("processBlock", toVar(summarise(processTimes, processNs, totalSamples)));
+    stages->setProperty("processBlockBypassed", toVar(summarise(bypassTimes, bypassNs, totalSamples)));
+    stages->setProperty("analyzer", toVar(summarise(analyzerTimes, analyzerNs, totalSamples)));
+
+    auto* tiers = new juce::DynamicObject();
+    for (size_t tier = 0; tier < tierBlocks.size(); ++tier)
+        tiers->setProperty(tierNames[tier], tierBlocks[tier]);
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("preset", preset.name);
+    result->setProperty("sampleRate", sampleRate);
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("channels", numChannels);
+    result->setProperty("mode", offline ? "offline" : "realtime");
+    result->setProperty("stages", juce::var(stages));
+    if (JuicyStageProfiler::isEnabled())
+        result->setProperty("processStages", toVar(stageLoads));
+    result->setProperty("tierBlocks", juce::var(tiers));
+    return juce::var(result);
+}
+
+template <typename T>
+juce::Array<T> parseList(const juce::String& text, const juce::Array<T>& fallback)
+{
+    if (text.isEmpty())
+        return fallback;
+    juce::Array<T> values;
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", ""))
+        values.add(static_cast<T>(token.getDoubleValue()));
+    return values;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name) -> juce::String
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    BenchmarkSettings settings;
+    if (option("--signals").isNotEmpty())
+        settings.signals = juce::StringArray::fromTokens(option("--signals"), ",", "");
+    settings.sampleRates = parseList(option("--rates"), settings.sampleRates);
+    settings.blockSizes = parseList(option("--blocks"), settings.blockSizes);
+    settings.channelCounts = parseList(option("--channels"), settings.channelCounts);
+    settings.presetFilter = option("--preset");
+    if (option("--seconds").isNotEmpty())
+        settings.seconds = juce::jmax(0.05, option("--seconds").getDoubleValue());
+    if (option("--runs").isNotEmpty())
+        settings.runs = juce::jmax(1, option("--runs").getIntValue());
+    settings.offline = args.contains("--offline");
+
+    if (! JuicyStageProfiler::isEnabled())
+        std::fprintf(stderr, "per-stage loads need a build with -DJUICY_ENABLE_PROFILER=ON\n");
+
+    // Every block and stage of every case lands on one timeline; the instance IDs in the
+    // events tell the processors apart.
+    if (option("--trace").isNotEmpty())
+    {
+        if (! JuicyStageProfiler::isEnabled())
+            std::fprintf(stderr, "--trace records nothing unless built with -DJUICY_ENABLE_PROFILER=ON\n");
+        else if (! JuicyTrace::start(juce::File::getCurrentWorkingDirectory().getChildFile(option("--trace"))))
+            std::fprintf(stderr, "could not open %s for tracing\n", option("--trace").toRawUTF8());
+    }
+
+    std::vector<Preset> presets;
+    {
+        std::unique_ptr<juce::AudioProcessor> probe(createPluginFilter());
+        for (auto& preset : listPresets(*probe))
+            if (settings.presetFilter.isEmpty() || preset.name.containsIgnoreCase(settings.presetFilter))
+                presets.push_back(preset);
+    }
+
+    juce::Array<juce::var> cases;
+    for (const int numChannels : settings.channelCounts)
+    {
+        for (const double sampleRate : settings.sampleRates)
+        {
+            for (const auto& signal : settings.signals)
+            {
+                juce::AudioBuffer<float> input(juce::jmax(1, numChannels), static_cast<int>(settings.seconds * sampleRate));
+                fillSignal(input, signal, sampleRate);
+
+                for (const int blockSize : settings.blockSizes)
+                {
+                    for (const auto& preset : presets)
+                    {
+                        auto result = runCase(input, preset, sampleRate, juce::jmax(1, blockSize), juce::jmax(1, numChannels),
+                                              settings.runs, settings.offline);
+                        if (auto* object = result.getDynamicObject())
+                            object->setProperty("signal", signal);
+                        cases.add(result);
+                        const auto tierBlocks = result.getProperty("tierBlocks", {});
+                        const bool steppedDown = std::any_of(std::begin(tierNames) + 1, std::end(tierNames), [&tierBlocks](const char* tier)
+                                                             { return static_cast<int>(tierBlocks.getProperty(tier, 0)) > 0; });
+                        std::fprintf(stderr, "%s %s %.0f Hz %d ch %d samples: done%s\n", signal.toRawUTF8(), preset.name.toRawUTF8(),
+                                     sampleRate, numChannels, blockSize, steppedDown ? " (left the full tier)" : "");
+                    }
+                }
+            }
+        }
+    }
+
+    JuicyTrace::stop();
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("plugin", JucePlugin_Name);
+    report->setProperty("secondsPerCase", settings.seconds);
+    report->setProperty("runs", settings.runs);
+    report->setProperty("mode", settings.offline ? "offline" : "realtime");
+    report->setProperty("cases", cases);
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    const auto outputPath = option("--output");
+    if (outputPath.isNotEmpty())
+        return juce::File::getCurrentWorkingDirectory().getChildFile(outputPath).replaceWithText(json) ? 0 : 1;
+
+    std::printf("%s\n", json.toRawUTF8());
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include <cstdio>
+#include <limits>
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+struct BenchmarkSettings
+{
+    double sampleRate = 48000.0;
+    int numChannels = 2;
+    int blockSize = 512;
+    double seconds = 10.0;
+    int runs = 3;
+    juce::StringArray parameterValues; // "id=value" pairs in plain parameter units
+};
+
+struct RenderResult
+{
+    double cpuSeconds = 0.0;
+    juce::AudioBuffer<float> output;
+};
+
+// Drum-like noise bursts over two detuned tones, so envelopes, resonators and shapers all see
+// both transients and sustained material.
+void fillTestSignal(juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    const auto burstLength = static_cast<int>(sampleRate * 0.25);
+    juce::Random random(0x4a554943);
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        const int inBurst = i % burstLength;
+        const float env = std::exp(-static_cast<float>(inBurst) / static_cast<float>(sampleRate * 0.03));
+        const auto t = static_cast<float>(i / sampleRate);
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            const float tone = 0.2f * std::sin(juce::MathConstants<float>::twoPi * (110.0f + 0.7f * static_cast<float>(ch)) * t)
+                             + 0.1f * std::sin(juce::MathConstants<float>::twoPi * 1760.0f * t);
+            buffer.setSample(ch, i, 0.6f * env * (2.0f * random.nextFloat() - 1.0f) + tone);
+        }
+    }
+}
+
+RenderResult render(bool offline, const juce::AudioBuffer<float>& input, const BenchmarkSettings& settings)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    processor->setPlayConfigDetails(settings.numChannels, settings.numChannels, settings.sampleRate, settings.blockSize);
+    processor->setNonRealtime(offline);
+    for (const auto& assignment : settings.parameterValues)
+    {
+        const auto id = assignment.upToFirstOccurrenceOf("=", false, false);
+        const auto value = assignment.fromFirstOccurrenceOf("=", false, false).getFloatValue();
+        for (auto* parameter : processor->getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == id)
+                ranged->setValueNotifyingHost(ranged->convertTo0to1(value));
+    }
+    processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    RenderResult result;
+    result.output.makeCopyOf(input);
+    juce::AudioBuffer<float> block(settings.numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+    juce::int64 ticks = 0;
+
+    for (int start = 0; start < input.getNumSamples(); start += settings.blockSize)
+    {
+        const int num = juce::jmin(settings.blockSize, input.getNumSamples() - start);
+        block.setSize(settings.numChannels, num, false, false, true);
+        for (int ch = 0; ch < settings.numChannels; ++ch)
+            block.copyFrom(ch, 0, result.output, ch, start, num);
+
+        const auto before = juce::Time::getHighResolutionTicks();
+        processor->processBlock(block, midi);
+        ticks += juce::Time::getHighResolutionTicks() - before;
+
+        for (int ch = 0; ch < settings.numChannels; ++ch)
+            result.output.copyFrom(ch, start, block, ch, 0, num);
+    }
+
+    processor->releaseResources();
+    result.cpuSeconds = juce::Time::highResolutionTicksToSeconds(ticks);
+    return result;
+}
+
+// Best of several runs, which is the least disturbed by whatever else the machine is doing.
+RenderResult bestOf(bool offline, const juce::AudioBuffer<float>& input, const BenchmarkSettings& settings)
+{
+    auto best = render(offline, input, settings);
+    for (int run = 1; run < settings.runs; ++run)
+    {
+        auto next = render(offline, input, settings);
+        if (next.cpuSeconds < best.cpuSeconds)
+            best = std::move(next);
+    }
+    return best;
+}
+
+double differenceDb(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    double diff = 0.0;
+    double ref = 0.0;
+    for (int ch = 0; ch < a.getNumChannels(); ++ch)
+    {
+        for (int i = 0; i < a.getNumSamples(); ++i)
+        {
+            const double x = a.getSample(ch, i);
+            const double d = static_cast<double>(b.getSample(ch, i)) - x;
+            diff += d * d;
+            ref += x * x;
+        }
+    }
+    if (diff <= 0.0)
+        return -std::numeric_limits<double>::infinity();
+    return 10.0 * std::log10(diff / juce::jmax(ref, 1.0e-30));
+}
+
+void printMode(const char* name, const RenderResult& result, const BenchmarkSettings& settings)
+{
+    const double audioSamples = settings.seconds * settings.sampleRate * settings.numChannels;
+    std::printf("  %-9s %8.4f%% of real time  %8.2f ns/sample\n", name,
+                100.0 * result.cpuSeconds / settings.seconds, 1.0e9 * result.cpuSeconds / audioSamples);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    BenchmarkSettings settings;
+    const auto option = [&args](const char* name, double fallback)
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1].getDoubleValue() : fallback;
+    };
+    settings.sampleRate = option("--rate", settings.sampleRate);
+    settings.numChannels = juce::jmax(1, static_cast<int>(option("--channels", settings.numChannels)));
+    settings.blockSize = juce::jmax(1, static_cast<int>(option("--block", settings.blockSize)));
+    settings.seconds = juce::jmax(0.1, option("--seconds", settings.seconds));
+    settings.runs = juce::jmax(1, static_cast<int>(option("--runs", settings.runs)));
+    for (int i = 0; i + 1 < args.size(); ++i)
+        if (args[i] == "--set")
+            settings.parameterValues.add(args[i + 1]);
+
+    juce::AudioBuffer<float> input(settings.numChannels, static_cast<int>(settings.seconds * settings.sampleRate));
+    fillTestSignal(input, settings.sampleRate);
+
+    const auto realtime = bestOf(false, input, settings);
+    const auto offline = bestOf(true, input, settings);
+
+    std::printf("%s: %.0f Hz, %d ch, %d-sample blocks, %.1f s\n", JucePlugin_Name, settings.sampleRate,
+                settings.numChannels, settings.blockSize, settings.seconds);
+    printMode("realtime", realtime, settings);
+    printMode("offline", offline, settings);
+    std::printf("  offline costs %.2fx realtime, output differs by %.1f dB\n",
+                offline.cpuSeconds / juce::jmax(realtime.cpuSeconds, 1.0e-12),
+                differenceDb(realtime.output, offline.output));
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include <cstdio>
+#include <vector>
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+// Moves every parameter off its default, so loading a state has real work to do.
+void scrambleParameters(juce::AudioProcessor& processor)
+{
+    juce::Random random(0x53544154);
+    for (auto* parameter : processor.getParameters())
+        parameter->setValueNotifyingHost(random.nextFloat());
+}
+
+// The state as builds before the binary format saved it: the parameter tree as XML.
+juce::MemoryBlock legacyXmlState(juce::AudioProcessor& processor)
+{
+    juce::XmlElement xml("PARAMS");
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+        {
+            auto* child = xml.createNewChildElement("PARAM");
+            child->setAttribute("id", ranged->paramID);
+            child->setAttribute("value", ranged->convertFrom0to1(ranged->getValue()));
+        }
+    }
+    juce::MemoryBlock block;
+    juce::AudioProcessor::copyXmlToBinary(xml, block);
+    return block;
+}
+
+// Seconds to load the state into every instance once, best of several passes.
+double timeLoad(std::vector<std::unique_ptr<juce::AudioProcessor>>& instances, const juce::MemoryBlock& state, int runs)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run)
+    {
+        const auto before = juce::Time::getHighResolutionTicks();
+        for (auto& instance : instances)
+            instance->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - before);
+        best = run == 0 ? seconds : juce::jmin(best, seconds);
+    }
+    return best;
+}
+
+double timeSave(std::vector<std::unique_ptr<juce::AudioProcessor>>& instances, int runs)
+{
+    double best = 0.0;
+    juce::MemoryBlock block;
+    for (int run = 0; run < runs; ++run)
+    {
+        const auto before = juce::Time::getHighResolutionTicks();
+        for (auto& instance : instances)
+            instance->getStateInformation(block);
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - before);
+        best = run == 0 ? seconds : juce::jmin(best, seconds);
+    }
+    return best;
+}
+
+void printRow(const char* name, size_t bytes, double seconds, int numInstances)
+{
+    std::printf("  %-11s %6d bytes  %10.3f ms total  %8.2f us/instance\n", name, static_cast<int>(bytes),
+                1.0e3 * seconds, 1.0e6 * seconds / numInstances);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name, int fallback)
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1].getIntValue() : fallback;
+    };
+    const int numInstances = juce::jmax(1, option("--instances", 100));
+    const int runs = juce::jmax(1, option("--runs", 5));
+
+    std::vector<std::unique_ptr<juce::AudioProcessor>> instances;
+    for (int i = 0; i < numInstances; ++i)
+        instances.emplace_back(createPluginFilter());
+
+    auto& source = *instances.front();
+    scrambleParameters(source);
+    juce::MemoryBlock binary;
+    source.getStateInformation(binary);
+    const auto xml = legacyXmlState(source);
+
+    std::printf("%s: %d instances\n", JucePlugin_Name, numInstances);
+    printRow("load xml", xml.getSize(), timeLoad(instances, xml, runs), numInstances);
+    printRow("load binary", binary.getSize(), timeLoad(instances, binary, runs), numInstances);
+    printRow("save binary", binary.getSize(), timeSave(instances, runs), numInstances);
+    return 0;
+}
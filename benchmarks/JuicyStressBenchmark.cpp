@@ -0,0 +1,485 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include "plugins/JuicyChain/PluginProcessor.h"
+#include "plugins/JuicyCohere/PluginProcessor.h"
+#include "plugins/JuicyInfer/PluginProcessor.h"
+#include "plugins/JuicyMotion/PluginProcessor.h"
+#include "plugins/JuicyPunch/PluginProcessor.h"
+#include "plugins/JuicySaturator/PluginProcessor.h"
+#include "plugins/JuicyTexture/PluginProcessor.h"
+#include "plugins/JuicyWidth/PluginProcessor.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <malloc.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+struct ProcessorType
+{
+    const char* key;
+    juce::AudioProcessor* (*create)();
+};
+
+const ProcessorType processorTypes[] = {
+    { "infer", [] () -> juce::AudioProcessor* { return new JuicyInferAudioProcessor(); } },
+    { "punch", [] () -> juce::AudioProcessor* { return new JuicyPunchAudioProcessor(); } },
+    { "saturator", [] () -> juce::AudioProcessor* { return new JuicySaturatorAudioProcessor(); } },
+    { "width", [] () -> juce::AudioProcessor* { return new JuicyWidthAudioProcessor(); } },
+    { "cohere", [] () -> juce::AudioProcessor* { return new JuicyCohereAudioProcessor(); } },
+    { "texture", [] () -> juce::AudioProcessor* { return new JuicyTextureAudioProcessor(); } },
+    { "motion", [] () -> juce::AudioProcessor* { return new JuicyMotionAudioProcessor(); } },
+    { "chain", [] () -> juce::AudioProcessor* { return new JuicyChainAudioProcessor(); } }
+};
+
+struct MixEntry
+{
+    const ProcessorType* type;
+    double weight;
+};
+
+struct StressSettings
+{
+    std::vector<MixEntry> mix;
+    juce::Array<int> instanceCounts { 256 };
+    juce::Array<int> threadCounts { static_cast<int>(juce::jmax(1u, std::thread::hardware_concurrency())) };
+    double sampleRate = 48000.0;
+    int blockSize = 256;
+    int numChannels = 2;
+    double seconds = 5.0;
+    bool offline = false;
+};
+
+// "punch:2,texture:1" or "all"; weights are relative.
+std::vector<MixEntry> parseMix(const juce::String& text)
+{
+    std::vector<MixEntry> mix;
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", ""))
+    {
+        const auto key = token.upToFirstOccurrenceOf(":", false, false).trim().toLowerCase();
+        const auto weight = token.containsChar(':') ? token.fromFirstOccurrenceOf(":", false, false).getDoubleValue() : 1.0;
+        for (const auto& type : processorTypes)
+            if (key == "all" || key == type.key)
+                mix.push_back({ &type, juce::jmax(0.0, weight) });
+    }
+    return mix;
+}
+
+// Spreads count instances over the mix by weight, largest remainders first, then interleaves
+// them so neighbouring graph nodes are of different types, as tracks in a session would be.
+std::vector<const ProcessorType*> assignTypes(const std::vector<MixEntry>& mix, int count)
+{
+    double totalWeight = 0.0;
+    for (const auto& entry : mix)
+        totalWeight += entry.weight;
+
+    std::vector<int> perType(mix.size(), 0);
+    std::vector<std::pair<double, size_t>> remainders;
+    int assigned = 0;
+    for (size_t i = 0; i < mix.size(); ++i)
+    {
+        const double exact = totalWeight > 0.0 ? count * mix[i].weight / totalWeight : 0.0;
+        perType[i] = static_cast<int>(exact);
+        assigned += perType[i];
+        remainders.push_back({ exact - perType[i], i });
+    }
+    std::sort(remainders.begin(), remainders.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; assigned < count && ! remainders.empty(); ++assigned, i = (i + 1) % remainders.size())
+        ++perType[remainders[i].second];
+
+    std::vector<const ProcessorType*> types;
+    for (bool added = true; added;)
+    {
+        added = false;
+        for (size_t i = 0; i < mix.size(); ++i)
+            if (perType[i]-- > 0)
+            {
+                types.push_back(mix[i].type);
+                added = true;
+            }
+    }
+    return types;
+}
+
+// Heap bytes in use (mmapped blocks included, which is where the large state arenas go), or
+// resident memory where the allocator cannot say.
+juce::int64 memoryInUse()
+{
+#if JUCE_LINUX && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const auto info = mallinfo2();
+    return static_cast<juce::int64>(info.uordblks + info.hblkhd);
+#elif JUCE_LINUX
+    long pages = 0, resident = 0;
+    if (auto* file = std::fopen("/proc/self/statm", "r"))
+    {
+        if (std::fscanf(file, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(file);
+    }
+    return static_cast<juce::int64>(resident) * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+// Hardware counters for the calling thread, where perf events are available and permitted.
+class ThreadCounters
+{
+public:
+    enum Counter
+    {
+        cycles,
+        instructions,
+        cacheReferences,
+        cacheMisses,
+        numCounters
+    };
+
+    ThreadCounters()
+    {
+#if JUCE_LINUX
+        const juce::uint64 configs[] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+                                         PERF_COUNT_HW_CACHE_MISSES };
+        for (int i = 0; i < numCounters; ++i)
+        {
+            perf_event_attr attr {};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~ThreadCounters()
+    {
+#if JUCE_LINUX
+        for (const int fd : fds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    void start()
+    {
+#if JUCE_LINUX
+        for (const int fd : fds)
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+    }
+
+    // -1 for counters that could not be opened.
+    std::array<juce::int64, numCounters> stop()
+    {
+        std::array<juce::int64, numCounters> values;
+        values.fill(-1);
+#if JUCE_LINUX
+        for (int i = 0; i < numCounters; ++i)
+        {
+            juce::uint64 value = 0;
+            if (fds[i] >= 0 && ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0) == 0 && read(fds[i], &value, sizeof(value)) == sizeof(value))
+                values[static_cast<size_t>(i)] = static_cast<juce::int64>(value);
+        }
+#endif
+        return values;
+    }
+
+private:
+    std::array<int, numCounters> fds { { -1, -1, -1, -1 } };
+};
+
+// Drum-like bursts over a low tone, one second long; each instance reads it from its own offset.
+juce::AudioBuffer<float> makeInput(int numChannels, double sampleRate)
+{
+    juce::AudioBuffer<float> input(numChannels, static_cast<int>(sampleRate));
+    juce::Random random(0x53545253);
+    const auto burstLength = static_cast<int>(sampleRate * 0.25);
+    for (int i = 0; i < input.getNumSamples(); ++i)
+    {
+        const float env = std::exp(-static_cast<float>(i % burstLength) / static_cast<float>(sampleRate * 0.03));
+        const auto t = static_cast<float>(i / sampleRate);
+        for (int ch = 0; ch < numChannels; ++ch)
+            input.setSample(ch, i, 0.6f * env * (2.0f * random.nextFloat() - 1.0f)
+                                       + 0.2f * std::sin(juce::MathConstants<float>::twoPi * 110.0f * t));
+    }
+    return input;
+}
+
+struct Node
+{
+    std::unique_ptr<juce::AudioProcessor> processor;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    int readPosition = 0;
+};
+
+double percentile(std::vector<double>& values, double p)
+{
+    if (values.empty())
+        return 0.0;
+    const auto index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+// Imitates a host's parallel graph: every cycle (one block period) each node processes one
+// block, workers pull nodes from a shared counter, and the cycle ends when the last node is
+// done. The cycles run back to back rather than paced, so throughput shows the headroom.
+juce::var runCase(const StressSettings& settings, int numInstances, int numThreads, const juce::AudioBuffer<float>& input)
+{
+    const auto types = assignTypes(settings.mix, numInstances);
+    std::vector<Node> nodes(types.size());
+    std::map<juce::String, std::pair<juce::int64, int>> memoryPerType;
+
+    // One throwaway instance per type first, so process-wide one-offs (the shared worker pool,
+    // JUCE's statics) are not charged to whichever instance happens to come first.
+    for (const auto& entry : settings.mix)
+    {
+        std::unique_ptr<juce::AudioProcessor> warmUp(entry.type->create());
+        warmUp->setPlayConfigDetails(settings.numChannels, settings.numChannels, settings.sampleRate, settings.blockSize);
+        warmUp->prepareToPlay(settings.sampleRate, settings.blockSize);
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const auto before = memoryInUse();
+        auto& node = nodes[i];
+        node.processor.reset(types[i]->create());
+        node.processor->setPlayConfigDetails(settings.numChannels, settings.numChannels, settings.sampleRate, settings.blockSize);
+        node.processor->setNonRealtime(settings.offline);
+        node.processor->prepareToPlay(settings.sampleRate, settings.blockSize);
+        node.buffer.setSize(settings.numChannels, settings.blockSize);
+        node.readPosition = static_cast<int>((i * 7919) % static_cast<size_t>(input.getNumSamples()));
+        auto& memory = memoryPerType[types[i]->key];
+        memory.first += memoryInUse() - before;
+        ++memory.second;
+    }
+
+    const auto numCycles = juce::jmax(1, static_cast<int>(settings.seconds * settings.sampleRate / settings.blockSize));
+    const double ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+    const double deadline = settings.blockSize / settings.sampleRate;
+
+    // Tickets run on across cycles (cycle c owns tickets c * N to c * N + N - 1), so a worker
+    // still leaving one cycle can never take a node of the next.
+    const auto numNodes = static_cast<juce::int64>(nodes.size());
+    std::atomic<int> cycleStarted { 0 };
+    std::atomic<juce::int64> nextTicket { 0 };
+    std::atomic<juce::int64> ticketsDone { 0 };
+    std::vector<std::vector<double>> blockSeconds(static_cast<size_t>(numThreads));
+    std::vector<std::array<juce::int64, ThreadCounters::numCounters>> counters(static_cast<size_t>(numThreads));
+    std::vector<double> cycleSeconds;
+    cycleSeconds.reserve(static_cast<size_t>(numCycles));
+
+    const auto work = [&](int thread, int cycle)
+    {
+        auto& times = blockSeconds[static_cast<size_t>(thread)];
+        const auto cycleEnd = (cycle + 1) * numNodes;
+        for (;;)
+        {
+            auto ticket = nextTicket.load();
+            do
+            {
+                if (ticket >= cycleEnd)
+                    return;
+            } while (! nextTicket.compare_exchange_weak(ticket, ticket + 1));
+
+            auto& node = nodes[static_cast<size_t>(ticket - cycle * numNodes)];
+            const int start = (node.readPosition + cycle * settings.blockSize) % (input.getNumSamples() - settings.blockSize);
+            for (int ch = 0; ch < settings.numChannels; ++ch)
+                node.buffer.copyFrom(ch, 0, input, ch, start, settings.blockSize);
+
+            const auto before = juce::Time::getHighResolutionTicks();
+            node.processor->processBlock(node.buffer, node.midi);
+            times.push_back(static_cast<double>(juce::Time::getHighResolutionTicks() - before) / ticksPerSecond);
+            ticketsDone.fetch_add(1, std::memory_order_acq_rel);
+        }
+    };
+
+    const auto workerLoop = [&](int thread)
+    {
+        blockSeconds[static_cast<size_t>(thread)].reserve(static_cast<size_t>(numCycles) * nodes.size() / static_cast<size_t>(numThreads) + nodes.size());
+        ThreadCounters threadCounters;
+        threadCounters.start();
+        for (int cycle = 0; cycle < numCycles; ++cycle)
+        {
+            while (cycleStarted.load(std::memory_order_acquire) <= cycle)
+                std::this_thread::yield();
+            work(thread, cycle);
+        }
+        counters[static_cast<size_t>(thread)] = threadCounters.stop();
+    };
+
+    std::vector<std::thread> workers;
+    for (int thread = 1; thread < numThreads; ++thread)
+        workers.emplace_back(workerLoop, thread);
+
+    // The calling thread is worker 0 and also starts and closes every cycle.
+    blockSeconds[0].reserve(static_cast<size_t>(numCycles) * nodes.size() / static_cast<size_t>(numThreads) + nodes.size());
+    ThreadCounters mainCounters;
+    mainCounters.start();
+    const auto runStart = juce::Time::getHighResolutionTicks();
+    for (int cycle = 0; cycle < numCycles; ++cycle)
+    {
+        const auto cycleStart = juce::Time::getHighResolutionTicks();
+        cycleStarted.store(cycle + 1, std::memory_order_release);
+        work(0, cycle);
+        while (ticketsDone.load(std::memory_order_acquire) < (cycle + 1) * numNodes)
+            std::this_thread::yield();
+        cycleSeconds.push_back(static_cast<double>(juce::Time::getHighResolutionTicks() - cycleStart) / ticksPerSecond);
+    }
+    const double wallSeconds = static_cast<double>(juce::Time::getHighResolutionTicks() - runStart) / ticksPerSecond;
+    counters[0] = mainCounters.stop();
+    for (auto& worker : workers)
+        worker.join();
+
+    std::vector<double> allBlocks;
+    for (auto& times : blockSeconds)
+        allBlocks.insert(allBlocks.end(), times.begin(), times.end());
+
+    const auto overruns = std::count_if(cycleSeconds.begin(), cycleSeconds.end(), [deadline](double s) { return s > deadline; });
+    int degraded = 0;
+    for (auto& node : nodes)
+        for (auto* parameter : node.processor->getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == "qualitytier")
+                degraded += ranged->convertFrom0to1(ranged->getValue()) > 0.5f ? 1 : 0;
+
+    auto* blockLatency = new juce::DynamicObject();
+    blockLatency->setProperty("p50Us", 1.0e6 * percentile(allBlocks, 0.5));
+    blockLatency->setProperty("p99Us", 1.0e6 * percentile(allBlocks, 0.99));
+    blockLatency->setProperty("p999Us", 1.0e6 * percentile(allBlocks, 0.999));
+    blockLatency->setProperty("maxUs", 1.0e6 * percentile(allBlocks, 1.0));
+
+    auto* cycleLatency = new juce::DynamicObject();
+    cycleLatency->setProperty("deadlineUs", 1.0e6 * deadline);
+    cycleLatency->setProperty("p50Us", 1.0e6 * percentile(cycleSeconds, 0.5));
+    cycleLatency->setProperty("p99Us", 1.0e6 * percentile(cycleSeconds, 0.99));
+    cycleLatency->setProperty("maxUs", 1.0e6 * percentile(cycleSeconds, 1.0));
+    cycleLatency->setProperty("overruns", static_cast<int>(overruns));
+
+    // Summed over all threads; a counter the kernel refused is left out.
+    auto* hardware = new juce::DynamicObject();
+    static const char* const counterNames[] = { "cycles", "instructions", "cacheReferences", "cacheMisses" };
+    for (int i = 0; i < ThreadCounters::numCounters; ++i)
+    {
+        juce::int64 total = 0;
+        bool available = true;
+        for (const auto& threadCounters : counters)
+        {
+            available = available && threadCounters[static_cast<size_t>(i)] >= 0;
+            total += threadCounters[static_cast<size_t>(i)];
+        }
+        if (available)
+            hardware->setProperty(counterNames[i], total);
+    }
+
+    auto* memory = new juce::DynamicObject();
+    for (const auto& [key, bytesAndCount] : memoryPerType)
+        memory->setProperty(key, static_cast<double>(bytesAndCount.first) / juce::jmax(1, bytesAndCount.second));
+
+    const double audioSeconds = numCycles * deadline;
+    auto* result = new juce::DynamicObject();
+    result->setProperty("instances", static_cast<int>(nodes.size()));
+    result->setProperty("threads", numThreads);
+    result->setProperty("cycles", numCycles);
+    result->setProperty("realtimeFactor", audioSeconds / juce::jmax(wallSeconds, 1.0e-12));
+    result->setProperty("instanceBlocksPerSecond", static_cast<double>(allBlocks.size()) / juce::jmax(wallSeconds, 1.0e-12));
+    result->setProperty("blockLatency", juce::var(blockLatency));
+    result->setProperty("cycleLatency", juce::var(cycleLatency));
+    result->setProperty("hardwareCounters", juce::var(hardware));
+    result->setProperty("bytesPerInstance", juce::var(memory));
+    result->setProperty("degradedInstances", degraded);
+
+    std::fprintf(stderr, "%4d instances on %2d threads: %.2fx realtime, block p99 %.1f us, %d/%d cycles over deadline\n",
+                 static_cast<int>(nodes.size()), numThreads, audioSeconds / juce::jmax(wallSeconds, 1.0e-12),
+                 1.0e6 * percentile(allBlocks, 0.99), static_cast<int>(overruns), numCycles);
+    return juce::var(result);
+}
+
+juce::Array<int> parseCounts(const juce::String& text, const juce::Array<int>& fallback)
+{
+    if (text.isEmpty())
+        return fallback;
+    juce::Array<int> values;
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", ""))
+        values.add(juce::jmax(1, token.getIntValue()));
+    return values;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name) -> juce::String
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    StressSettings settings;
+    settings.mix = parseMix(option("--mix").isNotEmpty() ? option("--mix") : juce::String("all"));
+    settings.instanceCounts = parseCounts(option("--instances"), settings.instanceCounts);
+    settings.threadCounts = parseCounts(option("--threads"), settings.threadCounts);
+    if (option("--rate").isNotEmpty())
+        settings.sampleRate = juce::jmax(8000.0, option("--rate").getDoubleValue());
+    if (option("--block").isNotEmpty())
+        settings.blockSize = juce::jlimit(16, 4096, option("--block").getIntValue());
+    if (option("--channels").isNotEmpty())
+        settings.numChannels = juce::jmax(1, option("--channels").getIntValue());
+    if (option("--seconds").isNotEmpty())
+        settings.seconds = juce::jmax(0.1, option("--seconds").getDoubleValue());
+    settings.offline = args.contains("--offline");
+
+    if (settings.mix.empty())
+    {
+        std::fprintf(stderr, "--mix names none of: all, infer, punch, saturator, width, cohere, texture, motion, chain\n");
+        return 1;
+    }
+
+    const auto input = makeInput(settings.numChannels, settings.sampleRate);
+    juce::Array<juce::var> cases;
+    for (const int numInstances : settings.instanceCounts)
+        for (const int numThreads : settings.threadCounts)
+            cases.add(runCase(settings, numInstances, numThreads, input));
+
+    juce::StringArray mixText;
+    for (const auto& entry : settings.mix)
+        mixText.add(juce::String(entry.type->key) + ":" + juce::String(entry.weight));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("mix", mixText.joinIntoString(","));
+    report->setProperty("sampleRate", settings.sampleRate);
+    report->setProperty("blockSize", settings.blockSize);
+    report->setProperty("channels", settings.numChannels);
+    report->setProperty("offline", settings.offline);
+    report->setProperty("cases", cases);
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    const auto outputPath = option("--output");
+    if (outputPath.isNotEmpty())
+        return juce::File::getCurrentWorkingDirectory().getChildFile(outputPath).replaceWithText(json) ? 0 : 1;
+
+    std::printf("%s\n", json.toRawUTF8());
+    return 0;
+}
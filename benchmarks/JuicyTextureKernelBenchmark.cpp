@@ -0,0 +1,267 @@
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include "plugins/JuicyTexture/JuicyTextureKernel.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Times JuicyTextureKernel::process on its own, without the processor's analyzers, bypass or
+// governor, for every material at every quality tier. The tiers differ in how many modal
+// resonators run, so this is where changes to the material loops show up first.
+namespace
+{
+constexpr const char* materialNames[] = { "gel", "metal", "wood", "plastic", "flesh" };
+
+struct Tier
+{
+    const char* name;
+    bool reducedDsp;
+    bool offlineQuality;
+};
+
+constexpr Tier tiers[] = { { "reduced", true, false }, { "realtime", false, false }, { "offline", false, true } };
+
+struct BenchmarkSettings
+{
+    juce::StringArray signals { "drums", "pads", "noise" };
+    juce::Array<double> sampleRates { 48000.0 };
+    juce::Array<int> blockSizes { 64, 512 };
+    juce::Array<int> channelCounts { 2 };
+    double seconds = 2.0;
+    int runs = 3;
+};
+
+// Per-block cost in ns per sample (all channels), summarised.
+struct Timing
+{
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+Timing summarise(std::vector<double>& nsPerSample, double totalNs, double totalSamples)
+{
+    Timing timing;
+    if (nsPerSample.empty())
+        return timing;
+
+    std::sort(nsPerSample.begin(), nsPerSample.end());
+    const auto percentile = [&nsPerSample](double p)
+    {
+        const auto index = static_cast<size_t>(p * static_cast<double>(nsPerSample.size() - 1) + 0.5);
+        return nsPerSample[index];
+    };
+    timing.mean = totalNs / juce::jmax(1.0, totalSamples);
+    timing.p50 = percentile(0.5);
+    timing.p99 = percentile(0.99);
+    timing.max = nsPerSample.back();
+    return timing;
+}
+
+void fillSignal(juce::AudioBuffer<float>& buffer, const juce::String& signal, double sampleRate)
+{
+    buffer.clear();
+    juce::Random random(0x54455854);
+    const auto sr = static_cast<float>(sampleRate);
+
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        const float t = static_cast<float>(i) / sr;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            float x = 0.0f;
+            if (signal == "drums")
+            {
+                // Kick on every beat at 120 bpm, hat on the off-beats: the strikes that bend metal.
+                const float beat = std::fmod(t, 0.5f);
+                const float offBeat = std::fmod(t + 0.25f, 0.5f);
+                const float kick = std::sin(juce::MathConstants<float>::twoPi * (50.0f + 120.0f * std::exp(-beat * 40.0f)) * beat)
+                                 * std::exp(-beat * 12.0f);
+                const float hat = (2.0f * random.nextFloat() - 1.0f) * std::exp(-offBeat * 90.0f);
+                x = 0.8f * kick + 0.35f * hat;
+            }
+            else if (signal == "pads")
+            {
+                const float swell = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * 0.25f * t);
+                const float detune = 1.0f + 0.002f * static_cast<float>(ch);
+                for (const float hz : { 220.0f, 277.18f, 329.63f })
+                    x += std::sin(juce::MathConstants<float>::twoPi * hz * detune * t);
+                x *= 0.18f * swell;
+            }
+            else if (signal == "noise")
+            {
+                x = 0.5f * (2.0f * random.nextFloat() - 1.0f);
+            }
+            buffer.setSample(ch, i, x);
+        }
+    }
+}
+
+juce::var runCase(const juce::AudioBuffer<float>& input, const juce::String& signal, int material, const Tier& tier,
+                  double sampleRate, int blockSize, int runs)
+{
+    const int numChannels = input.getNumChannels();
+    std::vector<double> times;
+    double totalNs = 0.0, totalSamples = 0.0;
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+
+    JuicyTextureParameters params;
+    params.material = material;
+    JuicyKernelContext context;
+    context.reducedDsp = tier.reducedDsp;
+    context.offlineQuality = tier.offlineQuality;
+
+    for (int run = 0; run < runs; ++run)
+    {
+        JuicyTextureKernel kernel;
+        kernel.prepare(sampleRate, juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+        for (int start = 0; start < input.getNumSamples(); start += blockSize)
+        {
+            const int num = juce::jmin(blockSize, input.getNumSamples() - start);
+            block.setSize(numChannels, num, false, false, true);
+            for (int ch = 0; ch < numChannels; ++ch)
+                block.copyFrom(ch, 0, input, ch, start, num);
+            context.samplePosition = start;
+
+            const auto before = juce::Time::getHighResolutionTicks();
+            kernel.process(block, params, context);
+            const double ns = 1.0e9 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - before);
+            times.push_back(ns / (static_cast<double>(num) * numChannels));
+            totalNs += ns;
+            totalSamples += static_cast<double>(num) * numChannels;
+        }
+    }
+
+    const auto timing = summarise(times, totalNs, totalSamples);
+    std::fprintf(stderr, "%s %s %s %.0f Hz %d ch %d samples: %.2f ns/sample\n", signal.toRawUTF8(), materialNames[material],
+                 tier.name, sampleRate, numChannels, blockSize, timing.mean);
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("signal", signal);
+    result->setProperty("material", materialNames[material]);
+    result->setProperty("tier", tier.name);
+    result->setProperty("sampleRate", sampleRate);
+    result->setProperty("blockSize", blockSize);
+    result->setProperty("channels", numChannels);
+    result->setProperty("meanNsPerSample", timing.mean);
+    result->setProperty("p50NsPerSample", timing.p50);
+    result->setProperty("p99NsPerSample", timing.p99);
+    result->setProperty("maxNsPerSample", timing.max);
+    return juce::var(result);
+}
+
+// Adds the matching case of an earlier report (same signal, material, tier, rate, block size
+// and channel count) to each case, so two builds or two state layouts can be compared row by row.
+void compareWithBaseline(juce::Array<juce::var>& cases, const juce::var& baseline)
+{
+    const auto* baselineCases = baseline.getProperty("cases", {}).getArray();
+    if (baselineCases == nullptr)
+        return;
+
+    const char* keys[] = { "signal", "material", "tier", "sampleRate", "blockSize", "channels" };
+    for (auto& result : cases)
+    {
+        for (const auto& earlier : *baselineCases)
+        {
+            if (! std::all_of(std::begin(keys), std::end(keys), [&](const char* key)
+                              { return result.getProperty(key, {}) == earlier.getProperty(key, {}); }))
+                continue;
+
+            const double mean = result.getProperty("meanNsPerSample", 0.0);
+            const double baselineMean = earlier.getProperty("meanNsPerSample", 0.0);
+            if (auto* object = result.getDynamicObject())
+            {
+                object->setProperty("baselineMeanNsPerSample", baselineMean);
+                object->setProperty("speedup", mean > 0.0 ? baselineMean / mean : 0.0);
+            }
+            std::fprintf(stderr, "%s %s %s %d samples: %.2f -> %.2f ns/sample (%.2fx)\n",
+                         result.getProperty("signal", {}).toString().toRawUTF8(),
+                         result.getProperty("material", {}).toString().toRawUTF8(),
+                         result.getProperty("tier", {}).toString().toRawUTF8(),
+                         static_cast<int>(result.getProperty("blockSize", 0)), baselineMean, mean,
+                         mean > 0.0 ? baselineMean / mean : 0.0);
+            break;
+        }
+    }
+}
+
+template <typename T>
+juce::Array<T> parseList(const juce::String& text, const juce::Array<T>& fallback)
+{
+    if (text.isEmpty())
+        return fallback;
+    juce::Array<T> values;
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", ""))
+        values.add(static_cast<T>(token.getDoubleValue()));
+    return values;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name) -> juce::String
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    BenchmarkSettings settings;
+    if (option("--signals").isNotEmpty())
+        settings.signals = juce::StringArray::fromTokens(option("--signals"), ",", "");
+    settings.sampleRates = parseList(option("--rates"), settings.sampleRates);
+    settings.blockSizes = parseList(option("--blocks"), settings.blockSizes);
+    settings.channelCounts = parseList(option("--channels"), settings.channelCounts);
+    if (option("--seconds").isNotEmpty())
+        settings.seconds = juce::jmax(0.05, option("--seconds").getDoubleValue());
+    if (option("--runs").isNotEmpty())
+        settings.runs = juce::jmax(1, option("--runs").getIntValue());
+    const auto materialFilter = option("--material");
+
+    juce::Array<juce::var> cases;
+    for (const int numChannels : settings.channelCounts)
+    {
+        for (const double sampleRate : settings.sampleRates)
+        {
+            for (const auto& signal : settings.signals)
+            {
+                juce::AudioBuffer<float> input(juce::jmax(1, numChannels), static_cast<int>(settings.seconds * sampleRate));
+                fillSignal(input, signal, sampleRate);
+
+                for (const int blockSize : settings.blockSizes)
+                {
+                    for (int material = 0; material < static_cast<int>(std::size(materialNames)); ++material)
+                    {
+                        if (materialFilter.isNotEmpty() && materialFilter != materialNames[material])
+                            continue;
+                        for (const auto& tier : tiers)
+                            cases.add(runCase(input, signal, material, tier, sampleRate, juce::jmax(1, blockSize), settings.runs));
+                    }
+                }
+            }
+        }
+    }
+
+    const auto baselinePath = option("--baseline");
+    if (baselinePath.isNotEmpty())
+        compareWithBaseline(cases, juce::JSON::parse(juce::File::getCurrentWorkingDirectory().getChildFile(baselinePath)));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("kernel", "JuicyTextureKernel");
+    report->setProperty("secondsPerCase", settings.seconds);
+    report->setProperty("runs", settings.runs);
+    report->setProperty("cases", cases);
+    const auto json = juce::JSON::toString(juce::var(report));
+
+    const auto outputPath = option("--output");
+    if (outputPath.isNotEmpty())
+        return juce::File::getCurrentWorkingDirectory().getChildFile(outputPath).replaceWithText(json) ? 0 : 1;
+
+    std::printf("%s\n", json.toRawUTF8());
+    return 0;
+}
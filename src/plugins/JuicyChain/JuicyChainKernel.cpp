@@ -0,0 +1,262 @@
+#include "JuicyChainKernel.h"
+#include "../../shared/JuicySubBlocks.h"
+#include <algorithm>
+#include <limits>
+
+void JuicyChainKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    punch.prepare(sampleRate, layout);
+    saturator.prepare(sampleRate, layout);
+    texture.prepare(sampleRate, layout);
+    width.prepare(sampleRate, layout);
+    cohere.prepare(sampleRate, layout);
+
+    // One sub-block per channel, each starting on its own cache line.
+    numChannels = layout.size();
+    arena.beginLayout();
+    sliceSlot = arena.reserveHot<float>(static_cast<size_t>(juce::jmax(1, numChannels) * juicySubBlockSize));
+    textureDelaySlot = arena.reserveCold<float>(static_cast<size_t>(juce::jmax(1, numChannels) * texture.getLatencySamples()));
+    arena.allocate();
+    textureDelayPosition = 0;
+
+    // The slice refers to the scratch for good: past 32 channels AudioBuffer keeps its channel
+    // pointers on the heap, so pointing it anew per sub-block would allocate.
+    sliceChannels.assign(static_cast<size_t>(juce::jmax(1, numChannels)), nullptr);
+    if (auto* scratch = arena.get(sliceSlot))
+    {
+        for (size_t ch = 0; ch < sliceChannels.size(); ++ch)
+            sliceChannels[ch] = scratch + ch * static_cast<size_t>(juicySubBlockSize);
+        slice.setDataToReferTo(sliceChannels.data(), static_cast<int>(sliceChannels.size()), juicySubBlockSize);
+    }
+    wasEnabled.fill(true);
+    idleDetector.reset();
+}
+
+void JuicyChainKernel::reset() noexcept
+{
+    resetStages();
+    idleDetector.reset();
+}
+
+void JuicyChainKernel::resetStages() noexcept
+{
+    punch.reset();
+    saturator.reset();
+    texture.reset();
+    width.reset();
+    cohere.reset();
+    arena.fill(textureDelaySlot, 0.0f);
+    textureDelayPosition = 0;
+}
+
+std::array<int, juicyChainNumStages> JuicyChainKernel::resolveOrder(const std::array<int, juicyChainNumStages>& order) noexcept
+{
+    std::array<int, juicyChainNumStages> resolved {};
+    std::array<bool, juicyChainNumStages> used {};
+    int numResolved = 0;
+    for (const int stage : order)
+    {
+        if (stage < 0 || stage >= juicyChainNumStages || used[static_cast<size_t>(stage)])
+            continue;
+        used[static_cast<size_t>(stage)] = true;
+        resolved[static_cast<size_t>(numResolved++)] = stage;
+    }
+    for (int stage = 0; stage < juicyChainNumStages; ++stage)
+        if (! used[static_cast<size_t>(stage)])
+            resolved[static_cast<size_t>(numResolved++)] = stage;
+    return resolved;
+}
+
+double JuicyChainKernel::getTailLengthSeconds(const JuicyChainParameters& params) const
+{
+    const auto& on = params.enabled;
+    double seconds = 0.0;
+    if (on[static_cast<size_t>(JuicyChainStage::punch)])
+        seconds += punch.getTailLengthSeconds(params.punch);
+    if (on[static_cast<size_t>(JuicyChainStage::saturator)])
+        seconds += saturator.getTailLengthSeconds(params.saturator);
+    if (on[static_cast<size_t>(JuicyChainStage::texture)])
+        seconds += texture.getTailLengthSeconds(params.texture);
+    if (on[static_cast<size_t>(JuicyChainStage::width)])
+        seconds += width.getTailLengthSeconds(params.width);
+    if (on[static_cast<size_t>(JuicyChainStage::cohere)])
+        seconds += cohere.getTailLengthSeconds(params.cohere);
+    return seconds;
+}
+
+void JuicyChainKernel::beginStage(int stage, const JuicyChainParameters& params, const JuicyKernelContext& context, int numSamples) noexcept
+{
+    switch (static_cast<JuicyChainStage>(stage))
+    {
+        case JuicyChainStage::punch:     punch.beginBlock(params.punch, context, numSamples); break;
+        case JuicyChainStage::saturator: saturator.beginBlock(params.saturator, context, numSamples); break;
+        case JuicyChainStage::texture:   texture.beginBlock(params.texture, context, numSamples); break;
+        case JuicyChainStage::width:     width.beginBlock(params.width, context, numSamples); break;
+        case JuicyChainStage::cohere:    cohere.beginBlock(params.cohere, context, numSamples); break;
+    }
+}
+
+void JuicyChainKernel::renderStage(int stage, int numSamples, const JuicyKernelContext& context) noexcept
+{
+    switch (static_cast<JuicyChainStage>(stage))
+    {
+        case JuicyChainStage::punch:     punch.render(slice, 0, numSamples, context); break;
+        case JuicyChainStage::saturator: saturator.render(slice, 0, numSamples, context); break;
+        case JuicyChainStage::texture:   texture.render(slice, 0, numSamples, context); break;
+        case JuicyChainStage::width:     width.render(slice, 0, numSamples, context); break;
+        case JuicyChainStage::cohere:    cohere.render(slice, 0, numSamples, context); break;
+    }
+}
+
+bool JuicyChainKernel::isStateSilent(const JuicyChainParameters& params) const noexcept
+{
+    const auto& on = params.enabled;
+    if (on[static_cast<size_t>(JuicyChainStage::punch)] && ! punch.isStateSilent())
+        return false;
+    if (on[static_cast<size_t>(JuicyChainStage::saturator)] && ! saturator.isStateSilent())
+        return false;
+    if (on[static_cast<size_t>(JuicyChainStage::width)] && ! width.isStateSilent())
+        return false;
+    if (on[static_cast<size_t>(JuicyChainStage::cohere)] && ! cohere.isStateSilent())
+        return false;
+    if (on[static_cast<size_t>(JuicyChainStage::texture)])
+        return texture.isStateSilent();
+
+    const auto* line = arena.get(textureDelaySlot);
+    return line == nullptr || isJuicyStateSilent(line, numChannels * texture.getLatencySamples());
+}
+
+void JuicyChainKernel::delayForTexture(int numSamples) noexcept
+{
+    auto* line = arena.get(textureDelaySlot);
+    const int length = texture.getLatencySamples();
+    if (line == nullptr || length <= 0)
+        return;
+
+    for (int ch = 0; ch < slice.getNumChannels(); ++ch)
+    {
+        auto* x = slice.getWritePointer(ch);
+        auto* channelLine = line + ch * length;
+        int pos = textureDelayPosition;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float delayed = channelLine[pos];
+            channelLine[pos] = x[i];
+            x[i] = delayed;
+            pos = pos + 1 < length ? pos + 1 : 0;
+        }
+    }
+    textureDelayPosition = (textureDelayPosition + numSamples) % length;
+}
+
+// The delay standing in for Texture and Texture's limiter trade the samples still in flight, so
+// switching the stage neither drops nor repeats a lookahead's worth of output.
+void JuicyChainKernel::switchTexture(bool on) noexcept
+{
+    auto* line = arena.get(textureDelaySlot);
+    const int length = texture.getLatencySamples();
+    if (line == nullptr || length <= 0)
+    {
+        if (on)
+            texture.reset();
+        return;
+    }
+
+    if (on)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::rotate(line + ch * length, line + ch * length + textureDelayPosition, line + (ch + 1) * length);
+        texture.resetWithPendingOutput(line, numChannels);
+    }
+    else
+    {
+        texture.readPendingOutput(line, numChannels);
+    }
+    textureDelayPosition = 0;
+}
+
+bool JuicyChainKernel::process(juce::AudioBuffer<float>& buffer, const JuicyChainParameters& params, const JuicyKernelContext& context,
+                               JuicinessAnalyzer* stageAnalyzers) noexcept
+{
+    const auto order = resolveOrder(params.order);
+
+    // A stage switched back on starts from rest rather than from whatever it held when it
+    // was switched off; Texture takes over its bypass delay's pending output as well.
+    for (int stage = 0; stage < juicyChainNumStages; ++stage)
+    {
+        const bool on = params.enabled[static_cast<size_t>(stage)];
+        if (stage == static_cast<int>(JuicyChainStage::texture) && on != wasEnabled[static_cast<size_t>(stage)])
+        {
+            switchTexture(on);
+        }
+        else if (on && ! wasEnabled[static_cast<size_t>(stage)])
+        {
+            switch (static_cast<JuicyChainStage>(stage))
+            {
+                case JuicyChainStage::punch:     punch.reset(); break;
+                case JuicyChainStage::saturator: saturator.reset(); break;
+                case JuicyChainStage::texture:   break;
+                case JuicyChainStage::width:     width.reset(); break;
+                case JuicyChainStage::cohere:    cohere.reset(); break;
+            }
+        }
+        wasEnabled[static_cast<size_t>(stage)] = on;
+    }
+
+    const int channels = juce::jmin(buffer.getNumChannels(), numChannels);
+    if (channels <= 0 || slice.getNumChannels() == 0)
+        return true;
+
+    // Each stage's input is the previous stage's output, which only exists slice by slice, so
+    // the stages cannot idle on their own; the chain idles as a whole once its input is silent
+    // and every stage has rung out. Offline renders wait for the state, as Texture does.
+    const int numSamples = buffer.getNumSamples();
+    const double maxSilentSeconds = context.offlineQuality ? std::numeric_limits<double>::infinity()
+                                                           : getTailLengthSeconds(params);
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, channels), numSamples, maxSilentSeconds, sr,
+                                          [&] { return isStateSilent(params); });
+    if (idle)
+    {
+        if (idleDetector.hasJustEntered())
+            resetStages();
+        buffer.clear();
+        return false;
+    }
+
+    // Stages never touch the chain analyzers; each sees at most its own.
+    JuicyKernelContext stageContext = context;
+    stageContext.preAnalyzer = nullptr;
+    stageContext.postAnalyzer = nullptr;
+
+    for (const int stage : order)
+        if (params.enabled[static_cast<size_t>(stage)])
+            beginStage(stage, params, stageContext, numSamples);
+
+    forEachJuicySubBlock(numSamples, [&](int start, int num)
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            juce::FloatVectorOperations::copy(sliceChannels[static_cast<size_t>(ch)], buffer.getReadPointer(ch, start), num);
+        for (int ch = channels; ch < slice.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::clear(sliceChannels[static_cast<size_t>(ch)], num);
+        stageContext.samplePosition = context.samplePosition + start;
+
+        context.analyseInput(slice, 0, num);
+        for (const int stage : order)
+        {
+            if (! params.enabled[static_cast<size_t>(stage)])
+            {
+                if (stage == static_cast<int>(JuicyChainStage::texture))
+                    delayForTexture(num);
+                continue;
+            }
+            stageContext.postAnalyzer = stageAnalyzers != nullptr ? stageAnalyzers + stage : nullptr;
+            renderStage(stage, num, stageContext);
+        }
+        context.analyseOutput(slice, 0, num);
+
+        for (int ch = 0; ch < channels; ++ch)
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(ch, start), sliceChannels[static_cast<size_t>(ch)], num);
+    });
+    return true;
+}
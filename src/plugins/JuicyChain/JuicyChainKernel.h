@@ -0,0 +1,95 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <vector>
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyStateArena.h"
+#include "../JuicyCohere/JuicyCohereKernel.h"
+#include "../JuicyPunch/JuicyPunchKernel.h"
+#include "../JuicySaturator/JuicySaturatorKernel.h"
+#include "../JuicyTexture/JuicyTextureKernel.h"
+#include "../JuicyWidth/JuicyWidthKernel.h"
+
+// Stage indices, in the default insert order.
+enum class JuicyChainStage
+{
+    punch,
+    saturator,
+    texture,
+    width,
+    cohere
+};
+
+constexpr int juicyChainNumStages = 5;
+
+struct JuicyChainParameters
+{
+    std::array<int, juicyChainNumStages> order { 0, 1, 2, 3, 4 };               // stage run in each slot
+    std::array<bool, juicyChainNumStages> enabled { true, true, true, true, true }; // indexed by stage
+    JuicyPunchParameters punch;
+    JuicySaturatorParameters saturator;
+    JuicyTextureParameters texture;
+    JuicyWidthParameters width;
+    JuicyCohereParameters cohere;
+};
+
+// The Punch, Saturator, Texture, Width and Cohere kernels as one reorderable serial chain.
+// Each stage maps its parameters once per host block (beginBlock); every sub-block is then
+// copied once into a shared, cache-resident scratch buffer, rendered through all enabled
+// stages back to back and copied out again. Idling is decided for the whole chain per host
+// block, from the chain input and every stage's state. The context's analyzers see the chain
+// input and output only; per-stage analysis is opt-in through process()'s stageAnalyzers.
+class JuicyChainKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // stageAnalyzers, when given, points at juicyChainNumStages analyzers (indexed by stage)
+    // that the caller has begun; each is fed with its stage's output. Returns false when the
+    // block took the idle path; no analyzer was fed then.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyChainParameters& params, const JuicyKernelContext& context,
+                 JuicinessAnalyzer* stageAnalyzers = nullptr) noexcept;
+
+    // Stages run in series, so their tails add up.
+    double getTailLengthSeconds(const JuicyChainParameters& params) const;
+
+    // Sum of the stages' latencies. It does not change when a stage is switched off: a bypassed
+    // stage with latency is replaced by a plain delay of the same length.
+    int getLatencySamples() const noexcept { return texture.getLatencySamples(); }
+
+    // Duplicate slots keep their first occurrence; stages left out are appended in default order.
+    static std::array<int, juicyChainNumStages> resolveOrder(const std::array<int, juicyChainNumStages>& order) noexcept;
+
+    JuicyCohereKernel& getCohereKernel() noexcept { return cohere; }
+    const JuicyCohereKernel& getCohereKernel() const noexcept { return cohere; }
+    JuicyTextureKernel& getTextureKernel() noexcept { return texture; }
+    const JuicyTextureKernel& getTextureKernel() const noexcept { return texture; }
+
+private:
+    void beginStage(int stage, const JuicyChainParameters& params, const JuicyKernelContext& context, int numSamples) noexcept;
+    void renderStage(int stage, int numSamples, const JuicyKernelContext& context) noexcept;
+    bool isStateSilent(const JuicyChainParameters& params) const noexcept;
+    void resetStages() noexcept;
+    void delayForTexture(int numSamples) noexcept;
+    void switchTexture(bool on) noexcept;
+
+    JuicyPunchKernel punch;
+    JuicySaturatorKernel saturator;
+    JuicyTextureKernel texture;
+    JuicyWidthKernel width;
+    JuicyCohereKernel cohere;
+
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<float> sliceSlot;
+    JuicyStateArena::Slot<float> textureDelaySlot;
+    int textureDelayPosition = 0;
+    std::vector<float*> sliceChannels;
+    juce::AudioBuffer<float> slice;
+    int numChannels = 0;
+    JuicyIdleDetector idleDetector;
+    double sr = 44100.0;
+    std::array<bool, juicyChainNumStages> wasEnabled { true, true, true, true, true };
+};
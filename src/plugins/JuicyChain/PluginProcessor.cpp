@@ -0,0 +1,345 @@
+#include "PluginProcessor.h"
+#include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
+
+namespace
+{
+// The Cohere stage's learned reference spectrum travels in the extra data, after these.
+constexpr std::array<const char*, 40> stateParameterIds {
+    "slot1", "slot2", "slot3", "slot4", "slot5", "analysis",
+    "punch_on", "punch_punch", "punch_sustain", "punch_slam", "punch_clip", "punch_mix", "punch_output",
+    "saturator_on", "saturator_drive", "saturator_asymmetry", "saturator_tone", "saturator_mix", "saturator_output",
+    "texture_on", "texture_material", "texture_tailshape", "texture_damping", "texture_weight", "texture_texture", "texture_mix", "texture_output",
+    "width_on", "width_width", "width_haasMs", "width_monoSafe", "width_mix", "width_output",
+    "cohere_on", "cohere_match", "cohere_learn", "cohere_tail", "cohere_decay", "cohere_mix", "cohere_output"
+};
+
+constexpr std::array<const char*, juicyChainNumStages> slotIds { "slot1", "slot2", "slot3", "slot4", "slot5" };
+constexpr std::array<const char*, juicyChainNumStages> stageEnableIds { "punch_on", "saturator_on", "texture_on", "width_on", "cohere_on" };
+
+const juce::StringArray& stageNames()
+{
+    static const juce::StringArray names { "Punch", "Saturator", "Texture", "Width", "Cohere" };
+    return names;
+}
+}
+
+JuicyChainAudioProcessor::JuicyChainAudioProcessor()
+    : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
+                                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+      parameters(*this, nullptr, "PARAMS", createParameterLayout())
+{
+    juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
+    contextFitParameter = parameters.getParameter("contextfit");
+}
+
+void JuicyChainAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    for (auto& analyzer : stageAnalyzers)
+        analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    kernel.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    timeline.reset();
+    setLatencySamples(kernel.getLatencySamples());
+    quality.prepare(sampleRate, JuicyQualityTier::reducedDsp);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
+
+    const int threshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && getTotalNumInputChannels() >= threshold)
+        workerPool->start();
+}
+
+void JuicyChainAudioProcessor::releaseResources()
+{
+}
+
+bool JuicyChainAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
+        return false;
+    return ! layouts.getMainOutputChannelSet().isDisabled();
+}
+
+double JuicyChainAudioProcessor::getTailLengthSeconds() const
+{
+    return kernel.getTailLengthSeconds(readParameters());
+}
+
+void JuicyChainAudioProcessor::pushJuicinessToHost(float score)
+{
+    if (juicinessParameter != nullptr)
+        juicinessParameter->setValueNotifyingHost(juicinessParameter->getNormalisableRange().convertTo0to1(score));
+}
+
+void JuicyChainAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
+
+    const int inCh = getTotalNumInputChannels();
+    const int outCh = getTotalNumOutputChannels();
+    for (int i = inCh; i < outCh; ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
+
+    // Per-stage analysis costs one analyzer pass per stage, so it follows the post analysis
+    // down the quality tiers.
+    const bool perStage = analysesPerStage() && quality.runsPostAnalysis();
+    if (perStage)
+        for (auto& analyzer : stageAnalyzers)
+            analyzer.beginBlock(true);
+
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.workerPool = &workerPool.get();
+    context.parallelChannelThreshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    context.samplePosition = timeline.beginBlock(getPlayHead(), buffer.getNumSamples());
+    if (! kernel.process(buffer, params, context, perStage ? stageAnalyzers.data() : nullptr))
+        return;
+
+    if (perStage)
+    {
+        JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::postAnalysis);
+        for (int stage = 0; stage < juicyChainNumStages; ++stage)
+            if (params.enabled[static_cast<size_t>(stage)])
+                latestStageScores[static_cast<size_t>(stage)].store(stageAnalyzers[static_cast<size_t>(stage)].finishBlock().score,
+                                                                    std::memory_order_relaxed);
+    }
+
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis, [this] { return postAnalyzer.finishBlock(); });
+    publishMetrics(preMetrics, metrics);
+
+    if (contextFitParameter != nullptr && params.enabled[static_cast<size_t>(JuicyChainStage::cohere)])
+    {
+        JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+        contextFitParameter->setValueNotifyingHost(contextFitParameter->getNormalisableRange().convertTo0to1(kernel.getCohereKernel().getContextFit()));
+    }
+}
+
+void JuicyChainAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
+    {
+        processBlock(buffer, midiMessages);
+        return;
+    }
+
+    if (bypass.runsBypassMeter())
+    {
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, metrics);
+    }
+}
+
+void JuicyChainAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.punch, std::memory_order_relaxed);
+    latestRichness.store(post.richness, std::memory_order_relaxed);
+    latestClarity.store(post.clarity, std::memory_order_relaxed);
+    latestWidth.store(post.width, std::memory_order_relaxed);
+    latestMonoSafety.store(post.monoSafety, std::memory_order_relaxed);
+    pushJuicinessToHost(post.score);
+}
+
+void JuicyChainAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+    for (auto& analyzer : stageAnalyzers)
+        analyzer.reset();
+}
+
+bool JuicyChainAudioProcessor::analysesPerStage() const
+{
+    return static_cast<int>(*parameters.getRawParameterValue("analysis")) == 1;
+}
+
+JuicyChainParameters JuicyChainAudioProcessor::readParameters() const
+{
+    auto value = [this](const char* id) { return parameters.getRawParameterValue(id)->load(); };
+
+    JuicyChainParameters p;
+    for (int slot = 0; slot < juicyChainNumStages; ++slot)
+        p.order[static_cast<size_t>(slot)] = static_cast<int>(value(slotIds[static_cast<size_t>(slot)]));
+    for (int stage = 0; stage < juicyChainNumStages; ++stage)
+        p.enabled[static_cast<size_t>(stage)] = value(stageEnableIds[static_cast<size_t>(stage)]) > 0.5f;
+
+    p.punch.punch = value("punch_punch");
+    p.punch.sustain = value("punch_sustain");
+    p.punch.slam = value("punch_slam");
+    p.punch.clip = value("punch_clip");
+    p.punch.mix = value("punch_mix");
+    p.punch.outputDb = value("punch_output");
+
+    p.saturator.driveDb = value("saturator_drive");
+    p.saturator.asymmetry = value("saturator_asymmetry");
+    p.saturator.tone = value("saturator_tone");
+    p.saturator.mix = value("saturator_mix");
+    p.saturator.outputDb = value("saturator_output");
+
+    p.texture.material = static_cast<int>(value("texture_material"));
+    p.texture.tailShape = value("texture_tailshape");
+    p.texture.damping = value("texture_damping");
+    p.texture.weight = value("texture_weight");
+    p.texture.texture = value("texture_texture");
+    p.texture.mix = value("texture_mix");
+    p.texture.outputDb = value("texture_output");
+
+    p.width.width = value("width_width");
+    p.width.haasMs = value("width_haasMs");
+    p.width.monoSafe = value("width_monoSafe");
+    p.width.mix = value("width_mix");
+    p.width.outputDb = value("width_output");
+
+    p.cohere.match = value("cohere_match");
+    p.cohere.learn = value("cohere_learn") > 0.5f;
+    p.cohere.tail = value("cohere_tail");
+    p.cohere.decay = value("cohere_decay");
+    p.cohere.mix = value("cohere_mix");
+    p.cohere.outputDb = value("cohere_output");
+    return p;
+}
+
+juce::AudioProcessorEditor* JuicyChainAudioProcessor::createEditor()
+{
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Chain");
+    editor->setStageProfiler(&profiler);
+    return editor;
+}
+
+void JuicyChainAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    float low = 0.0f, mid = 0.0f, high = 0.0f;
+    kernel.getCohereKernel().getReferenceSpectrum(low, mid, high);
+
+    juce::MemoryBlock learned;
+    {
+        juce::MemoryOutputStream out(learned, false);
+        out.writeFloat(low);
+        out.writeFloat(mid);
+        out.writeFloat(high);
+        out.writeInt(static_cast<int>(kernel.getTextureKernel().getNoiseSeed()));
+    }
+    writeJuicyState(destData, parameters, stateParameterIds, learned);
+}
+
+void JuicyChainAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    juce::MemoryBlock learned;
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds, &learned))
+    {
+        if (learned.getSize() >= 3 * sizeof(float))
+        {
+            juce::MemoryInputStream in(learned, false);
+            const float low = in.readFloat();
+            const float mid = in.readFloat();
+            const float high = in.readFloat();
+            kernel.getCohereKernel().setReferenceSpectrum(low, mid, high);
+            if (learned.getSize() >= 3 * sizeof(float) + sizeof(juce::int32))
+                kernel.getTextureKernel().setNoiseSeed(static_cast<uint32_t>(in.readInt()));
+        }
+        return;
+    }
+
+    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
+    if (xmlState != nullptr && xmlState->hasTagName(parameters.state.getType()))
+        parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+}
+
+JuicinessMetrics JuicyChainAudioProcessor::getLatestMetrics() const noexcept
+{
+    JuicinessMetrics m;
+    m.preScore = latestPreScore.load(std::memory_order_relaxed);
+    m.postScore = latestPostScore.load(std::memory_order_relaxed);
+    m.score = latestScore.load(std::memory_order_relaxed);
+    m.punch = latestPunch.load(std::memory_order_relaxed);
+    m.richness = latestRichness.load(std::memory_order_relaxed);
+    m.clarity = latestClarity.load(std::memory_order_relaxed);
+    m.width = latestWidth.load(std::memory_order_relaxed);
+    m.monoSafety = latestMonoSafety.load(std::memory_order_relaxed);
+    m.qualityTier = static_cast<int>(quality.getTier());
+    return m;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout JuicyChainAudioProcessor::createParameterLayout()
+{
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> p;
+    for (int slot = 0; slot < juicyChainNumStages; ++slot)
+        p.push_back(std::make_unique<juce::AudioParameterChoice>(slotIds[static_cast<size_t>(slot)], "Slot " + juce::String(slot + 1), stageNames(), slot));
+    p.push_back(std::make_unique<juce::AudioParameterChoice>("analysis", "Analysis", juce::StringArray { "Chain In/Out", "Per Stage" }, 0));
+
+    p.push_back(std::make_unique<juce::AudioParameterBool>("punch_on", "Punch: On", true));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("punch_punch", "Punch: Punch", 0.0f, 1.5f, 0.9f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("punch_sustain", "Punch: Sustain", 0.0f, 1.5f, 0.35f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("punch_slam", "Punch: Slam", 0.0f, 1.0f, 0.65f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("punch_clip", "Punch: Clip", 0.0f, 1.0f, 0.25f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("punch_mix", "Punch: Mix", 0.0f, 1.0f, 1.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("punch_output", "Punch: Output (dB)", -24.0f, 18.0f, -4.0f));
+
+    p.push_back(std::make_unique<juce::AudioParameterBool>("saturator_on", "Saturator: On", true));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("saturator_drive", "Saturator: Drive (dB)", 0.0f, 24.0f, 6.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("saturator_asymmetry", "Saturator: Asymmetry", -0.5f, 0.5f, 0.1f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("saturator_tone", "Saturator: Tone", 0.0f, 1.0f, 0.55f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("saturator_mix", "Saturator: Mix", 0.0f, 1.0f, 1.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("saturator_output", "Saturator: Output (dB)", -18.0f, 18.0f, -3.0f));
+
+    p.push_back(std::make_unique<juce::AudioParameterBool>("texture_on", "Texture: On", true));
+    p.push_back(std::make_unique<juce::AudioParameterChoice>("texture_material", "Texture: Material", juce::StringArray { "Gel", "Metal", "Wood", "Plastic", "Flesh-like" }, 0));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("texture_tailshape", "Texture: Tail Shape", 0.0f, 1.0f, 0.55f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("texture_damping", "Texture: Damping", 0.0f, 1.0f, 0.5f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("texture_weight", "Texture: Low-end Weight", 0.0f, 1.0f, 0.45f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("texture_texture", "Texture: Texture Layer", 0.0f, 1.0f, 0.5f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("texture_mix", "Texture: Mix", 0.0f, 1.0f, 1.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("texture_output", "Texture: Output (dB)", -18.0f, 18.0f, -2.0f));
+
+    p.push_back(std::make_unique<juce::AudioParameterBool>("width_on", "Width: On", true));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("width_width", "Width: Stereo Width", 0.0f, 1.0f, 0.45f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("width_haasMs", "Width: Haas Delay (ms)", 0.0f, 35.0f, 12.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("width_monoSafe", "Width: Mono Safety", 0.0f, 1.0f, 0.7f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("width_mix", "Width: Mix", 0.0f, 1.0f, 1.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("width_output", "Width: Output (dB)", -18.0f, 18.0f, 0.0f));
+
+    p.push_back(std::make_unique<juce::AudioParameterBool>("cohere_on", "Cohere: On", true));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("cohere_match", "Cohere: Spectral Match", 0.0f, 1.0f, 0.65f));
+    p.push_back(std::make_unique<juce::AudioParameterBool>("cohere_learn", "Cohere: Learn Target", false));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("cohere_tail", "Cohere: Tail Coherence", 0.0f, 1.0f, 0.45f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("cohere_decay", "Cohere: Tail Decay", 0.1f, 0.95f, 0.65f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("cohere_mix", "Cohere: Mix", 0.0f, 1.0f, 1.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("cohere_output", "Cohere: Output (dB)", -18.0f, 18.0f, 0.0f));
+
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("contextfit", "Context Fit", 0.0f, 100.0f, 0.0f));
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                            juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                .withCategory(juce::AudioProcessorParameter::otherMeter)));
+    return { p.begin(), p.end() };
+}
+
+#if ! JUICY_BUNDLED_PROCESSORS
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new JuicyChainAudioProcessor();
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "../../shared/JuicyTimeline.h"
+#include "../../shared/JuicyWorkerPool.h"
+#include "JuicyChainKernel.h"
+
+class JuicyChainAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor, public JuicyParallelProcessor
+{
+public:
+    JuicyChainAudioProcessor();
+    ~JuicyChainAudioProcessor() override = default;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    const juce::String getName() const override { return JucePlugin_Name; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    bool isMidiEffect() const override { return false; }
+    double getTailLengthSeconds() const override;
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override {}
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+    JuicinessMetrics getLatestMetrics() const noexcept;
+
+    // Juiciness after the given stage (a JuicyChainStage), from the last block analysed per stage.
+    float getStageScore(JuicyChainStage stage) const noexcept { return latestStageScores[static_cast<size_t>(stage)].load(std::memory_order_relaxed); }
+
+    void setParallelChannelThreshold(int numChannels) noexcept override { parallelChannelThreshold.store(numChannels); }
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
+
+private:
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicyChainParameters readParameters() const;
+    bool analysesPerStage() const;
+
+    juce::AudioProcessorValueTreeState parameters;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
+    std::array<JuicinessAnalyzer, juicyChainNumStages> stageAnalyzers;
+    juce::RangedAudioParameter* juicinessParameter = nullptr;
+    juce::RangedAudioParameter* contextFitParameter = nullptr;
+
+    std::atomic<float> latestPreScore { 0.0f };
+    std::atomic<float> latestPostScore { 0.0f };
+    std::atomic<float> latestScore { 0.0f };
+    std::atomic<float> latestPunch { 0.0f };
+    std::atomic<float> latestRichness { 0.0f };
+    std::atomic<float> latestClarity { 0.0f };
+    std::atomic<float> latestWidth { 0.0f };
+    std::atomic<float> latestMonoSafety { 1.0f };
+    std::array<std::atomic<float>, juicyChainNumStages> latestStageScores {};
+
+    JuicyChainKernel kernel;
+    juce::SharedResourcePointer<JuicyWorkerPool> workerPool;
+    std::atomic<int> parallelChannelThreshold { juicyDefaultParallelThreshold };
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
+    JuicyTimeline timeline;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyChainAudioProcessor)
+};
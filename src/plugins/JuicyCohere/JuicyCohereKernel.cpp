@@ -0,0 +1,248 @@
+#include "JuicyCohereKernel.h"
+#include "../../shared/JuicySubBlocks.h"
+
+void JuicyCohereKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    numChannels = layout.size();
+    lowCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 220.0f / static_cast<float>(sampleRate));
+    highCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 2400.0f / static_cast<float>(sampleRate));
+    frameLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.01));
+    nextPosition = -1;
+
+    channelPairs.clear();
+    for (const auto& pair : findJuicyChannelPairs(layout))
+        if (juce::jmax(pair.left, pair.right) < numChannels)
+            channelPairs.push_back(pair);
+
+    analysisPair = -1;
+    const int analysedRight = juce::jmin(1, numChannels - 1);
+    for (size_t p = 0; p < channelPairs.size(); ++p)
+        if (channelPairs[p].left == 0 && channelPairs[p].right == analysedRight)
+            analysisPair = static_cast<int>(p);
+
+    arena.beginLayout();
+    pairSlot = arena.reserveHot<PairState>(channelPairs.size());
+    arena.allocate();
+    arena.fill(pairSlot, PairState {});
+    idleDetector.reset();
+}
+
+void JuicyCohereKernel::reset() noexcept
+{
+    arena.fill(pairSlot, PairState {});
+    idleDetector.reset();
+    nextPosition = -1;
+}
+
+double JuicyCohereKernel::getTailLengthSeconds(const JuicyCohereParameters& params) const
+{
+    // The feedback tail or the band filters, whichever rings longer.
+    return juce::jmax(juicyDecaySeconds(juce::jlimit(0.0f, 0.93f, params.decay), sr), juicyDecaySeconds(1.0 - lowCoeff, sr));
+}
+
+void JuicyCohereKernel::getReferenceSpectrum(float& low, float& mid, float& high) const noexcept
+{
+    low = targetLow.load(std::memory_order_relaxed);
+    mid = targetMid.load(std::memory_order_relaxed);
+    high = targetHigh.load(std::memory_order_relaxed);
+}
+
+void JuicyCohereKernel::setReferenceSpectrum(float low, float mid, float high) noexcept
+{
+    targetLow.store(low, std::memory_order_relaxed);
+    targetMid.store(mid, std::memory_order_relaxed);
+    targetHigh.store(high, std::memory_order_relaxed);
+}
+
+void JuicyCohereKernel::finishFrame(PairState* pairs, int numPairs, const JuicyCohereParameters& params) noexcept
+{
+    const float n = 1.0f / static_cast<float>(juce::jmax(1, frameSamples));
+    float lowEnergy = 0.0f, midEnergy = 0.0f, highEnergy = 0.0f;
+    for (int p = 0; p < numPairs; ++p)
+    {
+        auto& pair = pairs[p];
+        pair.lowEnergy *= n; pair.midEnergy *= n; pair.highEnergy *= n;
+        lowEnergy += pair.lowEnergy;
+        midEnergy += pair.midEnergy;
+        highEnergy += pair.highEnergy;
+    }
+    // Every pair learns towards, and is matched against, the same reference spectrum.
+    const float pairNorm = 1.0f / static_cast<float>(juce::jmax(1, numPairs));
+    lowEnergy *= pairNorm; midEnergy *= pairNorm; highEnergy *= pairNorm;
+
+    float refLow = targetLow.load(std::memory_order_relaxed);
+    float refMid = targetMid.load(std::memory_order_relaxed);
+    float refHigh = targetHigh.load(std::memory_order_relaxed);
+    if (params.learn)
+    {
+        const float a = 0.02f;
+        refLow += (lowEnergy - refLow) * a;
+        refMid += (midEnergy - refMid) * a;
+        refHigh += (highEnergy - refHigh) * a;
+        targetLow.store(refLow, std::memory_order_relaxed);
+        targetMid.store(refMid, std::memory_order_relaxed);
+        targetHigh.store(refHigh, std::memory_order_relaxed);
+    }
+
+    const float matchAmt = params.match;
+    float deviation = 0.0f;
+    for (int p = 0; p < numPairs; ++p)
+    {
+        auto& pair = pairs[p];
+        const float lowErr = std::abs(juce::Decibels::gainToDecibels((pair.lowEnergy + 1.0e-6f) / (refLow + 1.0e-6f)));
+        const float midErr = std::abs(juce::Decibels::gainToDecibels((pair.midEnergy + 1.0e-6f) / (refMid + 1.0e-6f)));
+        const float highErr = std::abs(juce::Decibels::gainToDecibels((pair.highEnergy + 1.0e-6f) / (refHigh + 1.0e-6f)));
+        deviation += (lowErr + midErr + highErr) / 3.0f;
+
+        pair.lowComp = juce::jlimit(0.5f, 1.8f, std::pow((refLow + 1.0e-6f) / (pair.lowEnergy + 1.0e-6f), 0.25f * matchAmt));
+        pair.midComp = juce::jlimit(0.5f, 1.8f, std::pow((refMid + 1.0e-6f) / (pair.midEnergy + 1.0e-6f), 0.25f * matchAmt));
+        pair.highComp = juce::jlimit(0.5f, 1.8f, std::pow((refHigh + 1.0e-6f) / (pair.highEnergy + 1.0e-6f), 0.25f * matchAmt));
+        pair.lowEnergy = pair.midEnergy = pair.highEnergy = 0.0f;
+    }
+    deviation *= pairNorm;
+    contextFit = juce::jlimit(0.0f, 100.0f, 100.0f - deviation * 10.0f);
+
+    framePhase = 0;
+    frameSamples = 0;
+}
+
+void JuicyCohereKernel::beginBlock(const JuicyCohereParameters& params, const JuicyKernelContext& context, int numSamples) noexcept
+{
+    blockParams = params;
+    feedback = juce::jlimit(0.0f, 0.93f, params.decay);
+    outGain = juce::Decibels::decibelsToGain(params.outputDb);
+
+    // After a seek or reset the current frame starts part-way, at the timeline position, and
+    // is normalised by the samples it actually scanned.
+    if (context.samplePosition != nextPosition)
+    {
+        framePhase = static_cast<int>(((context.samplePosition % frameLength) + frameLength) % frameLength);
+        frameSamples = 0;
+        if (auto* pairs = arena.get(pairSlot))
+            for (size_t p = 0; p < channelPairs.size(); ++p)
+                pairs[p].lowEnergy = pairs[p].midEnergy = pairs[p].highEnergy = 0.0f;
+    }
+    nextPosition = context.samplePosition + numSamples;
+}
+
+bool JuicyCohereKernel::isStateSilent() const noexcept
+{
+    const auto* pairs = arena.get(pairSlot);
+    const int numPairs = pairs != nullptr ? static_cast<int>(channelPairs.size()) : 0;
+    for (int p = 0; p < numPairs; ++p)
+    {
+        const auto& pair = pairs[p];
+        if (! isJuicyStateSilent(pair.tail, 2) || ! isJuicyStateSilent(pair.bandLow, 2) || ! isJuicyStateSilent(pair.bandHigh, 2)
+            || std::abs(pair.lowLp) > juicySilenceThreshold || std::abs(pair.highLp) > juicySilenceThreshold)
+            return false;
+    }
+    return true;
+}
+
+bool JuicyCohereKernel::process(juce::AudioBuffer<float>& buffer, const JuicyCohereParameters& params, const JuicyKernelContext& context) noexcept
+{
+    const int inCh = juce::jmin(buffer.getNumChannels(), numChannels);
+    const int numSamples = buffer.getNumSamples();
+
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, inCh), numSamples, getTailLengthSeconds(params), sr,
+                                          [this] { return isStateSilent(); });
+    if (idle)
+    {
+        if (idleDetector.hasJustEntered())
+            arena.fill(pairSlot, PairState {});
+        // Frames restart from the timeline position when the signal returns.
+        nextPosition = -1;
+        buffer.clear();
+        return false;
+    }
+
+    beginBlock(params, context, numSamples);
+    render(buffer, 0, numSamples, context);
+    return true;
+}
+
+void JuicyCohereKernel::render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept
+{
+    const int inCh = juce::jmin(buffer.getNumChannels(), numChannels);
+    const float tailAmt = blockParams.tail;
+    const float mix = blockParams.mix;
+    const float fb = feedback;
+
+    auto* pairs = arena.get(pairSlot);
+    const int numPairs = pairs != nullptr ? static_cast<int>(channelPairs.size()) : 0;
+
+    // Pairs only meet again in the learned reference spectrum at frame ends, so the slice is
+    // cut at those and each segment runs one task per pair, spread over the worker pool. The
+    // pair on the analysed channels carries the fused analyses; other layouts analyse in
+    // passes of their own.
+    auto forEachPair = [&](auto&& task) { context.forEachTask(inCh, numPairs, task); };
+    const int endSample = startSample + numSamples;
+
+    for (int segmentStart = startSample; segmentStart < endSample;)
+    {
+        const int segmentLength = juce::jmin(endSample - segmentStart, frameLength - framePhase);
+        if (analysisPair < 0)
+            forEachJuicySubBlock(segmentLength, [&](int start, int num) { context.analyseInput(buffer, segmentStart + start, num); });
+
+        forEachPair([&](int p)
+        {
+            auto& pair = pairs[p];
+            const auto& channels = channelPairs[static_cast<size_t>(p)];
+            const int numSides = channels.right != channels.left ? 2 : 1;
+            auto* left = buffer.getWritePointer(channels.left);
+            auto* right = buffer.getWritePointer(channels.right);
+            forEachJuicySubBlock(segmentLength, [&](int subStart, int num)
+            {
+                const int start = segmentStart + subStart;
+                if (p == analysisPair)
+                    context.analyseInput(buffer, start, num);
+
+                for (int i = start; i < start + num; ++i)
+                {
+                    // Scan the dry pair into this frame's energies, then match it with the
+                    // compensation from the frame before.
+                    const float dry[2] = { left[i], right[i] };
+                    const float mono = 0.5f * (dry[0] + dry[1]);
+                    pair.lowLp += lowCoeff * (mono - pair.lowLp);
+                    pair.highLp += highCoeff * (mono - pair.highLp);
+                    const float scanLow = pair.lowLp;
+                    const float scanHigh = mono - pair.highLp;
+                    const float scanMid = mono - scanLow - scanHigh;
+                    pair.lowEnergy += scanLow * scanLow;
+                    pair.midEnergy += scanMid * scanMid;
+                    pair.highEnergy += scanHigh * scanHigh;
+
+                    for (int side = 0; side < numSides; ++side)
+                    {
+                        float& tail = pair.tail[side];
+                        float& bandLow = pair.bandLow[side];
+                        float& bandHigh = pair.bandHigh[side];
+                        bandLow += lowCoeff * (dry[side] - bandLow);
+                        bandHigh += highCoeff * (dry[side] - bandHigh);
+                        const float low = bandLow * pair.lowComp;
+                        const float high = (dry[side] - bandHigh) * pair.highComp;
+                        const float mid = (dry[side] - bandLow - (dry[side] - bandHigh)) * pair.midComp;
+                        const float matched = low + mid + high;
+
+                        tail = matched + tail * fb;
+                        const float wet = matched + tailAmt * 0.35f * tail;
+                        (side == 0 ? left : right)[i] = (dry[side] + mix * (wet - dry[side])) * outGain;
+                    }
+                }
+
+                if (p == analysisPair)
+                    context.analyseOutput(buffer, start, num);
+            });
+        });
+
+        if (analysisPair < 0)
+            forEachJuicySubBlock(segmentLength, [&](int start, int num) { context.analyseOutput(buffer, segmentStart + start, num); });
+
+        framePhase += segmentLength;
+        frameSamples += segmentLength;
+        if (framePhase >= frameLength)
+            finishFrame(pairs, numPairs, blockParams);
+        segmentStart += segmentLength;
+    }
+}
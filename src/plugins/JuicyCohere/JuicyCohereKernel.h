@@ -0,0 +1,94 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <vector>
+#include "../../shared/JuicyChannelPairs.h"
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyStateArena.h"
+
+struct JuicyCohereParameters
+{
+    float match = 0.65f;
+    bool learn = false;
+    float tail = 0.45f;
+    float decay = 0.65f;
+    float mix = 1.0f;
+    float outputDb = 0.0f;
+};
+
+// Three-band spectral match against a learned reference, plus a feedback tail, run on every
+// left/right pair of the layout. Band energies are measured over fixed 10 ms frames aligned to
+// the timeline, and each frame is matched with the compensation measured on the frame before,
+// so the result does not depend on the host's block size.
+class JuicyCohereKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Returns false on the idle path; neither the analyzers nor the context fit are updated then.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyCohereParameters& params, const JuicyKernelContext& context) noexcept;
+
+    // process() past its idle check, split for chains that map parameters and line the frames
+    // up with the timeline once per host block, then render it slice by slice, in order.
+    void beginBlock(const JuicyCohereParameters& params, const JuicyKernelContext& context, int numSamples) noexcept;
+    void render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept;
+    bool isStateSilent() const noexcept;
+
+    double getTailLengthSeconds(const JuicyCohereParameters& params) const;
+
+    // How closely the last complete analysis frame matched the reference, 0 to 100.
+    float getContextFit() const noexcept { return contextFit; }
+
+    // The learned reference spectrum, safe to call from the message thread while processing.
+    void getReferenceSpectrum(float& low, float& mid, float& high) const noexcept;
+    void setReferenceSpectrum(float low, float mid, float high) noexcept;
+
+private:
+    struct PairState;
+
+    // Turns the frame's band energies into the compensation for the next frame and, when
+    // learning, moves the reference towards them.
+    void finishFrame(PairState* pairs, int numPairs, const JuicyCohereParameters& params) noexcept;
+
+    // Band scan, spectral compensation and tails of one L/R pair.
+    struct PairState
+    {
+        float lowLp = 0.0f;
+        float highLp = 0.0f;
+        float lowEnergy = 0.0f;
+        float midEnergy = 0.0f;
+        float highEnergy = 0.0f;
+        float lowComp = 1.0f;
+        float midComp = 1.0f;
+        float highComp = 1.0f;
+        float tail[2] = { 0.0f, 0.0f };
+        float bandLow[2] = { 0.0f, 0.0f };
+        float bandHigh[2] = { 0.0f, 0.0f };
+    };
+
+    JuicyCohereParameters blockParams; // as passed to the last beginBlock()
+    float feedback = 0.0f;
+    float outGain = 1.0f;
+
+    std::atomic<float> targetLow { 0.2f };
+    std::atomic<float> targetMid { 0.2f };
+    std::atomic<float> targetHigh { 0.2f };
+    float lowCoeff = 0.0f;
+    float highCoeff = 0.0f;
+    float contextFit = 0.0f;
+    int frameLength = 441;
+    int framePhase = 0;            // samples of the current frame already passed
+    int frameSamples = 0;          // of those, the ones scanned into the energies
+    juce::int64 nextPosition = -1; // timeline position the frame phase is valid for
+
+    std::vector<JuicyChannelPair> channelPairs;
+    int analysisPair = -1;
+    int numChannels = 0;
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<PairState> pairSlot;
+    JuicyIdleDetector idleDetector;
+    double sr = 44100.0;
+};
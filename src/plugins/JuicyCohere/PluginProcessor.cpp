@@ -1,5 +1,13 @@
 #include "PluginProcessor.h"
 #include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
+#include <array>
+
+namespace
+{
+// The learned reference spectrum travels in the extra data, after these.
+constexpr std::array<const char*, 6> stateParameterIds { "match", "learn", "tail", "decay", "mix", "output" };
+}
 
 JuicyCohereAudioProcessor::JuicyCohereAudioProcessor()
     : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
@@ -7,18 +15,23 @@ JuicyCohereAudioProcessor::JuicyCohereAudioProcessor()
       parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
     juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
     contextFitParameter = parameters.getParameter("contextfit");
 }
 
 void JuicyCohereAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    lowCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 220.0f / static_cast<float>(sampleRate));
-    highCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 2400.0f / static_cast<float>(sampleRate));
-    tailL = 0.0f;
-    tailR = 0.0f;
-    lowLp = 0.0f;
-    highLp = 0.0f;
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    kernel.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    timeline.reset();
+    quality.prepare(sampleRate, JuicyQualityTier::decimatedAnalysis);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
+
+    const int threshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && getTotalNumInputChannels() >= threshold)
+        workerPool->start();
 }
 
 void JuicyCohereAudioProcessor::releaseResources()
@@ -27,10 +40,15 @@ void JuicyCohereAudioProcessor::releaseResources()
 
 bool JuicyCohereAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
+    // Surround layouts are matched pair by pair; centre and LFE are matched on their own.
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    return ! layouts.getMainOutputChannelSet().isDisabled();
+}
+
+double JuicyCohereAudioProcessor::getTailLengthSeconds() const
+{
+    return kernel.getTailLengthSeconds(readParameters());
 }
 
 void JuicyCohereAudioProcessor::pushJuicinessToHost(float score)
@@ -43,107 +61,130 @@ void JuicyCohereAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, j
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
 
     const int inCh = getTotalNumInputChannels();
     const int outCh = getTotalNumOutputChannels();
     for (int i = inCh; i < outCh; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    const auto preMetrics = analyzer.analyze(buffer);
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
+
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.workerPool = &workerPool.get();
+    context.parallelChannelThreshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    context.samplePosition = timeline.beginBlock(getPlayHead(), buffer.getNumSamples());
+    if (! kernel.process(buffer, params, context))
+        return;
+
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis, [this] { return postAnalyzer.finishBlock(); });
+    publishMetrics(preMetrics, metrics);
 
-    const float matchAmt = *parameters.getRawParameterValue("match");
-    const bool learn = *parameters.getRawParameterValue("learn") > 0.5f;
-    const float tailAmt = *parameters.getRawParameterValue("tail");
-    const float decay = *parameters.getRawParameterValue("decay");
-    const float mix = *parameters.getRawParameterValue("mix");
-    const float outDb = *parameters.getRawParameterValue("output");
-    const float outGain = juce::Decibels::decibelsToGain(outDb);
-
-    float lowEnergy = 0.0f, midEnergy = 0.0f, highEnergy = 0.0f;
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    if (contextFitParameter != nullptr)
     {
-        const float mono = 0.5f * (buffer.getSample(0, i) + buffer.getSample(juce::jmin(1, inCh - 1), i));
-        lowLp += lowCoeff * (mono - lowLp);
-        highLp += highCoeff * (mono - highLp);
-        const float low = lowLp;
-        const float high = mono - highLp;
-        const float mid = mono - low - high;
-        lowEnergy += low * low;
-        midEnergy += mid * mid;
-        highEnergy += high * high;
+        JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+        contextFitParameter->setValueNotifyingHost(contextFitParameter->getNormalisableRange().convertTo0to1(kernel.getContextFit()));
     }
-    const float n = 1.0f / static_cast<float>(juce::jmax(1, buffer.getNumSamples()));
-    lowEnergy *= n; midEnergy *= n; highEnergy *= n;
+}
 
-    if (learn)
+void JuicyCohereAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
     {
-        const float a = 0.02f;
-        targetLow += (lowEnergy - targetLow) * a;
-        targetMid += (midEnergy - targetMid) * a;
-        targetHigh += (highEnergy - targetHigh) * a;
+        processBlock(buffer, midiMessages);
+        return;
     }
 
-    const float lowErr = std::abs(juce::Decibels::gainToDecibels((lowEnergy + 1.0e-6f) / (targetLow + 1.0e-6f)));
-    const float midErr = std::abs(juce::Decibels::gainToDecibels((midEnergy + 1.0e-6f) / (targetMid + 1.0e-6f)));
-    const float highErr = std::abs(juce::Decibels::gainToDecibels((highEnergy + 1.0e-6f) / (targetHigh + 1.0e-6f)));
-    const float deviation = (lowErr + midErr + highErr) / 3.0f;
-    const float contextFit = juce::jlimit(0.0f, 100.0f, 100.0f - deviation * 10.0f);
-    if (contextFitParameter != nullptr)
-        contextFitParameter->setValueNotifyingHost(contextFitParameter->getNormalisableRange().convertTo0to1(contextFit));
-
-    const float lowComp = juce::jlimit(0.5f, 1.8f, std::pow((targetLow + 1.0e-6f) / (lowEnergy + 1.0e-6f), 0.25f * matchAmt));
-    const float midComp = juce::jlimit(0.5f, 1.8f, std::pow((targetMid + 1.0e-6f) / (midEnergy + 1.0e-6f), 0.25f * matchAmt));
-    const float highComp = juce::jlimit(0.5f, 1.8f, std::pow((targetHigh + 1.0e-6f) / (highEnergy + 1.0e-6f), 0.25f * matchAmt));
-    const float fb = juce::jlimit(0.0f, 0.93f, decay);
-
-    for (int ch = 0; ch < inCh; ++ch)
+    if (bypass.runsBypassMeter())
     {
-        auto* x = buffer.getWritePointer(ch);
-        float& tail = (ch == 0 ? tailL : tailR);
-        float lpA = 0.0f;
-        float lpB = 0.0f;
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            const float dry = x[i];
-            lpA += lowCoeff * (dry - lpA);
-            lpB += highCoeff * (dry - lpB);
-            const float low = lpA * lowComp;
-            const float high = (dry - lpB) * highComp;
-            const float mid = (dry - lpA - (dry - lpB)) * midComp;
-            const float matched = low + mid + high;
-
-            tail = matched + tail * fb;
-            const float wet = matched + tailAmt * 0.35f * tail;
-            x[i] = (dry + mix * (wet - dry)) * outGain;
-        }
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, metrics);
     }
+}
 
-    const auto metrics = analyzer.analyze(buffer);
-    latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-    latestPostScore.store(metrics.score, std::memory_order_relaxed);
-    latestScore.store(metrics.score, std::memory_order_relaxed);
-    latestPunch.store(metrics.punch, std::memory_order_relaxed);
-    latestRichness.store(metrics.richness, std::memory_order_relaxed);
-    latestClarity.store(metrics.clarity, std::memory_order_relaxed);
-    latestWidth.store(metrics.width, std::memory_order_relaxed);
-    latestMonoSafety.store(metrics.monoSafety, std::memory_order_relaxed);
-    pushJuicinessToHost(metrics.score);
+void JuicyCohereAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.punch, std::memory_order_relaxed);
+    latestRichness.store(post.richness, std::memory_order_relaxed);
+    latestClarity.store(post.clarity, std::memory_order_relaxed);
+    latestWidth.store(post.width, std::memory_order_relaxed);
+    latestMonoSafety.store(post.monoSafety, std::memory_order_relaxed);
+    pushJuicinessToHost(post.score);
+}
+
+void JuicyCohereAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+}
+
+JuicyCohereParameters JuicyCohereAudioProcessor::readParameters() const
+{
+    JuicyCohereParameters p;
+    p.match = *parameters.getRawParameterValue("match");
+    p.learn = *parameters.getRawParameterValue("learn") > 0.5f;
+    p.tail = *parameters.getRawParameterValue("tail");
+    p.decay = *parameters.getRawParameterValue("decay");
+    p.mix = *parameters.getRawParameterValue("mix");
+    p.outputDb = *parameters.getRawParameterValue("output");
+    return p;
 }
 
 juce::AudioProcessorEditor* JuicyCohereAudioProcessor::createEditor()
 {
-    return new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Cohere");
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Cohere");
+    editor->setStageProfiler(&profiler);
+    return editor;
 }
 
 void JuicyCohereAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    float low = 0.0f, mid = 0.0f, high = 0.0f;
+    kernel.getReferenceSpectrum(low, mid, high);
+
+    juce::MemoryBlock learned;
+    {
+        juce::MemoryOutputStream out(learned, false);
+        out.writeFloat(low);
+        out.writeFloat(mid);
+        out.writeFloat(high);
+    }
+    writeJuicyState(destData, parameters, stateParameterIds, learned);
 }
 
 void JuicyCohereAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    juce::MemoryBlock learned;
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds, &learned))
+    {
+        if (learned.getSize() >= 3 * sizeof(float))
+        {
+            juce::MemoryInputStream in(learned, false);
+            const float low = in.readFloat();
+            const float mid = in.readFloat();
+            const float high = in.readFloat();
+            kernel.setReferenceSpectrum(low, mid, high);
+        }
+        return;
+    }
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState != nullptr && xmlState->hasTagName(parameters.state.getType()))
         parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
@@ -160,6 +201,7 @@ JuicinessMetrics JuicyCohereAudioProcessor::getLatestMetrics() const noexcept
     m.clarity = latestClarity.load(std::memory_order_relaxed);
     m.width = latestWidth.load(std::memory_order_relaxed);
     m.monoSafety = latestMonoSafety.load(std::memory_order_relaxed);
+    m.qualityTier = static_cast<int>(quality.getTier());
     return m;
 }
 
@@ -174,10 +216,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicyCohereAudioProcessor::c
     p.push_back(std::make_unique<juce::AudioParameterFloat>("output", "Output (dB)", -18.0f, 18.0f, 0.0f));
     p.push_back(std::make_unique<juce::AudioParameterFloat>("contextfit", "Context Fit", 0.0f, 100.0f, 0.0f));
     p.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                            juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                .withCategory(juce::AudioProcessorParameter::otherMeter)));
     return { p.begin(), p.end() };
 }
 
+#if ! JUICY_BUNDLED_PROCESSORS
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new JuicyCohereAudioProcessor();
 }
+#endif
@@ -3,8 +3,14 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <atomic>
 #include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "../../shared/JuicyTimeline.h"
+#include "../../shared/JuicyWorkerPool.h"
+#include "JuicyCohereKernel.h"
 
-class JuicyCohereAudioProcessor : public juce::AudioProcessor
+class JuicyCohereAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor, public JuicyParallelProcessor
 {
 public:
     JuicyCohereAudioProcessor();
@@ -14,6 +20,7 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -22,7 +29,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -33,13 +40,20 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
     JuicinessMetrics getLatestMetrics() const noexcept;
+    void setParallelChannelThreshold(int numChannels) noexcept override { parallelChannelThreshold.store(numChannels); }
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
 
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicyCohereParameters readParameters() const;
 
     juce::AudioProcessorValueTreeState parameters;
-    JuicinessAnalyzer analyzer;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
     juce::RangedAudioParameter* juicinessParameter = nullptr;
     juce::RangedAudioParameter* contextFitParameter = nullptr;
 
@@ -52,15 +66,13 @@ private:
     std::atomic<float> latestWidth { 0.0f };
     std::atomic<float> latestMonoSafety { 1.0f };
 
-    float targetLow = 0.2f;
-    float targetMid = 0.2f;
-    float targetHigh = 0.2f;
-    float tailL = 0.0f;
-    float tailR = 0.0f;
-    float lowLp = 0.0f;
-    float highLp = 0.0f;
-    float lowCoeff = 0.0f;
-    float highCoeff = 0.0f;
+    JuicyCohereKernel kernel;
+    juce::SharedResourcePointer<JuicyWorkerPool> workerPool;
+    std::atomic<int> parallelChannelThreshold { juicyDefaultParallelThreshold };
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
+    JuicyTimeline timeline;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyCohereAudioProcessor)
 };
@@ -0,0 +1,42 @@
+#include "JuicyInferKernel.h"
+#include "../../shared/JuicySubBlocks.h"
+
+void JuicyInferKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    numInputChannels = layout.size();
+    idleDetector.reset();
+}
+
+void JuicyInferKernel::reset() noexcept
+{
+    idleDetector.reset();
+}
+
+bool JuicyInferKernel::process(juce::AudioBuffer<float>& buffer, const JuicyInferParameters& params, const JuicyKernelContext& context) noexcept
+{
+    const float trimGain = juce::Decibels::decibelsToGain(params.trimDb);
+    const int inCh = juce::jmin(buffer.getNumChannels(), numInputChannels);
+
+    // A trim has no memory, so any silent block can skip straight to silence.
+    if (idleDetector.update(isJuicyBufferSilent(buffer, inCh), buffer.getNumSamples(), 0.0, sr, [] { return true; }))
+    {
+        buffer.clear();
+        return false;
+    }
+
+    forEachJuicySubBlock(buffer.getNumSamples(), [&](int start, int num)
+    {
+        context.analyseInput(buffer, start, num);
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            buffer.applyGain(ch, start, num, trimGain);
+        context.analyseOutput(buffer, start, num);
+    });
+    return true;
+}
+
+JuicinessMetrics JuicyInferKernel::applySensitivity(JuicinessMetrics metrics, const JuicyInferParameters& params) noexcept
+{
+    metrics.score = juce::jlimit(0.0f, 100.0f, metrics.score * params.sensitivity);
+    return metrics;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+
+struct JuicyInferParameters
+{
+    float trimDb = 0.0f;
+    float sensitivity = 1.0f;
+};
+
+// The analysis plugin's signal path is a plain trim; its real output is the analysis, which
+// the host reads back and scales with applySensitivity().
+class JuicyInferKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Returns false for silent blocks, which skip the analyzers.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyInferParameters& params, const JuicyKernelContext& context) noexcept;
+
+    double getTailLengthSeconds(const JuicyInferParameters&) const { return 0.0; }
+
+    static JuicinessMetrics applySensitivity(JuicinessMetrics metrics, const JuicyInferParameters& params) noexcept;
+
+private:
+    JuicyIdleDetector idleDetector;
+    int numInputChannels = 0;
+    double sr = 44100.0;
+};
@@ -1,9 +1,13 @@
 #include "PluginProcessor.h"
 #include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
 #include <array>
 
 namespace
 {
+// The inferred scores are written by the analysis every block, so only the two inputs are state.
+constexpr std::array<const char*, 2> stateParameterIds { "trim", "sensitivity" };
+
 struct InferPreset
 {
     const char* name;
@@ -26,6 +30,7 @@ JuicyInferAudioProcessor::JuicyInferAudioProcessor()
       parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
     juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
     emphasisParameter = parameters.getParameter("emphasis");
     coherenceParameter = parameters.getParameter("coherence");
     synesthesiaParameter = parameters.getParameter("synesthesia");
@@ -36,7 +41,12 @@ JuicyInferAudioProcessor::JuicyInferAudioProcessor()
 
 void JuicyInferAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    kernel.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    quality.prepare(sampleRate, JuicyQualityTier::decimatedAnalysis);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
 }
 
 void JuicyInferAudioProcessor::releaseResources()
@@ -47,8 +57,7 @@ bool JuicyInferAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
 {
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    return ! layouts.getMainOutputChannelSet().isDisabled();
 }
 
 void JuicyInferAudioProcessor::pushJuicinessToHost(float score)
@@ -65,56 +74,108 @@ void JuicyInferAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, ju
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
 
     const int totalInputChannels = getTotalNumInputChannels();
     const int totalOutputChannels = getTotalNumOutputChannels();
     for (int i = totalInputChannels; i < totalOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    const float trimDb = *parameters.getRawParameterValue("trim");
-    const float trimGain = juce::Decibels::decibelsToGain(trimDb);
-    const float sensitivity = *parameters.getRawParameterValue("sensitivity");
-
-    const auto preMetrics = analyzer.analyze(buffer);
-    buffer.applyGain(trimGain);
-    auto metrics = analyzer.analyze(buffer);
-    metrics.score = juce::jlimit(0.0f, 100.0f, metrics.score * sensitivity);
-    latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-    latestPostScore.store(metrics.score, std::memory_order_relaxed);
-    latestScore.store(metrics.score, std::memory_order_relaxed);
-    latestPunch.store(metrics.emphasis, std::memory_order_relaxed);
-    latestRichness.store(metrics.coherence, std::memory_order_relaxed);
-    latestClarity.store(metrics.synesthesia, std::memory_order_relaxed);
-    latestWidth.store(metrics.fatigueRisk, std::memory_order_relaxed);
-    latestMonoSafety.store(metrics.repetitionDensity, std::memory_order_relaxed);
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
+
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    if (! kernel.process(buffer, params, context))
+        return;
+
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis,
+                                       [this, &params] { return JuicyInferKernel::applySensitivity(postAnalyzer.finishBlock(), params); });
+    publishMetrics(preMetrics, metrics);
+}
+
+void JuicyInferAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
+    {
+        processBlock(buffer, midiMessages);
+        return;
+    }
+
+    if (bypass.runsBypassMeter())
+    {
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, JuicyInferKernel::applySensitivity(metrics, readParameters()));
+    }
+}
+
+void JuicyInferAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.emphasis, std::memory_order_relaxed);
+    latestRichness.store(post.coherence, std::memory_order_relaxed);
+    latestClarity.store(post.synesthesia, std::memory_order_relaxed);
+    latestWidth.store(post.fatigueRisk, std::memory_order_relaxed);
+    latestMonoSafety.store(post.repetitionDensity, std::memory_order_relaxed);
 
     auto setOut = [](juce::RangedAudioParameter* p, float v)
     {
         if (p != nullptr)
             p->setValueNotifyingHost(p->getNormalisableRange().convertTo0to1(v));
     };
-    setOut(emphasisParameter, metrics.emphasis);
-    setOut(coherenceParameter, metrics.coherence);
-    setOut(synesthesiaParameter, metrics.synesthesia);
-    setOut(fatigueParameter, metrics.fatigueRisk);
-    setOut(repetitionParameter, metrics.repetitionDensity);
-    pushJuicinessToHost(metrics.score);
+    setOut(emphasisParameter, post.emphasis);
+    setOut(coherenceParameter, post.coherence);
+    setOut(synesthesiaParameter, post.synesthesia);
+    setOut(fatigueParameter, post.fatigueRisk);
+    setOut(repetitionParameter, post.repetitionDensity);
+    pushJuicinessToHost(post.score);
+}
+
+void JuicyInferAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+}
+
+JuicyInferParameters JuicyInferAudioProcessor::readParameters() const
+{
+    JuicyInferParameters p;
+    p.trimDb = *parameters.getRawParameterValue("trim");
+    p.sensitivity = *parameters.getRawParameterValue("sensitivity");
+    return p;
 }
 
 juce::AudioProcessorEditor* JuicyInferAudioProcessor::createEditor()
 {
-    return new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Infer", true, true);
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Infer", true, true);
+    editor->setStageProfiler(&profiler);
+    return editor;
 }
 
 void JuicyInferAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    writeJuicyState(destData, parameters, stateParameterIds);
 }
 
 void JuicyInferAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds))
+        return;
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState == nullptr)
         return;
@@ -177,6 +238,7 @@ JuicinessMetrics JuicyInferAudioProcessor::getLatestMetrics() const noexcept
     m.clarity = m.synesthesia;
     m.width = m.fatigueRisk;
     m.monoSafety = m.repetitionDensity;
+    m.qualityTier = static_cast<int>(quality.getTier());
     return m;
 }
 
@@ -186,6 +248,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicyInferAudioProcessor::cr
     params.push_back(std::make_unique<juce::AudioParameterFloat>("trim", "Output Trim (dB)", -18.0f, 18.0f, 0.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("sensitivity", "Sensitivity", 0.5f, 2.0f, 1.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                                 juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                     .withCategory(juce::AudioProcessorParameter::otherMeter)));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("emphasis", "Emphasis", 0.0f, 1.0f, 0.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("coherence", "Coherence", 0.0f, 1.0f, 0.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("synesthesia", "Synesthesia", 0.0f, 1.0f, 0.0f));
@@ -194,7 +260,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicyInferAudioProcessor::cr
     return { params.begin(), params.end() };
 }
 
+#if ! JUICY_BUNDLED_PROCESSORS
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new JuicyInferAudioProcessor();
 }
+#endif
@@ -3,8 +3,12 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <atomic>
 #include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "JuicyInferKernel.h"
 
-class JuicyInferAudioProcessor : public juce::AudioProcessor
+class JuicyInferAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor
 {
 public:
     JuicyInferAudioProcessor();
@@ -14,6 +18,7 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -22,7 +27,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override { return kernel.getTailLengthSeconds(readParameters()); }
 
     int getNumPrograms() override;
     int getCurrentProgram() override;
@@ -33,13 +38,19 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
     JuicinessMetrics getLatestMetrics() const noexcept;
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
 
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicyInferParameters readParameters() const;
 
     juce::AudioProcessorValueTreeState parameters;
-    JuicinessAnalyzer analyzer;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
     juce::RangedAudioParameter* juicinessParameter = nullptr;
     juce::RangedAudioParameter* emphasisParameter = nullptr;
     juce::RangedAudioParameter* coherenceParameter = nullptr;
@@ -55,6 +66,10 @@ private:
     std::atomic<float> latestWidth { 0.0f };
     std::atomic<float> latestMonoSafety { 1.0f };
     int currentProgram = 0;
+    JuicyInferKernel kernel;
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyInferAudioProcessor)
 };
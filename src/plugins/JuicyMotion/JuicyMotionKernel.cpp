@@ -0,0 +1,207 @@
+#include "JuicyMotionKernel.h"
+#include "../../shared/JuicySubBlocks.h"
+#include "../../shared/JuicyTimeline.h"
+
+namespace
+{
+// A variation target in [-1, 1) drawn for the onset at a timeline position.
+float variationDraw(uint32_t seed, juce::int64 position, int target) noexcept
+{
+    const uint32_t h = juicyNoiseHash(seed, static_cast<uint64_t>(position) * 3u + static_cast<uint64_t>(target));
+    return static_cast<float>(h >> 17) / 16384.0f - 1.0f;
+}
+}
+
+void JuicyMotionKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    env = 0.0f;
+    repetition = 0.0f;
+    budgetEnv = 0.0f;
+    onsetCooldown = 0;
+    variationTone = variationTransient = variationTail = 0.0f;
+    variationToneTarget = variationTransientTarget = variationTailTarget = 0.0f;
+    motionPhase = 0.0;
+    nextPosition = -1;
+    numInputChannels = layout.size();
+    numChannelStates = juce::jmax(1, numInputChannels);
+
+    arena.beginLayout();
+    tailSlot = arena.reserveHot<float>(static_cast<size_t>(numChannelStates));
+    lpSlot = arena.reserveHot<float>(static_cast<size_t>(numChannelStates));
+    prevSlot = arena.reserveHot<float>(static_cast<size_t>(numChannelStates));
+    arena.allocate();
+    idleDetector.reset();
+}
+
+void JuicyMotionKernel::reset() noexcept
+{
+    env = 0.0f;
+    repetition = 0.0f;
+    budgetEnv = 0.0f;
+    onsetCooldown = 0;
+    variationTone = variationTransient = variationTail = 0.0f;
+    variationToneTarget = variationTransientTarget = variationTailTarget = 0.0f;
+    motionPhase = 0.0;
+    nextPosition = -1;
+    arena.fill(tailSlot, 0.0f);
+    arena.fill(lpSlot, 0.0f);
+    arena.fill(prevSlot, 0.0f);
+    idleDetector.reset();
+}
+
+double JuicyMotionKernel::getTailLengthSeconds(const JuicyMotionParameters& params) const
+{
+    // Slowest of the tail feedback (at its most modulated) and the tone filter at its lowest cutoff.
+    const float feedback = juce::jlimit(0.0f, 0.93f, juce::jmap(params.repeatCtrl, 0.0f, 1.0f, 0.15f, 0.88f) + 0.06f * 0.8f);
+    const double toneFeedback = std::exp(-2.0 * juce::MathConstants<double>::pi * 120.0 / sr);
+    return juce::jmax(juicyDecaySeconds(feedback, sr), juicyDecaySeconds(toneFeedback, sr));
+}
+
+bool JuicyMotionKernel::process(juce::AudioBuffer<float>& buffer, const JuicyMotionParameters& params, const JuicyKernelContext& context) noexcept
+{
+    const int inCh = juce::jmin(buffer.getNumChannels(), numInputChannels);
+    const float microVar = params.microVar;
+    const float motionDepth = params.motionDepth;
+    const float repeatCtrl = params.repeatCtrl;
+    const float contrastBudget = params.budget;
+    const float mix = params.mix;
+    const float outGain = juce::Decibels::decibelsToGain(params.outputDb);
+
+    const float envCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.015));
+    const float budgetCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.080));
+    const float tailFeedback = juce::jmap(repeatCtrl, 0.0f, 1.0f, 0.15f, 0.88f);
+    const float depth = juce::jlimit(0.0f, 2.0f, motionDepth);
+    const float motionRateHz = juce::jmap(microVar, 0.0f, 1.0f, 0.25f, 2.0f) * juce::jmap(depth, 0.0f, 2.0f, 0.75f, 1.6f);
+    const double motionInc = juce::MathConstants<double>::twoPi * motionRateHz / sr;
+    const float varSlew = std::exp(-1.0f / static_cast<float>(sr * 0.020));
+    const float budgetTarget = juce::jmap(contrastBudget, 0.0f, 1.0f, 0.8f, 0.25f);
+    const float wetBoost = 1.0f + 0.9f * microVar * (0.55f + 0.9f * depth);
+    const float motionLfoDepth = (250.0f + 550.0f * microVar) * (0.5f + 0.9f * depth);
+
+    auto* tails = arena.get(tailSlot);
+    auto* lps = arena.get(lpSlot);
+    auto* prevs = arena.get(prevSlot);
+    const int numChannels = tails != nullptr ? juce::jmin(inCh, numChannelStates) : 0;
+    const int numSamples = buffer.getNumSamples();
+
+    // The LFO's phase is a function of the timeline position. It accumulates between
+    // contiguous blocks and is recomputed from the position after a seek or reset.
+    if (context.samplePosition != nextPosition)
+        motionPhase = std::fmod(static_cast<double>(context.samplePosition) * motionInc, juce::MathConstants<double>::twoPi);
+    nextPosition = context.samplePosition + numSamples;
+
+    // The modulators only colour signal that is there, so idling only waits for the
+    // per-channel tails and tone filters to die away.
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, inCh), numSamples,
+                                          getTailLengthSeconds(params), sr, [&]
+    {
+        return isJuicyStateSilent(tails, numChannels) && isJuicyStateSilent(lps, numChannels)
+            && isJuicyStateSilent(prevs, numChannels);
+    });
+    if (idle)
+    {
+        if (idleDetector.hasJustEntered())
+        {
+            arena.fill(tailSlot, 0.0f);
+            arena.fill(lpSlot, 0.0f);
+            arena.fill(prevSlot, 0.0f);
+        }
+
+        // Keep the free-running modulators moving in closed form so the motion picks up where
+        // it would have been when the signal returns.
+        const auto steps = static_cast<float>(numSamples);
+        const float slewDecay = std::pow(varSlew, steps);
+        variationTone = variationToneTarget + (variationTone - variationToneTarget) * slewDecay;
+        variationTransient = variationTransientTarget + (variationTransient - variationTransientTarget) * slewDecay;
+        variationTail = variationTailTarget + (variationTail - variationTailTarget) * slewDecay;
+        motionPhase = std::fmod(motionPhase + motionInc * numSamples, juce::MathConstants<double>::twoPi);
+        budgetEnv *= std::pow(budgetCoeff, steps);
+        env *= std::pow(envCoeff, steps);
+        repetition *= std::pow(0.997f, steps);
+        onsetCooldown = juce::jmax(0, onsetCooldown - numSamples);
+        buffer.clear();
+        return false;
+    }
+
+    // Samples outer, channels inner: detection, the shared modulators and the contrast-budget
+    // follower step once per sample and every channel renders from the same values.
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    const uint32_t variationSeed = seed.load(std::memory_order_relaxed);
+    const int rightChannel = juce::jmin(1, inCh - 1);
+    forEachJuicySubBlock(numSamples, [&](int start, int num)
+    {
+        context.analyseInput(buffer, start, num);
+
+        for (int i = start; i < start + num; ++i)
+        {
+            const float mono = 0.5f * (channels[0][i] + channels[rightChannel][i]);
+            const float absMono = std::abs(mono);
+            env = envCoeff * env + (1.0f - envCoeff) * absMono;
+
+            if (onsetCooldown > 0)
+                --onsetCooldown;
+            if (absMono > env * 1.35f + 0.02f && onsetCooldown <= 0)
+            {
+                const auto onsetPosition = context.samplePosition + i;
+                onsetCooldown = static_cast<int>(sr * 0.04);
+                repetition += 1.0f;
+                variationToneTarget = variationDraw(variationSeed, onsetPosition, 0) * microVar * 0.9f;
+                variationTransientTarget = variationDraw(variationSeed, onsetPosition, 1) * microVar * 0.8f;
+                variationTailTarget = variationDraw(variationSeed, onsetPosition, 2) * microVar * 0.8f;
+            }
+            repetition *= 0.997f;
+
+            const float repNorm = juce::jlimit(0.0f, 1.0f, repetition * 0.08f);
+            const float repetitionScale = 1.0f - repeatCtrl * repNorm * 0.65f;
+            const float recovery = 1.0f + repeatCtrl * (1.0f - repNorm) * 0.25f;
+
+            variationTone = varSlew * variationTone + (1.0f - varSlew) * variationToneTarget;
+            variationTransient = varSlew * variationTransient + (1.0f - varSlew) * variationTransientTarget;
+            variationTail = varSlew * variationTail + (1.0f - varSlew) * variationTailTarget;
+            motionPhase += motionInc;
+            if (motionPhase >= juce::MathConstants<double>::twoPi)
+                motionPhase -= juce::MathConstants<double>::twoPi;
+
+            const float lfoFirst = std::sin(static_cast<float>(motionPhase));
+            const float lfoOthers = std::sin(static_cast<float>(motionPhase) + 0.85f);
+            const float feedback = juce::jlimit(0.0f, 0.93f, tailFeedback + variationTail * 0.06f);
+            // The budget follower is one sample behind: it tracks the mean wet level of the
+            // channels rendered so far.
+            const float limiterGain = budgetEnv > budgetTarget ? budgetTarget / (budgetEnv + 1.0e-5f) : 1.0f;
+
+            float wetLevel = 0.0f;
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float& tail = tails[ch];
+                float& lp = lps[ch];
+                float& prev = prevs[ch];
+                float& x = channels[ch][i];
+
+                const float dry = x;
+                const float motionLfo = ch == 0 ? lfoFirst : lfoOthers;
+                const float cutoff = juce::jlimit(120.0f, 4200.0f, 900.0f + variationTone * 1100.0f * (0.6f + 0.6f * depth) + motionLfo * motionLfoDepth);
+                const float lpCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * cutoff / static_cast<float>(sr));
+                lp += lpCoeff * (dry - lp);
+                const float hp = dry - lp;
+                const float transient = dry - prev;
+                prev = dry;
+
+                const float transientBoost = 1.0f + variationTransient * 1.2f * (0.6f + 0.7f * depth) + 0.35f * microVar * motionLfo * (0.6f + 0.8f * depth);
+                const float toneShift = lp * (1.0f + variationTone * 0.65f * (0.55f + 0.7f * depth))
+                    + hp * transientBoost
+                    + transient * (0.12f + 0.30f * microVar) * (0.5f + 0.8f * depth);
+                tail = toneShift + tail * feedback;
+
+                const float wet = toneShift * repetitionScale * recovery + (0.26f + 0.24f * microVar) * (0.6f + 0.7f * depth) * tail;
+                wetLevel += std::abs(wet);
+                x = (dry + mix * (wet * limiterGain * wetBoost - dry)) * outGain;
+            }
+            budgetEnv = budgetCoeff * budgetEnv + (1.0f - budgetCoeff) * wetLevel / static_cast<float>(juce::jmax(1, numChannels));
+        }
+
+        context.analyseOutput(buffer, start, num);
+    });
+
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <cstdint>
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyStateArena.h"
+
+struct JuicyMotionParameters
+{
+    float microVar = 0.55f;
+    float motionDepth = 1.0f;
+    float repeatCtrl = 0.65f;
+    float budget = 0.5f;
+    float mix = 1.0f;
+    float outputDb = -2.0f;
+};
+
+// Onset-driven micro-variation, a slow motion LFO on the tone filter and a repetition-aware
+// contrast budget. The modulators are shared by all channels, so the kernel stays serial.
+// They advance once per sample and take their phase and random targets from the timeline
+// position, so the output does not depend on the host's block size.
+class JuicyMotionKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Returns false when the block idled; the modulators still advance, the analyzers do not.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyMotionParameters& params, const JuicyKernelContext& context) noexcept;
+
+    double getTailLengthSeconds(const JuicyMotionParameters& params) const;
+
+    // Seed of the onset variations, saved with the processor state. Safe to call from the
+    // message thread.
+    void setVariationSeed(uint32_t newSeed) noexcept { seed.store(newSeed, std::memory_order_relaxed); }
+    uint32_t getVariationSeed() const noexcept { return seed.load(std::memory_order_relaxed); }
+
+private:
+    double sr = 44100.0;
+    float env = 0.0f;
+    float repetition = 0.0f;
+    float budgetEnv = 0.0f;
+    float variationTone = 0.0f;
+    float variationTransient = 0.0f;
+    float variationTail = 0.0f;
+    float variationToneTarget = 0.0f;
+    float variationTransientTarget = 0.0f;
+    float variationTailTarget = 0.0f;
+    int onsetCooldown = 0;
+    std::atomic<uint32_t> seed { 0x93ab12f0u };
+    double motionPhase = 0.0;
+    juce::int64 nextPosition = -1; // timeline position motionPhase is valid for
+
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<float> tailSlot;
+    JuicyStateArena::Slot<float> lpSlot;
+    JuicyStateArena::Slot<float> prevSlot;
+    int numInputChannels = 0;
+    int numChannelStates = 0;
+    JuicyIdleDetector idleDetector;
+};
@@ -1,5 +1,12 @@
 #include "PluginProcessor.h"
 #include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
+#include <array>
+
+namespace
+{
+constexpr std::array<const char*, 6> stateParameterIds { "microvar", "motiondepth", "repeatctrl", "budget", "mix", "output" };
+}
 
 JuicyMotionAudioProcessor::JuicyMotionAudioProcessor()
     : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
@@ -7,25 +14,18 @@ JuicyMotionAudioProcessor::JuicyMotionAudioProcessor()
       parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
     juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
 }
 
 void JuicyMotionAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    sr = sampleRate;
-    analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    env = 0.0f;
-    repetition = 0.0f;
-    budgetEnv = 0.0f;
-    onsetCooldown = 0;
-    tailL = 0.0f;
-    tailR = 0.0f;
-    lpL = 0.0f;
-    lpR = 0.0f;
-    prevL = 0.0f;
-    prevR = 0.0f;
-    variationTone = variationTransient = variationTail = 0.0f;
-    variationToneTarget = variationTransientTarget = variationTailTarget = 0.0f;
-    motionPhase = 0.0f;
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    kernel.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    timeline.reset();
+    quality.prepare(sampleRate, JuicyQualityTier::decimatedAnalysis);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
 }
 
 void JuicyMotionAudioProcessor::releaseResources() {}
@@ -34,8 +34,12 @@ bool JuicyMotionAudioProcessor::isBusesLayoutSupported(const BusesLayout& layout
 {
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    return ! layouts.getMainOutputChannelSet().isDisabled();
+}
+
+double JuicyMotionAudioProcessor::getTailLengthSeconds() const
+{
+    return kernel.getTailLengthSeconds(readParameters());
 }
 
 void JuicyMotionAudioProcessor::pushJuicinessToHost(float score)
@@ -48,125 +52,114 @@ void JuicyMotionAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, j
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
 
     const int inCh = getTotalNumInputChannels();
     const int outCh = getTotalNumOutputChannels();
     for (int i = inCh; i < outCh; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    const auto preMetrics = analyzer.analyze(buffer);
-
-    const float microVar = *parameters.getRawParameterValue("microvar");
-    const float motionDepth = *parameters.getRawParameterValue("motiondepth");
-    const float repeatCtrl = *parameters.getRawParameterValue("repeatctrl");
-    const float contrastBudget = *parameters.getRawParameterValue("budget");
-    const float mix = *parameters.getRawParameterValue("mix");
-    const float outDb = *parameters.getRawParameterValue("output");
-    const float outGain = juce::Decibels::decibelsToGain(outDb);
-
-    const float envCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.015));
-    const float budgetCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.080));
-    const float tailFeedback = juce::jmap(repeatCtrl, 0.0f, 1.0f, 0.15f, 0.88f);
-    const float depth = juce::jlimit(0.0f, 2.0f, motionDepth);
-    const float motionRateHz = juce::jmap(microVar, 0.0f, 1.0f, 0.25f, 2.0f) * juce::jmap(depth, 0.0f, 2.0f, 0.75f, 1.6f);
-    const float motionInc = (2.0f * juce::MathConstants<float>::pi * motionRateHz) / static_cast<float>(sr);
-    const float varSlew = std::exp(-1.0f / static_cast<float>(sr * 0.020));
-
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
-    {
-        const float mono = 0.5f * (buffer.getSample(0, i) + buffer.getSample(juce::jmin(1, inCh - 1), i));
-        const float absMono = std::abs(mono);
-        env = envCoeff * env + (1.0f - envCoeff) * absMono;
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
+
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    context.samplePosition = timeline.beginBlock(getPlayHead(), buffer.getNumSamples());
+    if (! kernel.process(buffer, params, context))
+        return;
+
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis, [this] { return postAnalyzer.finishBlock(); });
+    publishMetrics(preMetrics, metrics);
+}
 
-        if (onsetCooldown > 0)
-            --onsetCooldown;
-        if (absMono > env * 1.35f + 0.02f && onsetCooldown <= 0)
-        {
-            onsetCooldown = static_cast<int>(sr * 0.04);
-            repetition += 1.0f;
-            rng = 1664525u * rng + 1013904223u;
-            variationToneTarget = ((static_cast<float>((rng >> 7) & 0x7FFF) / 16384.0f) - 1.0f) * microVar * 0.9f;
-            rng = 1664525u * rng + 1013904223u;
-            variationTransientTarget = ((static_cast<float>((rng >> 9) & 0x7FFF) / 16384.0f) - 1.0f) * microVar * 0.8f;
-            rng = 1664525u * rng + 1013904223u;
-            variationTailTarget = ((static_cast<float>((rng >> 11) & 0x7FFF) / 16384.0f) - 1.0f) * microVar * 0.8f;
-        }
-        repetition *= 0.997f;
+void JuicyMotionAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
+    {
+        processBlock(buffer, midiMessages);
+        return;
     }
 
-    const float repNorm = juce::jlimit(0.0f, 1.0f, repetition * 0.08f);
-    const float repetitionScale = 1.0f - repeatCtrl * repNorm * 0.65f;
-    const float recovery = 1.0f + repeatCtrl * (1.0f - repNorm) * 0.25f;
-
-    for (int ch = 0; ch < inCh; ++ch)
+    if (bypass.runsBypassMeter())
     {
-        auto* x = buffer.getWritePointer(ch);
-        float& tail = (ch == 0 ? tailL : tailR);
-        float& lp = (ch == 0 ? lpL : lpR);
-        float& prev = (ch == 0 ? prevL : prevR);
-
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            variationTone = varSlew * variationTone + (1.0f - varSlew) * variationToneTarget;
-            variationTransient = varSlew * variationTransient + (1.0f - varSlew) * variationTransientTarget;
-            variationTail = varSlew * variationTail + (1.0f - varSlew) * variationTailTarget;
-            motionPhase += motionInc;
-            if (motionPhase > 2.0f * juce::MathConstants<float>::pi)
-                motionPhase -= 2.0f * juce::MathConstants<float>::twoPi;
-
-            const float dry = x[i];
-            const float motionLfo = std::sin(motionPhase + (ch == 0 ? 0.0f : 0.85f));
-            const float motionLfoDepth = (250.0f + 550.0f * microVar) * (0.5f + 0.9f * depth);
-            const float cutoff = juce::jlimit(120.0f, 4200.0f, 900.0f + variationTone * 1100.0f * (0.6f + 0.6f * depth) + motionLfo * motionLfoDepth);
-            const float lpCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * cutoff / static_cast<float>(sr));
-            lp += lpCoeff * (dry - lp);
-            const float hp = dry - lp;
-            const float transient = dry - prev;
-            prev = dry;
-
-            const float transientBoost = 1.0f + variationTransient * 1.2f * (0.6f + 0.7f * depth) + 0.35f * microVar * motionLfo * (0.6f + 0.8f * depth);
-            const float toneShift = lp * (1.0f + variationTone * 0.65f * (0.55f + 0.7f * depth))
-                + hp * transientBoost
-                + transient * (0.12f + 0.30f * microVar) * (0.5f + 0.8f * depth);
-            tail = toneShift + tail * juce::jlimit(0.0f, 0.93f, tailFeedback + variationTail * 0.06f);
-
-            float wet = toneShift * repetitionScale * recovery + (0.26f + 0.24f * microVar) * (0.6f + 0.7f * depth) * tail;
-            budgetEnv = budgetCoeff * budgetEnv + (1.0f - budgetCoeff) * std::abs(wet);
-            const float budgetTarget = juce::jmap(contrastBudget, 0.0f, 1.0f, 0.8f, 0.25f);
-            const float limiterGain = budgetEnv > budgetTarget ? budgetTarget / (budgetEnv + 1.0e-5f) : 1.0f;
-            wet *= limiterGain;
-
-            const float wetBoost = 1.0f + 0.9f * microVar * (0.55f + 0.9f * depth);
-            x[i] = (dry + mix * (wet * wetBoost - dry)) * outGain;
-        }
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, metrics);
     }
+}
+
+void JuicyMotionAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.punch, std::memory_order_relaxed);
+    latestRichness.store(post.richness, std::memory_order_relaxed);
+    latestClarity.store(post.clarity, std::memory_order_relaxed);
+    latestWidth.store(post.width, std::memory_order_relaxed);
+    latestMonoSafety.store(post.monoSafety, std::memory_order_relaxed);
+    pushJuicinessToHost(post.score);
+}
 
-    const auto metrics = analyzer.analyze(buffer);
-    latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-    latestPostScore.store(metrics.score, std::memory_order_relaxed);
-    latestScore.store(metrics.score, std::memory_order_relaxed);
-    latestPunch.store(metrics.punch, std::memory_order_relaxed);
-    latestRichness.store(metrics.richness, std::memory_order_relaxed);
-    latestClarity.store(metrics.clarity, std::memory_order_relaxed);
-    latestWidth.store(metrics.width, std::memory_order_relaxed);
-    latestMonoSafety.store(metrics.monoSafety, std::memory_order_relaxed);
-    pushJuicinessToHost(metrics.score);
+void JuicyMotionAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+}
+
+JuicyMotionParameters JuicyMotionAudioProcessor::readParameters() const
+{
+    JuicyMotionParameters p;
+    p.microVar = *parameters.getRawParameterValue("microvar");
+    p.motionDepth = *parameters.getRawParameterValue("motiondepth");
+    p.repeatCtrl = *parameters.getRawParameterValue("repeatctrl");
+    p.budget = *parameters.getRawParameterValue("budget");
+    p.mix = *parameters.getRawParameterValue("mix");
+    p.outputDb = *parameters.getRawParameterValue("output");
+    return p;
 }
 
 juce::AudioProcessorEditor* JuicyMotionAudioProcessor::createEditor()
 {
-    return new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Motion");
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Motion");
+    editor->setStageProfiler(&profiler);
+    return editor;
 }
 
 void JuicyMotionAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    juce::MemoryBlock seed;
+    {
+        juce::MemoryOutputStream out(seed, false);
+        out.writeInt(static_cast<int>(kernel.getVariationSeed()));
+    }
+    writeJuicyState(destData, parameters, stateParameterIds, seed);
 }
 
 void JuicyMotionAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    juce::MemoryBlock seed;
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds, &seed))
+    {
+        if (seed.getSize() >= sizeof(juce::int32))
+        {
+            juce::MemoryInputStream in(seed, false);
+            kernel.setVariationSeed(static_cast<uint32_t>(in.readInt()));
+        }
+        return;
+    }
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState != nullptr && xmlState->hasTagName(parameters.state.getType()))
         parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
@@ -183,6 +176,7 @@ JuicinessMetrics JuicyMotionAudioProcessor::getLatestMetrics() const noexcept
     m.clarity = latestClarity.load(std::memory_order_relaxed);
     m.width = latestWidth.load(std::memory_order_relaxed);
     m.monoSafety = latestMonoSafety.load(std::memory_order_relaxed);
+    m.qualityTier = static_cast<int>(quality.getTier());
     return m;
 }
 
@@ -196,10 +190,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicyMotionAudioProcessor::c
     p.push_back(std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 1.0f));
     p.push_back(std::make_unique<juce::AudioParameterFloat>("output", "Output (dB)", -18.0f, 18.0f, -2.0f));
     p.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    p.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                            juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                .withCategory(juce::AudioProcessorParameter::otherMeter)));
     return { p.begin(), p.end() };
 }
 
+#if ! JUICY_BUNDLED_PROCESSORS
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new JuicyMotionAudioProcessor();
 }
+#endif
@@ -3,8 +3,13 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <atomic>
 #include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "../../shared/JuicyTimeline.h"
+#include "JuicyMotionKernel.h"
 
-class JuicyMotionAudioProcessor : public juce::AudioProcessor
+class JuicyMotionAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor
 {
 public:
     JuicyMotionAudioProcessor();
@@ -14,6 +19,7 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -22,7 +28,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -33,13 +39,19 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
     JuicinessMetrics getLatestMetrics() const noexcept;
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
 
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicyMotionParameters readParameters() const;
 
     juce::AudioProcessorValueTreeState parameters;
-    JuicinessAnalyzer analyzer;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
     juce::RangedAudioParameter* juicinessParameter = nullptr;
 
     std::atomic<float> latestPreScore { 0.0f };
@@ -51,25 +63,11 @@ private:
     std::atomic<float> latestWidth { 0.0f };
     std::atomic<float> latestMonoSafety { 1.0f };
 
-    double sr = 44100.0;
-    float env = 0.0f;
-    float repetition = 0.0f;
-    float budgetEnv = 0.0f;
-    float variationTone = 0.0f;
-    float variationTransient = 0.0f;
-    float variationTail = 0.0f;
-    float variationToneTarget = 0.0f;
-    float variationTransientTarget = 0.0f;
-    float variationTailTarget = 0.0f;
-    int onsetCooldown = 0;
-    uint32_t rng = 0x93ab12f0u;
-    float tailL = 0.0f;
-    float tailR = 0.0f;
-    float lpL = 0.0f;
-    float lpR = 0.0f;
-    float prevL = 0.0f;
-    float prevR = 0.0f;
-    float motionPhase = 0.0f;
+    JuicyMotionKernel kernel;
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
+    JuicyTimeline timeline;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyMotionAudioProcessor)
 };
@@ -0,0 +1,122 @@
+#include "JuicyPunchKernel.h"
+#include "../../shared/JuicyChannelGroups.h"
+#include "../../shared/JuicySubBlocks.h"
+
+void JuicyPunchKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    numEnvelopes = juce::jmax(1, layout.size());
+
+    arena.beginLayout();
+    fastEnvSlot = arena.reserveHot<float>(static_cast<size_t>(numEnvelopes));
+    slowEnvSlot = arena.reserveHot<float>(static_cast<size_t>(numEnvelopes));
+    arena.allocate();
+    idleDetector.reset();
+}
+
+void JuicyPunchKernel::reset() noexcept
+{
+    arena.fill(fastEnvSlot, 0.0f);
+    arena.fill(slowEnvSlot, 0.0f);
+    idleDetector.reset();
+}
+
+void JuicyPunchKernel::beginBlock(const JuicyPunchParameters& params, const JuicyKernelContext& context, int numSamples) noexcept
+{
+    juce::ignoreUnused(context, numSamples);
+    k.fastCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.0015));
+    k.slowCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.110));
+    k.transientExponent = juce::jmap(params.slam, 0.0f, 1.0f, 0.95f, 0.55f);
+    k.punchScale = params.punch * 12.0f + params.slam * 22.0f;
+    k.sustainScale = params.sustain * 4.0f + params.slam * 1.5f;
+    k.drive = 1.0f + params.clip * 8.0f + params.slam * 4.0f;
+    k.driveNorm = std::tanh(k.drive);
+    k.clip = params.clip;
+    k.mix = params.mix;
+    k.outGain = juce::Decibels::decibelsToGain(params.outputDb);
+}
+
+bool JuicyPunchKernel::isStateSilent() const noexcept
+{
+    const auto* fastEnv = arena.get(fastEnvSlot);
+    const auto* slowEnv = arena.get(slowEnvSlot);
+    return fastEnv == nullptr || (isJuicyStateSilent(fastEnv, numEnvelopes) && isJuicyStateSilent(slowEnv, numEnvelopes));
+}
+
+bool JuicyPunchKernel::process(juce::AudioBuffer<float>& buffer, const JuicyPunchParameters& params, const JuicyKernelContext& context) noexcept
+{
+    beginBlock(params, context, buffer.getNumSamples());
+
+    // Silence in, silence out: once the envelopes have let go there is nothing to shape.
+    const int totalChannels = juce::jmin(buffer.getNumChannels(), numEnvelopes);
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, totalChannels), buffer.getNumSamples(),
+                                          juicyDecaySeconds(k.slowCoeff, sr), sr, [this] { return isStateSilent(); });
+    if (idle)
+    {
+        if (idleDetector.hasJustEntered())
+        {
+            arena.fill(fastEnvSlot, 0.0f);
+            arena.fill(slowEnvSlot, 0.0f);
+        }
+        buffer.clear();
+        return false;
+    }
+
+    render(buffer, 0, buffer.getNumSamples(), context);
+    return true;
+}
+
+void JuicyPunchKernel::render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept
+{
+    auto* fastEnv = arena.get(fastEnvSlot);
+    auto* slowEnv = arena.get(slowEnvSlot);
+    const int numChannels = fastEnv != nullptr ? juce::jmin(buffer.getNumChannels(), numEnvelopes) : 0;
+
+    // Channel groups are independent, so large beds can spread them over the worker pool. The
+    // first group holds the channels the analyzers read and keeps both analyses fused.
+    auto processGroup = [&](int group)
+    {
+        const int firstChannel = group * juicyChannelGroupSize;
+        const int lastChannel = juce::jmin(numChannels, firstChannel + juicyChannelGroupSize);
+
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num)
+        {
+            const int start = startSample + subStart;
+            if (group == 0)
+                context.analyseInput(buffer, start, num);
+
+            for (int ch = firstChannel; ch < lastChannel; ++ch)
+            {
+                auto* x = buffer.getWritePointer(ch, start);
+                float fEnv = fastEnv[ch];
+                float sEnv = slowEnv[ch];
+                for (int i = 0; i < num; ++i)
+                {
+                    const float dry = x[i];
+                    const float adry = std::abs(dry);
+                    fEnv = (1.0f - k.fastCoeff) * adry + k.fastCoeff * fEnv;
+                    sEnv = (1.0f - k.slowCoeff) * adry + k.slowCoeff * sEnv;
+
+                    const float transient = juce::jmax(0.0f, fEnv - sEnv);
+                    const float transientCurve = std::pow(transient, k.transientExponent);
+                    const float punchGain = 1.0f + k.punchScale * transientCurve;
+                    const float sustainGain = 1.0f + k.sustainScale * juce::jmax(0.0f, sEnv - transient * 0.6f);
+
+                    float wet = dry * punchGain * sustainGain;
+                    const float soft = std::tanh(wet * k.drive) / k.driveNorm;
+                    const float hard = juce::jlimit(-0.95f, 0.95f, wet * (1.0f + k.clip * 2.0f));
+                    wet = soft + k.clip * (hard - soft);
+
+                    x[i] = (dry + k.mix * (wet - dry)) * k.outGain;
+                }
+                fastEnv[ch] = fEnv;
+                slowEnv[ch] = sEnv;
+            }
+
+            if (group == 0)
+                context.analyseOutput(buffer, start, num);
+        });
+    };
+
+    context.forEachTask(numChannels, juce::jmax(1, juicyChannelGroups(numChannels)), processGroup);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyStateArena.h"
+
+// Plain parameter values, defaults as in the plugin's parameter layout.
+struct JuicyPunchParameters
+{
+    float punch = 0.9f;
+    float sustain = 0.35f;
+    float slam = 0.65f;
+    float clip = 0.25f;
+    float mix = 1.0f;
+    float outputDb = -4.0f;
+};
+
+// Transient shaper into a soft/hard clipper, for any number of channels.
+class JuicyPunchKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Renders one block in place. Returns false when the block took the idle path; the analyzers
+    // were not fed then.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyPunchParameters& params, const JuicyKernelContext& context) noexcept;
+
+    // process() without the idle path, split so a chain of kernels can map its parameters once
+    // per host block and then render slice by slice. render() covers
+    // [startSample, startSample + numSamples) of the block beginBlock() was called for.
+    void beginBlock(const JuicyPunchParameters& params, const JuicyKernelContext& context, int numSamples) noexcept;
+    void render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept;
+    bool isStateSilent() const noexcept;
+
+    double getTailLengthSeconds(const JuicyPunchParameters&) const { return 0.0; }
+
+private:
+    struct BlockCoefficients
+    {
+        float fastCoeff = 0.0f;
+        float slowCoeff = 0.0f;
+        float transientExponent = 1.0f;
+        float punchScale = 0.0f;
+        float sustainScale = 0.0f;
+        float drive = 1.0f;
+        float driveNorm = 1.0f; // tanh(drive)
+        float clip = 0.0f;
+        float mix = 1.0f;
+        float outGain = 1.0f;
+    };
+
+    BlockCoefficients k;
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<float> fastEnvSlot;
+    JuicyStateArena::Slot<float> slowEnvSlot;
+    int numEnvelopes = 0;
+    JuicyIdleDetector idleDetector;
+    double sr = 44100.0;
+};
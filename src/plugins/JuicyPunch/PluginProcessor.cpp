@@ -1,9 +1,12 @@
 #include "PluginProcessor.h"
 #include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
 #include <array>
 
 namespace
 {
+constexpr std::array<const char*, 6> stateParameterIds { "punch", "sustain", "slam", "clip", "mix", "output" };
+
 struct PunchPreset
 {
     const char* name;
@@ -30,15 +33,23 @@ JuicyPunchAudioProcessor::JuicyPunchAudioProcessor()
       parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
     juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
     setCurrentProgram(0);
 }
 
 void JuicyPunchAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    sr = sampleRate;
-    analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    fastEnv.assign(static_cast<size_t>(juce::jmax(1, getTotalNumOutputChannels())), 0.0f);
-    slowEnv.assign(static_cast<size_t>(juce::jmax(1, getTotalNumOutputChannels())), 0.0f);
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    kernel.prepare(sampleRate, layout);
+    quality.prepare(sampleRate, JuicyQualityTier::decimatedAnalysis);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
+
+    const int threshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && layout.size() >= threshold)
+        workerPool->start();
 }
 
 void JuicyPunchAudioProcessor::releaseResources()
@@ -49,8 +60,7 @@ bool JuicyPunchAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
 {
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    return ! layouts.getMainOutputChannelSet().isDisabled();
 }
 
 void JuicyPunchAudioProcessor::pushJuicinessToHost(float score)
@@ -65,78 +75,102 @@ void JuicyPunchAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, ju
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
 
     const int totalInputChannels = getTotalNumInputChannels();
     const int totalOutputChannels = getTotalNumOutputChannels();
     for (int i = totalInputChannels; i < totalOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    const float punchAmt = *parameters.getRawParameterValue("punch");
-    const float sustainAmt = *parameters.getRawParameterValue("sustain");
-    const float slamAmt = *parameters.getRawParameterValue("slam");
-    const float clipAmt = *parameters.getRawParameterValue("clip");
-    const float mix = *parameters.getRawParameterValue("mix");
-    const float outDb = *parameters.getRawParameterValue("output");
-    const float outGain = juce::Decibels::decibelsToGain(outDb);
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
+
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.workerPool = &workerPool.get();
+    context.parallelChannelThreshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    if (! kernel.process(buffer, params, context))
+        return;
 
-    const auto preMetrics = analyzer.analyze(buffer);
-    const float fastCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.0015));
-    const float slowCoeff = std::exp(-1.0f / static_cast<float>(sr * 0.110));
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis, [this] { return postAnalyzer.finishBlock(); });
+    publishMetrics(preMetrics, metrics);
+}
 
-    for (int ch = 0; ch < totalInputChannels; ++ch)
+void JuicyPunchAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
     {
-        auto* x = buffer.getWritePointer(ch);
-        float& fEnv = fastEnv[static_cast<size_t>(ch)];
-        float& sEnv = slowEnv[static_cast<size_t>(ch)];
+        processBlock(buffer, midiMessages);
+        return;
+    }
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            const float dry = x[i];
-            const float adry = std::abs(dry);
-            fEnv = (1.0f - fastCoeff) * adry + fastCoeff * fEnv;
-            sEnv = (1.0f - slowCoeff) * adry + slowCoeff * sEnv;
-
-            const float transient = juce::jmax(0.0f, fEnv - sEnv);
-            const float transientCurve = std::pow(transient, juce::jmap(slamAmt, 0.0f, 1.0f, 0.95f, 0.55f));
-            const float punchGain = 1.0f + (punchAmt * 12.0f + slamAmt * 22.0f) * transientCurve;
-            const float sustainGain = 1.0f + (sustainAmt * 4.0f + slamAmt * 1.5f) * juce::jmax(0.0f, sEnv - transient * 0.6f);
-
-            float wet = dry * punchGain * sustainGain;
-            const float drive = 1.0f + clipAmt * 8.0f + slamAmt * 4.0f;
-            const float soft = std::tanh(wet * drive) / std::tanh(drive);
-            const float hard = juce::jlimit(-0.95f, 0.95f, wet * (1.0f + clipAmt * 2.0f));
-            wet = soft + clipAmt * (hard - soft);
-
-            x[i] = (dry + mix * (wet - dry)) * outGain;
-        }
+    if (bypass.runsBypassMeter())
+    {
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, metrics);
     }
+}
+
+void JuicyPunchAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.punch, std::memory_order_relaxed);
+    latestRichness.store(post.richness, std::memory_order_relaxed);
+    latestClarity.store(post.clarity, std::memory_order_relaxed);
+    latestWidth.store(post.width, std::memory_order_relaxed);
+    latestMonoSafety.store(post.monoSafety, std::memory_order_relaxed);
+    pushJuicinessToHost(post.score);
+}
+
+void JuicyPunchAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+}
 
-    auto metrics = analyzer.analyze(buffer);
-    latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-    latestPostScore.store(metrics.score, std::memory_order_relaxed);
-    latestScore.store(metrics.score, std::memory_order_relaxed);
-    latestPunch.store(metrics.punch, std::memory_order_relaxed);
-    latestRichness.store(metrics.richness, std::memory_order_relaxed);
-    latestClarity.store(metrics.clarity, std::memory_order_relaxed);
-    latestWidth.store(metrics.width, std::memory_order_relaxed);
-    latestMonoSafety.store(metrics.monoSafety, std::memory_order_relaxed);
-    pushJuicinessToHost(metrics.score);
+JuicyPunchParameters JuicyPunchAudioProcessor::readParameters() const
+{
+    JuicyPunchParameters p;
+    p.punch = *parameters.getRawParameterValue("punch");
+    p.sustain = *parameters.getRawParameterValue("sustain");
+    p.slam = *parameters.getRawParameterValue("slam");
+    p.clip = *parameters.getRawParameterValue("clip");
+    p.mix = *parameters.getRawParameterValue("mix");
+    p.outputDb = *parameters.getRawParameterValue("output");
+    return p;
 }
 
 juce::AudioProcessorEditor* JuicyPunchAudioProcessor::createEditor()
 {
-    return new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Punch");
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Punch");
+    editor->setStageProfiler(&profiler);
+    return editor;
 }
 
 void JuicyPunchAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    writeJuicyState(destData, parameters, stateParameterIds);
 }
 
 void JuicyPunchAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds))
+        return;
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState == nullptr)
         return;
@@ -198,6 +232,7 @@ JuicinessMetrics JuicyPunchAudioProcessor::getLatestMetrics() const noexcept
     m.clarity = latestClarity.load(std::memory_order_relaxed);
     m.width = latestWidth.load(std::memory_order_relaxed);
     m.monoSafety = latestMonoSafety.load(std::memory_order_relaxed);
+    m.qualityTier = static_cast<int>(quality.getTier());
     return m;
 }
 
@@ -211,10 +246,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicyPunchAudioProcessor::cr
     params.push_back(std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 1.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("output", "Output (dB)", -24.0f, 18.0f, -4.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                                 juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                     .withCategory(juce::AudioProcessorParameter::otherMeter)));
     return { params.begin(), params.end() };
 }
 
+#if ! JUICY_BUNDLED_PROCESSORS
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new JuicyPunchAudioProcessor();
 }
+#endif
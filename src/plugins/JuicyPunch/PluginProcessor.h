@@ -3,8 +3,13 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <atomic>
 #include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "../../shared/JuicyWorkerPool.h"
+#include "JuicyPunchKernel.h"
 
-class JuicyPunchAudioProcessor : public juce::AudioProcessor
+class JuicyPunchAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor, public JuicyParallelProcessor
 {
 public:
     JuicyPunchAudioProcessor();
@@ -14,6 +19,7 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -22,7 +28,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override { return kernel.getTailLengthSeconds(readParameters()); }
 
     int getNumPrograms() override;
     int getCurrentProgram() override;
@@ -33,13 +39,20 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
     JuicinessMetrics getLatestMetrics() const noexcept;
+    void setParallelChannelThreshold(int numChannels) noexcept override { parallelChannelThreshold.store(numChannels); }
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
 
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicyPunchParameters readParameters() const;
 
     juce::AudioProcessorValueTreeState parameters;
-    JuicinessAnalyzer analyzer;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
     juce::RangedAudioParameter* juicinessParameter = nullptr;
     std::atomic<float> latestPreScore { 0.0f };
     std::atomic<float> latestPostScore { 0.0f };
@@ -50,9 +63,12 @@ private:
     std::atomic<float> latestWidth { 0.0f };
     std::atomic<float> latestMonoSafety { 1.0f };
 
-    std::vector<float> fastEnv;
-    std::vector<float> slowEnv;
-    double sr = 44100.0;
+    JuicyPunchKernel kernel;
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
+    juce::SharedResourcePointer<JuicyWorkerPool> workerPool;
+    std::atomic<int> parallelChannelThreshold { juicyDefaultParallelThreshold };
     int currentProgram = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyPunchAudioProcessor)
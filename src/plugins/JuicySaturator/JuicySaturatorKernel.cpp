@@ -0,0 +1,160 @@
+#include "JuicySaturatorKernel.h"
+#include "../../shared/JuicyChannelGroups.h"
+#include "../../shared/JuicySubBlocks.h"
+
+namespace
+{
+// Antiderivative of tanh, log(cosh(x)), written so it stays finite for any drive.
+double logCosh(double x) noexcept
+{
+    const double a = std::abs(x);
+    return a + std::log1p(std::exp(-2.0 * a)) - 0.69314718055994530942;
+}
+
+// First-order antiderivative anti-aliasing: tanh averaged over the segment from the previous
+// input to this one. Suppresses the folded-back harmonics of heavy drive at the price of a
+// half-sample delay and two transcendental calls, so only offline renders take it. The dry
+// signal mixed against it is averaged the same way, which delays it by the same half sample.
+float tanhAntialiased(float x, float previous) noexcept
+{
+    const double dx = static_cast<double>(x) - static_cast<double>(previous);
+    if (std::abs(dx) < 1.0e-5)
+        return std::tanh(0.5f * (x + previous));
+    return static_cast<float>((logCosh(x) - logCosh(previous)) / dx);
+}
+}
+
+void JuicySaturatorKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    numToneStates = juce::jmax(1, layout.size());
+
+    arena.beginLayout();
+    toneSlot = arena.reserveHot<float>(static_cast<size_t>(numToneStates));
+    shaperInputSlot = arena.reserveHot<float>(static_cast<size_t>(numToneStates));
+    previousDrySlot = arena.reserveHot<float>(static_cast<size_t>(numToneStates));
+    arena.allocate();
+    idleDetector.reset();
+}
+
+void JuicySaturatorKernel::reset() noexcept
+{
+    arena.fill(toneSlot, 0.0f);
+    arena.fill(shaperInputSlot, 0.0f);
+    arena.fill(previousDrySlot, 0.0f);
+    idleDetector.reset();
+}
+
+double JuicySaturatorKernel::getTailLengthSeconds(const JuicySaturatorParameters& params) const
+{
+    // Only the tone filter keeps ringing once the input stops.
+    const double cutoff = juce::jmap(static_cast<double>(params.tone), 0.0, 1.0, 2500.0, 16000.0);
+    return juicyDecaySeconds(std::exp(-2.0 * juce::MathConstants<double>::pi * cutoff / sr), sr);
+}
+
+void JuicySaturatorKernel::beginBlock(const JuicySaturatorParameters& params, const JuicyKernelContext& context, int numSamples) noexcept
+{
+    juce::ignoreUnused(numSamples);
+    const float cutoff = juce::jmap(params.tone, 0.0f, 1.0f, 2500.0f, 16000.0f);
+    k.asym = params.asymmetry;
+    k.inGain = juce::Decibels::decibelsToGain(params.driveDb);
+    k.outGain = juce::Decibels::decibelsToGain(params.outputDb);
+    k.toneCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * cutoff / static_cast<float>(sr));
+    k.mix = params.mix;
+    k.antialiasShaper = context.offlineQuality;
+}
+
+bool JuicySaturatorKernel::isStateSilent() const noexcept
+{
+    const auto* toneState = arena.get(toneSlot);
+    return toneState == nullptr || isJuicyStateSilent(toneState, numToneStates);
+}
+
+bool JuicySaturatorKernel::process(juce::AudioBuffer<float>& buffer, const JuicySaturatorParameters& params, const JuicyKernelContext& context) noexcept
+{
+    beginBlock(params, context, buffer.getNumSamples());
+
+    const int totalChannels = juce::jmin(buffer.getNumChannels(), numToneStates);
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, totalChannels), buffer.getNumSamples(),
+                                          getTailLengthSeconds(params), sr, [this] { return isStateSilent(); });
+    if (idle)
+    {
+        if (idleDetector.hasJustEntered())
+        {
+            arena.fill(toneSlot, 0.0f);
+            arena.fill(shaperInputSlot, 0.0f);
+            arena.fill(previousDrySlot, 0.0f);
+        }
+        buffer.clear();
+        return false;
+    }
+
+    render(buffer, 0, buffer.getNumSamples(), context);
+    return true;
+}
+
+void JuicySaturatorKernel::render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept
+{
+    auto* toneState = arena.get(toneSlot);
+    auto* shaperInput = arena.get(shaperInputSlot);
+    auto* previousDry = arena.get(previousDrySlot);
+    const int numChannels = toneState != nullptr ? juce::jmin(buffer.getNumChannels(), numToneStates) : 0;
+
+    // Each channel group is independent; the first one carries the analyses. Both render paths
+    // share the mapping in beginBlock() and differ only in how the shaper is evaluated.
+    const ChannelRenderer renderShaped = k.antialiasShaper ? &renderChannel<true> : &renderChannel<false>;
+    auto processGroup = [&](int group)
+    {
+        const int firstChannel = group * juicyChannelGroupSize;
+        const int lastChannel = juce::jmin(numChannels, firstChannel + juicyChannelGroupSize);
+
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num)
+        {
+            const int start = startSample + subStart;
+            if (group == 0)
+                context.analyseInput(buffer, start, num);
+
+            for (int ch = firstChannel; ch < lastChannel; ++ch)
+                renderShaped(buffer.getWritePointer(ch, start), num, toneState[ch], shaperInput[ch], previousDry[ch], k);
+
+            if (group == 0)
+                context.analyseOutput(buffer, start, num);
+        });
+    };
+
+    context.forEachTask(numChannels, juce::jmax(1, juicyChannelGroups(numChannels)), processGroup);
+}
+
+template <bool antialiased>
+void JuicySaturatorKernel::renderChannel(float* x, int num, float& toneState, float& previousShaperInput, float& previousInput,
+                                         const BlockCoefficients& k) noexcept
+{
+    float state = toneState;
+    float previousSkewed = previousShaperInput;
+    float previousDry = previousInput;
+    for (int i = 0; i < num; ++i)
+    {
+        const float input = x[i];
+        const float driven = input * k.inGain;
+        const float skewed = driven + k.asym * driven * driven;
+        float soft, dry;
+        if constexpr (antialiased)
+        {
+            soft = tanhAntialiased(skewed, previousSkewed);
+            dry = 0.5f * (input + previousDry);
+        }
+        else
+        {
+            soft = std::tanh(skewed);
+            dry = input;
+        }
+        previousSkewed = skewed;
+        previousDry = input;
+        state += k.toneCoeff * (soft - state);
+        const float wet = state * k.outGain;
+        x[i] = dry + k.mix * (wet - dry);
+    }
+    toneState = state;
+    previousShaperInput = previousSkewed;
+    previousInput = previousDry;
+}
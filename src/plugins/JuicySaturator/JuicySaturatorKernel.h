@@ -0,0 +1,62 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyStateArena.h"
+
+struct JuicySaturatorParameters
+{
+    float driveDb = 6.0f;
+    float asymmetry = 0.1f;
+    float tone = 0.55f;
+    float mix = 1.0f;
+    float outputDb = -3.0f;
+};
+
+// Asymmetric tanh shaper followed by a one-pole tone filter. Offline contexts evaluate the
+// shaper with antiderivative anti-aliasing and delay the dry signal to match it.
+class JuicySaturatorKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Returns false when the block was rendered as silence without feeding the analyzers.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicySaturatorParameters& params, const JuicyKernelContext& context) noexcept;
+
+    // The two halves of process() past the idle check, for chains that map every stage's
+    // parameters once per host block and render slice by slice.
+    void beginBlock(const JuicySaturatorParameters& params, const JuicyKernelContext& context, int numSamples) noexcept;
+    void render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept;
+    bool isStateSilent() const noexcept;
+
+    double getTailLengthSeconds(const JuicySaturatorParameters& params) const;
+
+private:
+    struct BlockCoefficients
+    {
+        float asym = 0.0f;
+        float inGain = 1.0f;
+        float outGain = 1.0f;
+        float toneCoeff = 0.0f;
+        float mix = 1.0f;
+        bool antialiasShaper = false;
+    };
+
+    // A sub-block of one channel. The offline shaper gets its own instantiation, so render()
+    // picks the loop once per block instead of branching per sample.
+    template <bool antialiased>
+    static void renderChannel(float* x, int num, float& toneState, float& previousShaperInput, float& previousInput,
+                              const BlockCoefficients& k) noexcept;
+    using ChannelRenderer = void (*)(float*, int, float&, float&, float&, const BlockCoefficients&) noexcept;
+
+    BlockCoefficients k;
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<float> toneSlot;
+    JuicyStateArena::Slot<float> shaperInputSlot;
+    JuicyStateArena::Slot<float> previousDrySlot;
+    int numToneStates = 0;
+    JuicyIdleDetector idleDetector;
+    double sr = 44100.0;
+};
@@ -1,9 +1,12 @@
 #include "PluginProcessor.h"
 #include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
 #include <array>
 
 namespace
 {
+constexpr std::array<const char*, 5> stateParameterIds { "drive", "asymmetry", "tone", "mix", "output" };
+
 struct SaturatorPreset
 {
     const char* name;
@@ -29,13 +32,23 @@ JuicySaturatorAudioProcessor::JuicySaturatorAudioProcessor()
       parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
     juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
     setCurrentProgram(0);
 }
 
 void JuicySaturatorAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    toneState.assign(static_cast<size_t>(juce::jmax(1, getTotalNumOutputChannels())), 0.0f);
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    kernel.prepare(sampleRate, layout);
+    quality.prepare(sampleRate, JuicyQualityTier::decimatedAnalysis);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
+
+    const int threshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && layout.size() >= threshold)
+        workerPool->start();
 }
 
 void JuicySaturatorAudioProcessor::releaseResources()
@@ -46,8 +59,12 @@ bool JuicySaturatorAudioProcessor::isBusesLayoutSupported(const BusesLayout& lay
 {
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    return ! layouts.getMainOutputChannelSet().isDisabled();
+}
+
+double JuicySaturatorAudioProcessor::getTailLengthSeconds() const
+{
+    return kernel.getTailLengthSeconds(readParameters());
 }
 
 void JuicySaturatorAudioProcessor::pushJuicinessToHost(float score)
@@ -62,67 +79,101 @@ void JuicySaturatorAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
 
     const int totalInputChannels = getTotalNumInputChannels();
     const int totalOutputChannels = getTotalNumOutputChannels();
     for (int i = totalInputChannels; i < totalOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    const float driveDb = *parameters.getRawParameterValue("drive");
-    const float asym = *parameters.getRawParameterValue("asymmetry");
-    const float tone = *parameters.getRawParameterValue("tone");
-    const float mix = *parameters.getRawParameterValue("mix");
-    const float outputDb = *parameters.getRawParameterValue("output");
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
 
-    const auto preMetrics = analyzer.analyze(buffer);
-    const float inGain = juce::Decibels::decibelsToGain(driveDb);
-    const float outGain = juce::Decibels::decibelsToGain(outputDb);
-    const float cutoff = juce::jmap(tone, 0.0f, 1.0f, 2500.0f, 16000.0f);
-    const float toneCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * cutoff / static_cast<float>(getSampleRate()));
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.workerPool = &workerPool.get();
+    context.parallelChannelThreshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    if (! kernel.process(buffer, params, context))
+        return;
 
-    for (int ch = 0; ch < totalInputChannels; ++ch)
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis, [this] { return postAnalyzer.finishBlock(); });
+    publishMetrics(preMetrics, metrics);
+}
+
+void JuicySaturatorAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
     {
-        auto* x = buffer.getWritePointer(ch);
-        auto& state = toneState[static_cast<size_t>(ch)];
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            const float dry = x[i];
-            const float driven = dry * inGain;
-            const float skewed = driven + asym * driven * driven;
-            const float soft = std::tanh(skewed);
-            state += toneCoeff * (soft - state);
-            const float toned = state;
-            const float wet = toned * outGain;
-            x[i] = dry + mix * (wet - dry);
-        }
+        processBlock(buffer, midiMessages);
+        return;
     }
 
-    auto metrics = analyzer.analyze(buffer);
-    latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-    latestPostScore.store(metrics.score, std::memory_order_relaxed);
-    latestScore.store(metrics.score, std::memory_order_relaxed);
-    latestPunch.store(metrics.punch, std::memory_order_relaxed);
-    latestRichness.store(metrics.richness, std::memory_order_relaxed);
-    latestClarity.store(metrics.clarity, std::memory_order_relaxed);
-    latestWidth.store(metrics.width, std::memory_order_relaxed);
-    latestMonoSafety.store(metrics.monoSafety, std::memory_order_relaxed);
-    pushJuicinessToHost(metrics.score);
+    if (bypass.runsBypassMeter())
+    {
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, metrics);
+    }
+}
+
+void JuicySaturatorAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.punch, std::memory_order_relaxed);
+    latestRichness.store(post.richness, std::memory_order_relaxed);
+    latestClarity.store(post.clarity, std::memory_order_relaxed);
+    latestWidth.store(post.width, std::memory_order_relaxed);
+    latestMonoSafety.store(post.monoSafety, std::memory_order_relaxed);
+    pushJuicinessToHost(post.score);
+}
+
+void JuicySaturatorAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+}
+
+JuicySaturatorParameters JuicySaturatorAudioProcessor::readParameters() const
+{
+    JuicySaturatorParameters p;
+    p.driveDb = *parameters.getRawParameterValue("drive");
+    p.asymmetry = *parameters.getRawParameterValue("asymmetry");
+    p.tone = *parameters.getRawParameterValue("tone");
+    p.mix = *parameters.getRawParameterValue("mix");
+    p.outputDb = *parameters.getRawParameterValue("output");
+    return p;
 }
 
 juce::AudioProcessorEditor* JuicySaturatorAudioProcessor::createEditor()
 {
-    return new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Saturator");
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Saturator");
+    editor->setStageProfiler(&profiler);
+    return editor;
 }
 
 void JuicySaturatorAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    writeJuicyState(destData, parameters, stateParameterIds);
 }
 
 void JuicySaturatorAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds))
+        return;
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState == nullptr)
         return;
@@ -183,6 +234,7 @@ JuicinessMetrics JuicySaturatorAudioProcessor::getLatestMetrics() const noexcept
     m.clarity = latestClarity.load(std::memory_order_relaxed);
     m.width = latestWidth.load(std::memory_order_relaxed);
     m.monoSafety = latestMonoSafety.load(std::memory_order_relaxed);
+    m.qualityTier = static_cast<int>(quality.getTier());
     return m;
 }
 
@@ -195,10 +247,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicySaturatorAudioProcessor
     params.push_back(std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 1.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("output", "Output (dB)", -18.0f, 18.0f, -3.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                                 juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                     .withCategory(juce::AudioProcessorParameter::otherMeter)));
     return { params.begin(), params.end() };
 }
 
+#if ! JUICY_BUNDLED_PROCESSORS
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new JuicySaturatorAudioProcessor();
 }
+#endif
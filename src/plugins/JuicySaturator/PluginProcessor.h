@@ -3,8 +3,13 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <atomic>
 #include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "../../shared/JuicyWorkerPool.h"
+#include "JuicySaturatorKernel.h"
 
-class JuicySaturatorAudioProcessor : public juce::AudioProcessor
+class JuicySaturatorAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor, public JuicyParallelProcessor
 {
 public:
     JuicySaturatorAudioProcessor();
@@ -14,6 +19,7 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -22,7 +28,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override;
     int getCurrentProgram() override;
@@ -33,15 +39,27 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
     JuicinessMetrics getLatestMetrics() const noexcept;
+    void setParallelChannelThreshold(int numChannels) noexcept override { parallelChannelThreshold.store(numChannels); }
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
 
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicySaturatorParameters readParameters() const;
 
     juce::AudioProcessorValueTreeState parameters;
-    JuicinessAnalyzer analyzer;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
     juce::RangedAudioParameter* juicinessParameter = nullptr;
-    std::vector<float> toneState;
+    JuicySaturatorKernel kernel;
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
+    juce::SharedResourcePointer<JuicyWorkerPool> workerPool;
+    std::atomic<int> parallelChannelThreshold { juicyDefaultParallelThreshold };
     std::atomic<float> latestPreScore { 0.0f };
     std::atomic<float> latestPostScore { 0.0f };
     std::atomic<float> latestScore { 0.0f };
@@ -0,0 +1,730 @@
+#include "JuicyTextureKernel.h"
+#include "../../shared/JuicySubBlocks.h"
+#include "../../shared/JuicyTimeline.h"
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+// Jumps the noise LCG ahead by `steps` draws in O(log steps).
+uint32_t advanceNoise(uint32_t state, uint32_t steps) noexcept
+{
+    uint32_t mul = 1664525u;
+    uint32_t add = 1013904223u;
+    uint32_t accMul = 1u;
+    uint32_t accAdd = 0u;
+    while (steps > 0u)
+    {
+        if ((steps & 1u) != 0u)
+        {
+            accMul *= mul;
+            accAdd = accAdd * mul + add;
+        }
+        add *= mul + 1u;
+        mul *= mul;
+        steps >>= 1u;
+    }
+    return accMul * state + accAdd;
+}
+
+// Modal banks, lowest mode first: frequency (a ratio of the plate fundamental for metal, Hz for
+// the others), T60 relative to the material's tail scale, and gain. Real-time rendering runs
+// the first realtimeModes of each bank; offline bounces add the two upper modes.
+struct ModalMode
+{
+    float freq;
+    float t60;
+    float gain;
+};
+
+// Output peak protection: a 1.5 ms lookahead keeps transients under the ceiling without
+// clipping them.
+constexpr float peakCeiling = 0.95f;
+constexpr double peakLookaheadSeconds = 0.0015;
+constexpr double peakReleaseSeconds = 0.08;
+
+constexpr int realtimeModes = 4;
+constexpr int reducedModes = 2;
+
+// Metal's strike bend moves its mode frequencies with every sample's impact. Its resonator
+// coefficients are retargeted every this many samples, on the timeline, and ramped between.
+constexpr juce::int64 modalControlTick = 16;
+
+constexpr std::array<ModalMode, 6> metalModes { {
+    { 1.00f, 0.56f, 0.34f }, { 2.31f, 0.40f, 0.20f }, { 4.18f, 0.26f, 0.13f },
+    { 6.87f, 0.17f, 0.09f }, { 10.24f, 0.11f, 0.06f }, { 14.29f, 0.07f, 0.04f }
+} };
+
+constexpr std::array<ModalMode, 6> woodModes { {
+    { 155.0f, 0.40f, 0.32f }, { 355.0f, 0.27f, 0.18f }, { 690.0f, 0.16f, 0.10f },
+    { 1130.0f, 0.10f, 0.06f }, { 1680.0f, 0.065f, 0.035f }, { 2350.0f, 0.045f, 0.02f }
+} };
+
+constexpr std::array<ModalMode, 6> plasticModes { {
+    { 280.0f, 0.28f, 0.34f }, { 690.0f, 0.18f, 0.22f }, { 1320.0f, 0.11f, 0.16f },
+    { 2360.0f, 0.07f, 0.11f }, { 3650.0f, 0.045f, 0.07f }, { 5200.0f, 0.03f, 0.045f }
+} };
+
+// Two-pole resonator coefficients of a modal bank, y = gain * x + a1 * y1 + a2 * y2. The
+// frequencies and T60s only move with the parameters, so they are worked out once per block.
+// a1, a2 and gain are laid out like a channel pair's resonator state: [mode][lane], each mode's
+// value repeated for the left and right lane, unused modes zero.
+constexpr size_t modalPairValues = 6 * 2;
+
+struct ModalCoefficients
+{
+    alignas(16) std::array<float, modalPairValues> a1 {};
+    alignas(16) std::array<float, modalPairValues> a2 {};
+    alignas(16) std::array<float, modalPairValues> gain {};
+    std::array<float, 6> radius {};
+    std::array<float, 6> freqHz {};
+};
+
+// One sample of a channel pair's modal bank. With the state interleaved [mode][lane], each
+// SIMD register steps two modes of both channels. Each channel's modes are then summed lowest
+// first, which keeps the result bit-identical to stepping them one at a time.
+std::array<float, 2> resonatePair(float* y1, float* y2, const float* a1, const float* a2, const float* gain,
+                                  const std::array<float, 2>& excitation, int numModes) noexcept
+{
+    const auto numValues = static_cast<size_t>(numModes) * 2;
+#if JUCE_USE_SIMD
+    using Register = juce::dsp::SIMDRegister<float>;
+    static_assert(Register::size() % 2 == 0 && modalPairValues % Register::size() == 0, "registers hold whole mode pairs");
+    alignas(16) std::array<float, Register::size()> lanes;
+    for (size_t i = 0; i < lanes.size(); ++i)
+        lanes[i] = excitation[i % 2];
+    const auto x = Register::fromRawArray(lanes.data());
+    for (size_t v = 0; v < numValues; v += Register::size())
+    {
+        const auto prev = Register::fromRawArray(y1 + v);
+        const auto y = x * Register::fromRawArray(gain + v) + Register::fromRawArray(a1 + v) * prev
+                     + Register::fromRawArray(a2 + v) * Register::fromRawArray(y2 + v);
+        prev.copyToRawArray(y2 + v);
+        y.copyToRawArray(y1 + v);
+    }
+#else
+    for (size_t v = 0; v < numValues; ++v)
+    {
+        const float y = excitation[v % 2] * gain[v] + a1[v] * y1[v] + a2[v] * y2[v];
+        y2[v] = y1[v];
+        y1[v] = y;
+    }
+#endif
+
+    std::array<float, 2> modes {};
+    for (size_t v = 0; v < numValues; v += 2)
+    {
+        modes[0] += y1[v];
+        modes[1] += y1[v + 1];
+    }
+    return modes;
+}
+
+// What each material (0 gel, 1 metal, 2 wood, 3 plastic, 4 flesh) scales its input by before
+// the model, and the model's output by before the shared tail.
+constexpr float materialInputTrim(int material) noexcept
+{
+    return material == 1 ? 0.58f : (material == 2 ? 0.62f : (material == 3 ? 0.60f : 1.0f));
+}
+
+constexpr float materialOutputTrim(int material) noexcept
+{
+    return material == 1 ? 0.62f : (material == 2 ? 0.54f : (material == 3 ? 0.62f : 1.0f));
+}
+
+float waveguideRead(const float* line, int size, int writeIdx, float delaySamples) noexcept
+{
+    if (size <= 1)
+        return 0.0f;
+    float pos = static_cast<float>(writeIdx) - delaySamples;
+    while (pos < 0.0f)
+        pos += static_cast<float>(size);
+    while (pos >= static_cast<float>(size))
+        pos -= static_cast<float>(size);
+    const int i0 = static_cast<int>(pos);
+    const int i1 = (i0 + 1) % size;
+    const float frac = pos - static_cast<float>(i0);
+    return juce::jmap(frac, line[static_cast<size_t>(i0)], line[static_cast<size_t>(i1)]);
+}
+
+float modalFeedback(float radius, float freqHz, double sr) noexcept
+{
+    const float f = juce::jlimit(20.0f, 0.45f * static_cast<float>(sr), freqHz);
+    const float theta = 2.0f * juce::MathConstants<float>::pi * f / static_cast<float>(sr);
+    return 2.0f * radius * std::cos(theta);
+}
+
+// freqScale multiplies the bank's frequencies (metal lists ratios), tScale its T60s.
+ModalCoefficients computeModalCoefficients(const std::array<ModalMode, 6>& bank, int numModes, float freqScale, float tScale, double sr) noexcept
+{
+    ModalCoefficients c;
+    for (size_t m = 0; m < static_cast<size_t>(numModes); ++m)
+    {
+        const float t = juce::jmax(0.02f, bank[m].t60 * tScale);
+        const float r = std::exp(std::log(0.001f) / (t * static_cast<float>(sr)));
+        c.freqHz[m] = freqScale * bank[m].freq;
+        c.radius[m] = r;
+        for (size_t v = 2 * m; v < 2 * m + 2; ++v)
+        {
+            c.a1[v] = modalFeedback(r, c.freqHz[m], sr);
+            c.a2[v] = -r * r;
+            c.gain[v] = bank[m].gain;
+        }
+    }
+    return c;
+}
+}
+
+// Everything the per-sample loop uses that only moves with the parameters, worked out once per
+// block. Each material reads its own group.
+struct JuicyTextureKernel::BlockCoefficients
+{
+    double sr = 44100.0;
+    float tailShape = 0.0f;
+    float texture = 0.0f;
+    float mix = 1.0f;
+    float outGain = 1.0f;
+    float decay = 0.0f;
+    float lowBoost = 1.0f;
+    float splitLowCoeff = 0.0f;
+    float splitHighCoeff = 0.0f;
+    float envAtk = 0.0f;
+    float envRel = 0.0f;
+    float wetEnvAttack = 0.0f;
+    float wetEnvRelease = 0.0f;
+    float autoGainBase = 0.0f;
+    float highGain = 0.0f;       // 0.9 + 1.3 texture
+    float roughGain = 0.0f;      // 0.004 + 0.022 texture
+    float impactDynamics = 0.0f; // 0.18 + 0.12 texture
+    float materialGain = 1.0f;   // the material's texture-dependent output or drive gain
+
+    // Gel's spring.
+    float springOmega = 0.0f;
+    float springK = 0.0f;
+
+    // Metal, wood and plastic modal banks.
+    int numModes = 0;
+    ModalCoefficients modal;
+
+    // Wood and plastic cavities.
+    int waveguideLength = 0;
+    float cavityDelay = 0.0f;
+    float cavityDamp = 0.0f;
+
+    // Flesh's two coupled masses.
+    float fleshKA = 0.0f;
+    float fleshKB = 0.0f;
+    float fleshCA = 0.0f;
+    float fleshCB = 0.0f;
+    float fleshCouple = 0.0f;
+};
+
+void JuicyTextureKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    nextPosition = -1;
+
+    numInputChannels = layout.size();
+    numChannelStates = juce::jmax(1, numInputChannels);
+    numPairs = (numChannelStates + pairLanes - 1) / pairLanes;
+    waveguideLength = juce::jmax(2048, static_cast<int>(sr * 0.08));
+
+    arena.beginLayout();
+    pairSlot = arena.reserveHot<PairState>(static_cast<size_t>(numPairs));
+    waveguideSlot = arena.reserveCold<float>(static_cast<size_t>(numChannelStates * waveguideLength));
+    coefficientSlot = arena.reserveHot<BlockCoefficients>(1);
+    arena.allocate();
+    arena.fill(pairSlot, PairState {});
+    limiter.prepare(sr, numChannelStates, peakLookaheadSeconds, peakReleaseSeconds);
+    idleDetector.reset();
+}
+
+void JuicyTextureKernel::reset() noexcept
+{
+    arena.fill(pairSlot, PairState {});
+    arena.fill(waveguideSlot, 0.0f);
+    limiter.reset();
+    idleDetector.reset();
+    nextPosition = -1;
+}
+
+double JuicyTextureKernel::getTailLengthSeconds(const JuicyTextureParameters& params) const
+{
+    const int mode = params.material;
+    const double tailShape = params.tailShape;
+    const double dampingAmt = juce::jlimit(0.0, 1.0, static_cast<double>(params.damping));
+    const double weight = params.weight;
+    const double texture = params.texture;
+    const double dampingMul = juce::jmap(dampingAmt, 0.0, 1.0, 1.35, 0.40);
+    const double decay = juce::jmap(tailShape, 0.0, 1.0, 0.30, 0.985) * juce::jmap(dampingAmt, 0.0, 1.0, 1.0, 0.80);
+
+    // A mode is 60 dB down after its T60, so it reaches silence after twice that.
+    const auto modalSeconds = [](double t60) { return 2.0 * juce::jmax(0.02, t60); };
+    const auto springSeconds = [this](double omega, double zeta)
+    {
+        const double rate = zeta < 1.0 ? zeta * omega : omega * (zeta - std::sqrt(zeta * zeta - 1.0));
+        return juicyDecaySeconds(std::exp(-rate), sr);
+    };
+    const auto waveguideSeconds = [this](double damp, double loopHz)
+    {
+        return juicyDecaySeconds(std::pow(damp, loopHz / sr), sr);
+    };
+
+    // Shared tail feedback and DC blocker, then the slowest path of the selected material.
+    double seconds = juce::jmax(juicyDecaySeconds(decay, sr), juicyDecaySeconds(0.995, sr));
+    switch (mode)
+    {
+        case 0:
+        {
+            const double omega = 2.0 * juce::MathConstants<double>::pi * (42.0 + texture * 88.0) / sr;
+            seconds = juce::jmax(seconds, springSeconds(omega, 0.62), springSeconds(omega, juce::jmap(tailShape, 0.62, 1.45)));
+            break;
+        }
+        case 1:
+        {
+            const double tScale = juce::jmap(tailShape, 0.18, 0.72) * dampingMul * juce::jmap(dampingAmt, 0.0, 1.0, 1.0, 0.55);
+            seconds = juce::jmax(seconds, modalSeconds(0.56 * tScale));
+            break;
+        }
+        case 2:
+        {
+            const double tScale = juce::jmap(tailShape, 0.18, 0.62) * dampingMul * juce::jmap(dampingAmt, 0.0, 1.0, 1.0, 0.64);
+            const double damp = juce::jmap(tailShape, 0.26, 0.90) * juce::jmap(dampingAmt, 0.0, 1.0, 1.0, 0.72);
+            const double cavityHz = 92.0 + 95.0 * (0.5 * weight + 0.5 * texture);
+            seconds = juce::jmax(seconds, modalSeconds(0.40 * tScale), waveguideSeconds(damp, cavityHz));
+            break;
+        }
+        case 3:
+        {
+            const double tScale = juce::jmap(tailShape, 0.16, 0.72) * dampingMul;
+            const double damp = juce::jmap(tailShape, 0.22, 0.91) * juce::jmap(dampingAmt, 0.0, 1.0, 1.0, 0.82);
+            seconds = juce::jmax(seconds, modalSeconds(0.28 * tScale), waveguideSeconds(damp, 210.0 + 340.0 * texture));
+            break;
+        }
+        default:
+        {
+            const double omegaA = 2.0 * juce::MathConstants<double>::pi * (38.0 + 52.0 * texture) / sr;
+            const double omegaB = 2.0 * juce::MathConstants<double>::pi * (88.0 + 72.0 * texture) / sr;
+            seconds = juce::jmax(seconds, springSeconds(omegaA, juce::jmap(tailShape, 0.56, 1.18)),
+                                 springSeconds(omegaB, juce::jmap(tailShape, 0.70, 1.34)));
+            break;
+        }
+    }
+    return seconds;
+}
+
+void JuicyTextureKernel::beginBlock(const JuicyTextureParameters& params, const JuicyKernelContext& context, int numSamples) noexcept
+{
+    auto* states = arena.get(pairSlot);
+    auto* coefficients = arena.get(coefficientSlot);
+    if (states == nullptr || coefficients == nullptr)
+        return;
+
+    const int mode = params.material;
+    const float tailShape = params.tailShape;
+    const float damping = params.damping;
+    const float weight = params.weight;
+    const float texture = params.texture;
+
+    const float dampingAmt = juce::jlimit(0.0f, 1.0f, damping);
+    const float dampingMul = juce::jmap(dampingAmt, 0.0f, 1.0f, 1.35f, 0.40f); // lower values ring longer
+
+    auto& k = *coefficients;
+    k = BlockCoefficients {};
+    k.sr = sr;
+    k.tailShape = tailShape;
+    k.texture = texture;
+    k.mix = params.mix;
+    k.outGain = juce::Decibels::decibelsToGain(params.outputDb);
+    k.decay = juce::jmap(tailShape, 0.0f, 1.0f, 0.30f, 0.985f) * juce::jmap(dampingAmt, 0.0f, 1.0f, 1.0f, 0.80f);
+    k.lowBoost = 1.0f + weight * 1.0f;
+    k.splitLowCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 140.0f / static_cast<float>(sr));
+    k.splitHighCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 2600.0f / static_cast<float>(sr));
+    k.envAtk = std::exp(-1.0f / static_cast<float>(sr * 0.0025));
+    k.envRel = std::exp(-1.0f / static_cast<float>(sr * 0.080));
+    k.wetEnvAttack = std::exp(-1.0f / static_cast<float>(sr * 0.005));
+    k.wetEnvRelease = std::exp(-1.0f / static_cast<float>(sr * 0.090));
+    k.autoGainBase = juce::jmap(texture, 0.0f, 1.0f, 0.78f, 0.54f);
+    k.highGain = 0.9f + texture * 1.3f;
+    k.roughGain = 0.004f + 0.022f * texture;
+    k.impactDynamics = 0.18f + texture * 0.12f;
+    k.waveguideLength = waveguideLength;
+
+    // Every channel draws its own noise stream, one draw per sample, with the stream's cursor
+    // at the timeline position. After a seek, a reset or a new seed the cursors are jumped to
+    // the block's position, so any block split of a render draws the same noise.
+    const uint32_t currentSeed = seed.load(std::memory_order_relaxed);
+    if (context.samplePosition != nextPosition || currentSeed != keyedSeed)
+        for (int ch = 0; ch < numChannelStates; ++ch)
+            states[ch / pairLanes].noise[static_cast<size_t>(ch % pairLanes)] = advanceNoise(juicyNoiseHash(currentSeed, static_cast<uint64_t>(ch)),
+                                            static_cast<uint32_t>(context.samplePosition));
+    keyedSeed = currentSeed;
+    nextPosition = context.samplePosition + numSamples;
+
+    // Offline bounces run the whole modal bank and the reduced tier only its two lowest modes.
+    // Modes a block leaves out are cleared so they restart from rest when they come back.
+    const int numModes = context.offlineQuality ? maxModes : (context.reducedDsp ? reducedModes : realtimeModes);
+    const bool reprimeRamps = mode != rampMaterial || numModes != rampModes;
+    rampMaterial = mode;
+    rampModes = numModes;
+    for (int pair = 0; pair < numPairs; ++pair)
+    {
+        auto& st = states[pair];
+        std::fill(st.modalY1.begin() + pairLanes * numModes, st.modalY1.end(), 0.0f);
+        std::fill(st.modalY2.begin() + pairLanes * numModes, st.modalY2.end(), 0.0f);
+        if (reprimeRamps)
+            st.modalPrimed = false;
+    }
+
+    k.numModes = numModes;
+    switch (mode)
+    {
+        case 0:
+        {
+            const float f0 = 42.0f + texture * 88.0f;
+            k.springOmega = 2.0f * juce::MathConstants<float>::pi * f0 / static_cast<float>(sr);
+            k.springK = k.springOmega * k.springOmega;
+            k.materialGain = 0.96f + 0.28f * texture;
+            renderStereo = &renderPair<0, 2>;
+            renderMono = &renderPair<0, 1>;
+            break;
+        }
+        case 1:
+            k.modal = computeModalCoefficients(metalModes, numModes, 320.0f + 140.0f * texture,
+                                               juce::jmap(tailShape, 0.18f, 0.72f) * dampingMul * juce::jmap(dampingAmt, 0.0f, 1.0f, 1.0f, 0.55f), sr);
+            k.materialGain = 0.78f + 0.10f * texture;
+            renderStereo = &renderPair<1, 2>;
+            renderMono = &renderPair<1, 1>;
+            break;
+        case 2:
+        {
+            k.modal = computeModalCoefficients(woodModes, numModes, 1.0f,
+                                               juce::jmap(tailShape, 0.18f, 0.62f) * dampingMul * juce::jmap(dampingAmt, 0.0f, 1.0f, 1.0f, 0.64f), sr);
+            const float cavityHz = 92.0f + 95.0f * (0.5f * weight + 0.5f * texture);
+            k.cavityDelay = juce::jlimit(16.0f, static_cast<float>(waveguideLength - 2), static_cast<float>(sr) / cavityHz);
+            k.cavityDamp = juce::jmap(tailShape, 0.26f, 0.90f) * juce::jmap(dampingAmt, 0.0f, 1.0f, 1.0f, 0.72f);
+            k.materialGain = 0.74f + 0.08f * texture;
+            renderStereo = &renderPair<2, 2>;
+            renderMono = &renderPair<2, 1>;
+            break;
+        }
+        case 3:
+        {
+            k.modal = computeModalCoefficients(plasticModes, numModes, 1.0f, juce::jmap(tailShape, 0.16f, 0.72f) * dampingMul, sr);
+            const float tubeHz = 210.0f + 340.0f * texture;
+            k.cavityDelay = juce::jlimit(8.0f, static_cast<float>(waveguideLength - 2), static_cast<float>(sr) / tubeHz);
+            k.cavityDamp = juce::jmap(tailShape, 0.22f, 0.91f) * juce::jmap(dampingAmt, 0.0f, 1.0f, 1.0f, 0.82f);
+            k.materialGain = 0.80f + 0.10f * texture;
+            renderStereo = &renderPair<3, 2>;
+            renderMono = &renderPair<3, 1>;
+            break;
+        }
+        default:
+        {
+            const float wA = 2.0f * juce::MathConstants<float>::pi * (38.0f + 52.0f * texture) / static_cast<float>(sr);
+            const float wB = 2.0f * juce::MathConstants<float>::pi * (88.0f + 72.0f * texture) / static_cast<float>(sr);
+            k.fleshKA = wA * wA;
+            k.fleshKB = wB * wB;
+            k.fleshCA = 2.0f * juce::jmap(tailShape, 0.56f, 1.18f) * wA;
+            k.fleshCB = 2.0f * juce::jmap(tailShape, 0.70f, 1.34f) * wB;
+            k.fleshCouple = 0.14f + 0.24f * texture;
+            k.materialGain = 0.98f + 0.16f * texture;
+            renderStereo = &renderPair<4, 2>;
+            renderMono = &renderPair<4, 1>;
+            break;
+        }
+    }
+}
+
+bool JuicyTextureKernel::isStateSilent() const noexcept
+{
+    const auto* states = arena.get(pairSlot);
+    const auto* waveguides = arena.get(waveguideSlot);
+    if (states == nullptr || waveguides == nullptr)
+        return true;
+
+    for (int ch = 0; ch < numChannelStates; ++ch)
+    {
+        const auto& st = states[ch / pairLanes];
+        const auto lane = static_cast<size_t>(ch % pairLanes);
+        const float feedback[] = { st.tail[lane], st.lp[lane], st.hp[lane], st.dcOut[lane], st.springPos[lane],
+                                   st.springVel[lane], st.fleshPosA[lane], st.fleshVelA[lane], st.fleshPosB[lane],
+                                   st.fleshVelB[lane], st.prevWave[lane] };
+        if (! isJuicyStateSilent(feedback, static_cast<int>(std::size(feedback)))
+            || ! isJuicyStateSilent(st.modalY1.data(), 2 * maxModes) || ! isJuicyStateSilent(st.modalY2.data(), 2 * maxModes))
+            return false;
+    }
+    return isJuicyStateSilent(waveguides, numChannelStates * waveguideLength) && limiter.isSilent();
+}
+
+bool JuicyTextureKernel::process(juce::AudioBuffer<float>& buffer, const JuicyTextureParameters& params, const JuicyKernelContext& context) noexcept
+{
+    auto* states = arena.get(pairSlot);
+    const auto* k = arena.get(coefficientSlot);
+    if (states == nullptr || k == nullptr || arena.get(waveguideSlot) == nullptr)
+        return false;
+
+    const int inCh = juce::jmin(buffer.getNumChannels(), numInputChannels);
+    const auto blockLength = static_cast<uint32_t>(buffer.getNumSamples());
+    beginBlock(params, context, buffer.getNumSamples());
+
+    // The roughness noise keeps exciting the tail even on silence, so the state check only
+    // wins for dry settings; otherwise the material's ring-out time bounds the wait. Offline
+    // renders wait for the state itself: where the ring-out bound ends depends on the block
+    // boundaries, and bounces should not.
+    const double maxSilentSeconds = context.offlineQuality ? std::numeric_limits<double>::infinity()
+                                                           : getTailLengthSeconds(params);
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, inCh), buffer.getNumSamples(),
+                                          maxSilentSeconds, sr, [this] { return isStateSilent(); });
+    if (idle)
+    {
+        // Only the resonators are cleared; the level followers steer the gain the signal
+        // comes back with, so they keep releasing as they would on silence.
+        const auto n = static_cast<float>(blockLength);
+        const float envDecay = std::pow(k->envRel, n);
+        const float wetEnvDecay = std::pow(k->wetEnvRelease, n);
+        for (int pair = 0; pair < numPairs; ++pair)
+        {
+            auto& st = states[pair];
+            auto env = st.env;
+            auto wetEnv = st.wetEnv;
+            auto noise = st.noise;
+            for (size_t lane = 0; lane < static_cast<size_t>(pairLanes); ++lane)
+            {
+                env[lane] *= envDecay;
+                wetEnv[lane] *= wetEnvDecay;
+                noise[lane] = advanceNoise(noise[lane], blockLength);
+            }
+            if (idleDetector.hasJustEntered())
+                st = PairState {};
+            st.env = env;
+            st.wetEnv = wetEnv;
+            st.noise = noise;
+        }
+        if (idleDetector.hasJustEntered())
+        {
+            arena.fill(waveguideSlot, 0.0f);
+            limiter.reset();
+        }
+        buffer.clear();
+        return false;
+    }
+
+    render(buffer, 0, buffer.getNumSamples(), context);
+    return true;
+}
+
+void JuicyTextureKernel::render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept
+{
+    auto* states = arena.get(pairSlot);
+    auto* waveguides = arena.get(waveguideSlot);
+    const auto* k = arena.get(coefficientSlot);
+    if (states == nullptr || waveguides == nullptr || k == nullptr || renderStereo == nullptr)
+        return;
+
+    const int numChannels = juce::jmin(buffer.getNumChannels(), numInputChannels, numChannelStates);
+
+    // Pairs are independent up to the limiter, so each renders the whole slice as one task; the
+    // first pair owns the channels the input analysis reads and carries it.
+    auto processPair = [&](int pair)
+    {
+        const int ch = pair * pairLanes;
+        const bool stereo = ch + 1 < numChannels;
+        float* lines[] = { waveguides + ch * waveguideLength, stereo ? waveguides + (ch + 1) * waveguideLength : nullptr };
+
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num)
+        {
+            const int start = startSample + subStart;
+            if (pair == 0)
+                context.analyseInput(buffer, start, num);
+
+            float* x[] = { buffer.getWritePointer(ch, start), stereo ? buffer.getWritePointer(ch + 1, start) : nullptr };
+            (stereo ? renderStereo : renderMono)(states[pair], lines, x, num, context.samplePosition + start, *k);
+        });
+    };
+
+    context.forEachTask(numChannels, (numChannels + pairLanes - 1) / pairLanes, processPair);
+
+    // Peak protection needs every channel's sample before it can pick the linked gain, so it
+    // runs after the join.
+    forEachJuicySubBlock(numSamples, [&](int subStart, int num)
+    {
+        limiter.process(buffer, startSample + subStart, num, peakCeiling);
+        context.analyseOutput(buffer, startSample + subStart, num);
+    });
+}
+
+template <int material, int lanes>
+void JuicyTextureKernel::renderPair(PairState& st, float* const* waveguides, float* const* x, int num, juce::int64 position,
+                                    const BlockCoefficients& k) noexcept
+{
+    static_assert(sizeof(PairState::modalY1) == sizeof(ModalCoefficients::a1), "state and coefficients need the same layout");
+    constexpr bool modal = material == 1 || material == 2 || material == 3;
+    constexpr float inputTrim = materialInputTrim(material);
+    constexpr float materialTrim = materialOutputTrim(material);
+    constexpr float dcR = 0.995f;
+    const float tailShape = k.tailShape;
+    const auto numValues = static_cast<size_t>(pairLanes * k.numModes);
+
+    for (int i = 0; i < num; ++i)
+    {
+        // Lanes the model's stages hand on to each other. The modal bank runs between the
+        // excitation and the shaping, for both lanes in one pass.
+        Lanes<float> core {};
+        Lanes<float> impact {};
+        Lanes<float> body {};
+        Lanes<float> trail {};
+        Lanes<float> exc {};
+        Lanes<float> delayed {};
+        Lanes<float> shaped {};
+
+        for (size_t lane = 0; lane < static_cast<size_t>(lanes); ++lane)
+        {
+            const float dry = x[lane][i];
+            const float driven = dry * inputTrim;
+            const float adry = std::abs(dry);
+            const float envCoeff = adry > st.env[lane] ? k.envAtk : k.envRel;
+            st.env[lane] = envCoeff * st.env[lane] + (1.0f - envCoeff) * adry;
+            impact[lane] = juce::jlimit(0.0f, 1.0f, juce::jmax(0.0f, adry - st.env[lane]) * 10.0f);
+            body[lane] = juce::jlimit(0.0f, 1.0f, st.env[lane] * 3.2f);
+            trail[lane] = juce::jlimit(0.0f, 1.0f, 1.0f - impact[lane]) * tailShape;
+
+            st.lp[lane] += k.splitLowCoeff * (driven - st.lp[lane]);
+            st.hp[lane] += k.splitHighCoeff * (driven - st.hp[lane]);
+            const float low = st.lp[lane] * k.lowBoost;
+            const float high = (driven - st.hp[lane]);
+            const float mid = driven - st.lp[lane] - high;
+            core[lane] = low + mid + high * k.highGain;
+
+            if constexpr (material == 0) // Gel: viscoelastic blob (mass-spring-damper)
+            {
+                const float zeta = juce::jmap(trail[lane], 0.62f, 1.45f);
+                const float c = 2.0f * zeta * k.springOmega;
+                const float force = core[lane] * (0.52f + 0.62f * body[lane]);
+                const float acc = k.springK * (force - st.springPos[lane]) - c * st.springVel[lane];
+                st.springVel[lane] += acc;
+                st.springPos[lane] += st.springVel[lane];
+                shaped[lane] = 0.48f * core[lane] + 1.85f * st.springPos[lane];
+                shaped[lane] = std::tanh(shaped[lane] * k.materialGain);
+            }
+            else if constexpr (material == 1) // Metal: inharmonic modal plate
+            {
+                exc[lane] = core[lane] * (0.19f + 0.52f * impact[lane]);
+                // Approximate thin plate inharmonic modes, bent up by the strike.
+                const float bend = 1.0f + 0.09f * impact[lane];
+                if (! st.modalPrimed || ((position + i) & (modalControlTick - 1)) == 0)
+                {
+                    for (size_t m = 0; m < static_cast<size_t>(k.numModes); ++m)
+                    {
+                        const size_t v = pairLanes * m + lane;
+                        const float target = modalFeedback(k.modal.radius[m], k.modal.freqHz[m] * bend, k.sr);
+                        st.modalA1Step[v] = st.modalPrimed ? (target - st.modalA1[v]) / static_cast<float>(modalControlTick) : 0.0f;
+                        if (! st.modalPrimed)
+                            st.modalA1[v] = target;
+                    }
+                }
+            }
+            else if constexpr (material == 2) // Wood: cavity + modal body resonance
+            {
+                float* waveguide = waveguides[lane];
+                exc[lane] = core[lane] * (0.10f + 0.34f * impact[lane]);
+                delayed[lane] = waveguideRead(waveguide, k.waveguideLength, st.waveIdx[lane], k.cavityDelay);
+                const float newWave = k.cavityDamp * (0.62f * delayed[lane] + 0.38f * st.prevWave[lane]) + exc[lane] * (0.09f + 0.04f * body[lane]);
+                waveguide[st.waveIdx[lane]] = newWave;
+                st.waveIdx[lane] = (st.waveIdx[lane] + 1) % k.waveguideLength;
+                st.prevWave[lane] = delayed[lane];
+            }
+            else if constexpr (material == 3) // Plastic: stiff shell with short cavity resonance
+            {
+                float* waveguide = waveguides[lane];
+                exc[lane] = core[lane] * (0.20f + 0.60f * impact[lane]);
+                delayed[lane] = waveguideRead(waveguide, k.waveguideLength, st.waveIdx[lane], k.cavityDelay);
+                const float newWave = k.cavityDamp * (0.76f * delayed[lane] + 0.24f * st.prevWave[lane]) + 0.14f * exc[lane];
+                waveguide[st.waveIdx[lane]] = newWave;
+                st.waveIdx[lane] = (st.waveIdx[lane] + 1) % k.waveguideLength;
+                st.prevWave[lane] = delayed[lane];
+            }
+            else // Flesh-like: coupled compliant masses
+            {
+                const float force = core[lane] * (0.55f + 0.65f * body[lane]);
+                const float accA = k.fleshKA * (force - st.fleshPosA[lane]) - k.fleshCA * st.fleshVelA[lane]
+                                 - k.fleshCouple * (st.fleshPosA[lane] - st.fleshPosB[lane]);
+                const float accB = k.fleshKB * (st.fleshPosA[lane] - st.fleshPosB[lane]) - k.fleshCB * st.fleshVelB[lane];
+                st.fleshVelA[lane] += accA;
+                st.fleshVelB[lane] += accB;
+                st.fleshPosA[lane] += st.fleshVelA[lane];
+                st.fleshPosB[lane] += st.fleshVelB[lane];
+
+                const float tissue = 0.92f * st.fleshPosA[lane] + 0.58f * st.fleshPosB[lane];
+                const float nl = tissue - 0.19f * tissue * tissue * tissue;
+                shaped[lane] = std::tanh((0.50f * core[lane] + 1.34f * nl) * k.materialGain);
+            }
+        }
+
+        if constexpr (modal)
+        {
+            const float* a1 = k.modal.a1.data();
+            if constexpr (material == 1)
+            {
+                st.modalPrimed = true;
+                for (size_t v = 0; v < numValues; ++v)
+                    st.modalA1[v] += st.modalA1Step[v];
+                a1 = st.modalA1.data();
+            }
+            const auto modes = resonatePair(st.modalY1.data(), st.modalY2.data(), a1, k.modal.a2.data(), k.modal.gain.data(),
+                                            exc, k.numModes);
+
+            for (size_t lane = 0; lane < static_cast<size_t>(lanes); ++lane)
+            {
+                if constexpr (material == 1)
+                {
+                    const float brightExcite = 0.03f * impact[lane] * (core[lane] - st.hp[lane]);
+                    shaped[lane] = (0.44f * core[lane] + 0.42f * modes[lane] + brightExcite) * k.materialGain;
+                }
+                else if constexpr (material == 2)
+                {
+                    // Typical wooden body: strong low/mid modes, shorter high-mode tails.
+                    shaped[lane] = (0.56f * core[lane] + 0.24f * delayed[lane] + 0.30f * modes[lane]) * k.materialGain;
+                }
+                else
+                {
+                    shaped[lane] = (0.52f * core[lane] + 0.36f * delayed[lane] + 0.40f * modes[lane]) * k.materialGain;
+                }
+            }
+        }
+
+        for (size_t lane = 0; lane < static_cast<size_t>(lanes); ++lane)
+        {
+            const float dry = x[lane][i];
+            st.noise[lane] = 1664525u * st.noise[lane] + 1013904223u;
+            const float white = (static_cast<float>((st.noise[lane] >> 8) & 0xFFFF) / 32768.0f - 1.0f);
+            st.noiseHp[lane] += 0.08f * (white - st.noiseHp[lane]);
+            const float rough = white - st.noiseHp[lane];
+            float out = shaped[lane] + rough * k.roughGain * (0.14f + 0.64f * impact[lane]);
+
+            const float dynamics = 1.0f + impact[lane] * k.impactDynamics + body[lane] * 0.06f;
+            out *= dynamics * materialTrim;
+
+            const float tailInput = juce::jlimit(-2.0f, 2.0f, out) * (0.45f + 0.55f * trail[lane]);
+            st.tail[lane] = tailInput + st.tail[lane] * k.decay;
+            float wet = out + st.tail[lane] * (0.30f + 0.45f * trail[lane]);
+
+            // Keep modeled materials level-stable as resonance rises.
+            const float wetAbs = std::abs(wet);
+            const float wetCoeff = wetAbs > st.wetEnv[lane] ? k.wetEnvAttack : k.wetEnvRelease;
+            st.wetEnv[lane] = wetCoeff * st.wetEnv[lane] + (1.0f - wetCoeff) * wetAbs;
+            const float autoComp = k.autoGainBase / (1.0f + 1.8f * st.wetEnv[lane]);
+            wet *= juce::jlimit(0.18f, 1.0f, autoComp);
+
+            const float mixed = dry + k.mix * (wet - dry);
+            const float gained = mixed * k.outGain;
+
+            // Remove DC that can accumulate in nonlinear physical models.
+            const float dcBlocked = gained - st.dcIn[lane] + dcR * st.dcOut[lane];
+            st.dcIn[lane] = gained;
+            st.dcOut[lane] = dcBlocked;
+            x[lane][i] = dcBlocked;
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyLookaheadLimiter.h"
+#include "../../shared/JuicyStateArena.h"
+
+struct JuicyTextureParameters
+{
+    int material = 0; // 0 gel, 1 metal, 2 wood, 3 plastic, 4 flesh
+    float tailShape = 0.55f;
+    float damping = 0.5f;
+    float weight = 0.45f;
+    float texture = 0.5f;
+    float mix = 1.0f;
+    float outputDb = -2.0f;
+};
+
+// Physical material models (springs, modal banks, waveguide cavities) behind a shared tail,
+// auto-gain and a linked lookahead limiter. The reduced quality tier and offline contexts change how many
+// modes the banks run.
+class JuicyTextureKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Returns false when the block idled or the kernel is unprepared; the analyzers are not fed then.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyTextureParameters& params, const JuicyKernelContext& context) noexcept;
+
+    // process() past its idle check, for chains that render several kernels slice by slice:
+    // beginBlock() computes the block's coefficients and keys the noise to the timeline once,
+    // render() then runs consecutive slices of that block, limiter included.
+    void beginBlock(const JuicyTextureParameters& params, const JuicyKernelContext& context, int numSamples) noexcept;
+    void render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept;
+    bool isStateSilent() const noexcept;
+
+    double getTailLengthSeconds(const JuicyTextureParameters& params) const;
+
+    // Output delay from the limiter's lookahead, fixed once prepared.
+    int getLatencySamples() const noexcept { return limiter.getLatencySamples(); }
+
+    // For a chain that swaps this kernel for a plain delay of getLatencySamples() while it is
+    // switched off: the output still in the limiter leaves with the kernel and comes back in
+    // when it is switched on again (see JuicyLookaheadLimiter::readPending()).
+    void readPendingOutput(float* destination, int numChannels) const noexcept { limiter.readPending(destination, numChannels); }
+    void resetWithPendingOutput(const float* source, int numChannels) noexcept
+    {
+        reset();
+        limiter.resetWithPending(source, numChannels);
+    }
+
+    // Seed of the roughness noise, saved with the processor state so a render can be repeated
+    // exactly. Safe to call from the message thread; takes effect at the next block.
+    void setNoiseSeed(uint32_t newSeed) noexcept { seed.store(newSeed, std::memory_order_relaxed); }
+    uint32_t getNoiseSeed() const noexcept { return seed.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int maxModes = 6;
+    static constexpr int pairLanes = 2;
+
+    template <typename T>
+    using Lanes = std::array<T, pairLanes>;
+
+    // Hot state of two adjacent channels, L and R of a stereo layout, one lane per channel. The
+    // modal banks interleave the lanes per mode, so a SIMD register steps both channels at once;
+    // the rest of the model runs lane by lane inside the same sample. An odd last channel runs
+    // lane 0 of its own pair. The waveguide delay lines are cold and live in their own arena region.
+    struct PairState
+    {
+        Lanes<float> tail {};
+        Lanes<float> lp {};
+        Lanes<float> hp {};
+        Lanes<float> env {};
+        Lanes<float> wetEnv {};
+        Lanes<float> noiseHp {};
+        Lanes<float> dcIn {};
+        Lanes<float> dcOut {};
+        Lanes<float> springPos {};
+        Lanes<float> springVel {};
+        Lanes<float> fleshPosA {};
+        Lanes<float> fleshVelA {};
+        Lanes<float> fleshPosB {};
+        Lanes<float> fleshVelB {};
+        Lanes<float> prevWave {};
+        Lanes<int> waveIdx {};
+        Lanes<uint32_t> noise {};
+        bool modalPrimed = false;
+        // [mode][lane]; modes past the running mode count stay at rest.
+        alignas(16) std::array<float, maxModes * pairLanes> modalY1 {};
+        alignas(16) std::array<float, maxModes * pairLanes> modalY2 {};
+        alignas(16) std::array<float, maxModes * pairLanes> modalA1 {};     // metal's bent coefficients, ramping towards
+        alignas(16) std::array<float, maxModes * pairLanes> modalA1Step {}; // their value at the next control tick
+    };
+
+    struct BlockCoefficients;
+
+    // A sub-block of one channel pair through one material's model. Each material and lane
+    // count gets its own instantiation, so process() picks the loop once per block instead of
+    // branching per sample.
+    template <int material, int lanes>
+    static void renderPair(PairState& st, float* const* waveguides, float* const* x, int num, juce::int64 position,
+                           const BlockCoefficients& k) noexcept;
+    using PairRenderer = void (*)(PairState&, float* const*, float* const*, int, juce::int64, const BlockCoefficients&) noexcept;
+
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<PairState> pairSlot;
+    JuicyStateArena::Slot<float> waveguideSlot;
+    JuicyStateArena::Slot<BlockCoefficients> coefficientSlot;
+    PairRenderer renderStereo = nullptr; // the material's loops, picked by beginBlock()
+    PairRenderer renderMono = nullptr;
+    JuicyLookaheadLimiter limiter;
+    int numInputChannels = 0;
+    int numChannelStates = 0;
+    int numPairs = 0;
+    int waveguideLength = 0;
+    JuicyIdleDetector idleDetector;
+    double sr = 44100.0;
+    int rampMaterial = -1; // material and mode count the metal ramps were primed for
+    int rampModes = 0;
+    std::atomic<uint32_t> seed { 0x12345678u };
+    uint32_t keyedSeed = 0;
+    juce::int64 nextPosition = -1; // timeline position the noise cursors are keyed for
+};
@@ -2,10 +2,15 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <atomic>
-#include <array>
 #include "../../shared/JuicinessAnalyzer.h"
+#include "../../shared/JuicyBypass.h"
+#include "../../shared/JuicyQualityGovernor.h"
+#include "../../shared/JuicyStageProfiler.h"
+#include "../../shared/JuicyTimeline.h"
+#include "../../shared/JuicyWorkerPool.h"
+#include "JuicyTextureKernel.h"
 
-class JuicyTextureAudioProcessor : public juce::AudioProcessor
+class JuicyTextureAudioProcessor : public juce::AudioProcessor, public JuicyProfiledProcessor, public JuicyParallelProcessor
 {
 public:
     JuicyTextureAudioProcessor();
@@ -15,6 +20,7 @@ public:
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -23,7 +29,7 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -34,13 +40,20 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
     JuicinessMetrics getLatestMetrics() const noexcept;
+    void setParallelChannelThreshold(int numChannels) noexcept override { parallelChannelThreshold.store(numChannels); }
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { bypass.setMeterWhileBypassed(shouldMeter); }
+    const JuicyStageProfiler& getStageProfiler() const noexcept override { return profiler; }
 
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     void pushJuicinessToHost(float score);
+    void publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post);
+    void resetDspState() noexcept;
+    JuicyTextureParameters readParameters() const;
 
     juce::AudioProcessorValueTreeState parameters;
-    JuicinessAnalyzer analyzer;
+    JuicinessAnalyzer preAnalyzer;
+    JuicinessAnalyzer postAnalyzer;
     juce::RangedAudioParameter* juicinessParameter = nullptr;
 
     std::atomic<float> latestPreScore { 0.0f };
@@ -52,33 +65,13 @@ private:
     std::atomic<float> latestWidth { 0.0f };
     std::atomic<float> latestMonoSafety { 1.0f };
 
-    struct ChannelState
-    {
-        float tail = 0.0f;
-        float lp = 0.0f;
-        float hp = 0.0f;
-        float env = 0.0f;
-        float wetEnv = 0.0f;
-        float noiseHp = 0.0f;
-        float dcIn = 0.0f;
-        float dcOut = 0.0f;
-        float protectGain = 1.0f;
-        float springPos = 0.0f;
-        float springVel = 0.0f;
-        float fleshPosA = 0.0f;
-        float fleshVelA = 0.0f;
-        float fleshPosB = 0.0f;
-        float fleshVelB = 0.0f;
-        float prevWave = 0.0f;
-        std::array<float, 4> modalY1 { 0.0f, 0.0f, 0.0f, 0.0f };
-        std::array<float, 4> modalY2 { 0.0f, 0.0f, 0.0f, 0.0f };
-        std::vector<float> waveguide;
-        int waveIdx = 0;
-    };
-
-    std::array<ChannelState, 2> channels;
-    double sr = 44100.0;
-    uint32_t rng = 0x12345678u;
+    JuicyTextureKernel kernel;
+    JuicyQualityGovernor quality;
+    JuicyBypass bypass;
+    JuicyStageProfiler profiler;
+    JuicyTimeline timeline;
+    juce::SharedResourcePointer<JuicyWorkerPool> workerPool;
+    std::atomic<int> parallelChannelThreshold { juicyDefaultParallelThreshold };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyTextureAudioProcessor)
 };
@@ -0,0 +1,176 @@
+#include "JuicyWidthKernel.h"
+#include "../../shared/JuicySubBlocks.h"
+
+void JuicyWidthKernel::prepare(double sampleRate, const juce::AudioChannelSet& layout)
+{
+    sr = sampleRate;
+    numChannels = layout.size();
+    delayBufferSize = juce::jmax(1, static_cast<int>(sampleRate * 0.060));
+    delayWritePosition = 0;
+
+    channelPairs.clear();
+    for (const auto& pair : findJuicyChannelPairs(layout))
+        if (juce::jmax(pair.left, pair.right) < numChannels)
+            channelPairs.push_back(pair);
+    const auto numPairs = channelPairs.size();
+
+    analysisPair = -1;
+    for (size_t p = 0; p < numPairs; ++p)
+        if (channelPairs[p].left == 0 && channelPairs[p].right == 1)
+            analysisPair = static_cast<int>(p);
+
+    arena.beginLayout();
+    delaySlot = arena.reserveCold<float>(numPairs * static_cast<size_t>(2 * delayBufferSize));
+    widthGainSlot = arena.reserveHot<float>(numPairs);
+    arena.allocate();
+    arena.fill(widthGainSlot, 1.0f);
+    idleDetector.reset();
+}
+
+void JuicyWidthKernel::reset() noexcept
+{
+    arena.fill(delaySlot, 0.0f);
+    arena.fill(widthGainSlot, 1.0f);
+    delayWritePosition = 0;
+    idleDetector.reset();
+}
+
+void JuicyWidthKernel::beginBlock(const JuicyWidthParameters& params, const JuicyKernelContext& context, int numSamples) noexcept
+{
+    juce::ignoreUnused(context, numSamples);
+    k.delaySamples = static_cast<int>(sr * (params.haasMs * 0.001f));
+    k.width = params.width;
+    k.mix = params.mix;
+    k.outputGain = juce::Decibels::decibelsToGain(params.outputDb);
+    k.dynamicLimit = juce::jmap(params.monoSafe, 0.0f, 1.0f, 1.0f, 0.35f);
+    k.widthRecovery = 1.0f - std::exp(-1.0f / static_cast<float>(sr * 0.010));
+}
+
+bool JuicyWidthKernel::isStateSilent() const noexcept
+{
+    const auto* delayLines = arena.get(delaySlot);
+    return delayLines == nullptr || isJuicyStateSilent(delayLines, static_cast<int>(channelPairs.size()) * 2 * delayBufferSize);
+}
+
+bool JuicyWidthKernel::process(juce::AudioBuffer<float>& buffer, const JuicyWidthParameters& params, const JuicyKernelContext& context) noexcept
+{
+    const int totalChannels = juce::jmin(buffer.getNumChannels(), numChannels);
+
+    // The delay lines only hold silence once a full line length of silent input has passed.
+    const bool idle = idleDetector.update(isJuicyBufferSilent(buffer, totalChannels), buffer.getNumSamples(),
+                                          static_cast<double>(delayBufferSize) / sr, sr, [] { return false; });
+    if (idle)
+    {
+        if (idleDetector.hasJustEntered())
+        {
+            arena.fill(delaySlot, 0.0f);
+            arena.fill(widthGainSlot, 1.0f);
+        }
+        buffer.clear();
+        return false;
+    }
+
+    beginBlock(params, context, buffer.getNumSamples());
+    render(buffer, 0, buffer.getNumSamples(), context);
+    return true;
+}
+
+void JuicyWidthKernel::render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept
+{
+    auto* delayLines = arena.get(delaySlot);
+    auto* widthGains = arena.get(widthGainSlot);
+    const int numPairs = static_cast<int>(channelPairs.size());
+    if (numPairs == 0 || delayLines == nullptr || widthGains == nullptr)
+    {
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num)
+        {
+            context.analyseInput(buffer, startSample + subStart, num);
+            context.analyseOutput(buffer, startSample + subStart, num);
+        });
+        return;
+    }
+
+    // Pairs are independent: each runs the stereo algorithm on its own delay lines and its own
+    // correlation-limited width, starting from the slice's shared write position. The pair on
+    // channels 0/1 carries the fused analyses; other layouts analyse in passes of their own.
+    // Anti-correlated samples pull the width gain down; it recovers over about 10 ms, whatever
+    // the block size.
+    const int blockWritePosition = delayWritePosition;
+    auto processPair = [&](int p)
+    {
+        const auto& channels = channelPairs[static_cast<size_t>(p)];
+        auto* delayLeft = delayLines + static_cast<size_t>(2 * p) * static_cast<size_t>(delayBufferSize);
+        auto* delayRight = delayLeft + delayBufferSize;
+        float& widthGain = widthGains[p];
+        int writePosition = blockWritePosition;
+
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num)
+        {
+            const int start = startSample + subStart;
+            if (p == analysisPair)
+                context.analyseInput(buffer, start, num);
+
+            auto* left = buffer.getWritePointer(channels.left, start);
+            auto* right = buffer.getWritePointer(channels.right, start);
+
+            // A channel without a partner has no side signal, so the wet path equals the dry
+            // one and only the output gain is left.
+            if (channels.left == channels.right)
+            {
+                juce::FloatVectorOperations::multiply(left, k.outputGain, num);
+            }
+            else
+            {
+                for (int i = 0; i < num; ++i)
+                {
+                    const float dryL = left[i];
+                    const float dryR = right[i];
+
+                    const float corrProxy = juce::jlimit(-1.0f, 1.0f, dryL * dryR * 12.0f);
+                    if (corrProxy < -0.1f)
+                        widthGain *= k.dynamicLimit;
+                    else
+                        widthGain += k.widthRecovery * (1.0f - widthGain);
+                    const float width = k.width * widthGain;
+
+                    const float mid = 0.5f * (dryL + dryR);
+                    const float side = 0.5f * (dryL - dryR) * (1.0f + width);
+                    float wetL = mid + side;
+                    float wetR = mid - side;
+
+                    delayLeft[writePosition] = wetL;
+                    delayRight[writePosition] = wetR;
+
+                    int readPos = writePosition - k.delaySamples;
+                    if (readPos < 0)
+                        readPos += delayBufferSize;
+
+                    // Haas shift: delay right relative to left for controlled decorrelation.
+                    const float haasL = wetL;
+                    const float haasR = delayRight[readPos];
+                    wetL = haasL;
+                    wetR = haasR;
+
+                    left[i] = (dryL + k.mix * (wetL - dryL)) * k.outputGain;
+                    right[i] = (dryR + k.mix * (wetR - dryR)) * k.outputGain;
+
+                    ++writePosition;
+                    if (writePosition >= delayBufferSize)
+                        writePosition = 0;
+                }
+            }
+
+            if (p == analysisPair)
+                context.analyseOutput(buffer, start, num);
+        });
+    };
+
+    if (analysisPair < 0)
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num) { context.analyseInput(buffer, startSample + subStart, num); });
+
+    context.forEachTask(juce::jmin(buffer.getNumChannels(), numChannels), numPairs, processPair);
+
+    if (analysisPair < 0)
+        forEachJuicySubBlock(numSamples, [&](int subStart, int num) { context.analyseOutput(buffer, startSample + subStart, num); });
+    delayWritePosition = (blockWritePosition + numSamples) % delayBufferSize;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+#include "../../shared/JuicyChannelPairs.h"
+#include "../../shared/JuicyIdle.h"
+#include "../../shared/JuicyKernelContext.h"
+#include "../../shared/JuicyStateArena.h"
+
+struct JuicyWidthParameters
+{
+    float width = 0.45f;
+    float haasMs = 12.0f;
+    float monoSafe = 0.7f;
+    float mix = 1.0f;
+    float outputDb = 0.0f;
+};
+
+// Mid/side widener with a Haas delay, run on every left/right pair of the layout. Channels
+// without a partner have nothing to widen and only get the output gain.
+class JuicyWidthKernel
+{
+public:
+    void prepare(double sampleRate, const juce::AudioChannelSet& layout);
+    void reset() noexcept;
+
+    // Returns false on the idle path, where the analyzers are left untouched.
+    bool process(juce::AudioBuffer<float>& buffer, const JuicyWidthParameters& params, const JuicyKernelContext& context) noexcept;
+
+    // process() past its idle check, in a per-block and a per-slice half, for chains that
+    // render several kernels slice by slice. Slices follow each other without gaps.
+    void beginBlock(const JuicyWidthParameters& params, const JuicyKernelContext& context, int numSamples) noexcept;
+    void render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const JuicyKernelContext& context) noexcept;
+    bool isStateSilent() const noexcept;
+
+    // The Haas-delayed right channel keeps playing for the delay time after the input stops.
+    double getTailLengthSeconds(const JuicyWidthParameters& params) const { return params.haasMs * 0.001; }
+
+private:
+    struct BlockCoefficients
+    {
+        int delaySamples = 0;
+        float width = 0.0f;
+        float mix = 1.0f;
+        float outputGain = 1.0f;
+        float dynamicLimit = 1.0f;
+        float widthRecovery = 0.0f;
+    };
+
+    BlockCoefficients k;
+    JuicyStateArena arena;
+    std::vector<JuicyChannelPair> channelPairs;
+    int analysisPair = -1;
+    JuicyStateArena::Slot<float> delaySlot;
+    JuicyStateArena::Slot<float> widthGainSlot; // per pair, the mono-safety reduction of the width
+    int delayBufferSize = 0;
+    int delayWritePosition = 0;
+    int numChannels = 0;
+    JuicyIdleDetector idleDetector;
+    double sr = 44100.0;
+};
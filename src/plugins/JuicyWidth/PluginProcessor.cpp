@@ -1,9 +1,12 @@
 #include "PluginProcessor.h"
 #include "../../shared/JuicyPluginEditor.h"
+#include "../../shared/JuicyStateFormat.h"
 #include <array>
 
 namespace
 {
+constexpr std::array<const char*, 5> stateParameterIds { "width", "haasMs", "monoSafe", "mix", "output" };
+
 struct WidthPreset
 {
     const char* name;
@@ -29,16 +32,22 @@ JuicyWidthAudioProcessor::JuicyWidthAudioProcessor()
       parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
     juicinessParameter = parameters.getParameter("juiciness");
+    quality.setHostParameter(parameters.getParameter("qualitytier"));
     setCurrentProgram(0);
 }
 
 void JuicyWidthAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    analyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
-    const int delaySamples = static_cast<int>(sampleRate * 0.060);
-    delayBuffer.setSize(2, juce::jmax(1, delaySamples));
-    delayBuffer.clear();
-    delayWritePosition = 0;
+    preAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    postAnalyzer.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels());
+    kernel.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+    quality.prepare(sampleRate, JuicyQualityTier::decimatedAnalysis);
+    profiler.prepare(sampleRate);
+    bypass.prepare(sampleRate, samplesPerBlock, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), getLatencySamples());
+
+    const int threshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    if (threshold > 0 && getTotalNumInputChannels() >= threshold)
+        workerPool->start();
 }
 
 void JuicyWidthAudioProcessor::releaseResources()
@@ -47,10 +56,15 @@ void JuicyWidthAudioProcessor::releaseResources()
 
 bool JuicyWidthAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
+    // Surround layouts are widened pair by pair; centre and LFE only get the output gain.
     if (layouts.getMainInputChannelSet() != layouts.getMainOutputChannelSet())
         return false;
-    return layouts.getMainOutputChannelSet() == juce::AudioChannelSet::mono()
-        || layouts.getMainOutputChannelSet() == juce::AudioChannelSet::stereo();
+    return ! layouts.getMainOutputChannelSet().isDisabled();
+}
+
+double JuicyWidthAudioProcessor::getTailLengthSeconds() const
+{
+    return kernel.getTailLengthSeconds(readParameters());
 }
 
 void JuicyWidthAudioProcessor::pushJuicinessToHost(float score)
@@ -65,104 +79,101 @@ void JuicyWidthAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, ju
 {
     juce::ignoreUnused(midiMessages);
     juce::ScopedNoDenormals noDenormals;
+    JUICY_PROFILE_BLOCK(&profiler, buffer.getNumSamples());
+    const JuicyQualityGovernor::ScopedBlock qualityBlock(quality, buffer.getNumSamples(), isNonRealtime());
+    const JuicyBypass::ScopedFade bypassFade(bypass, buffer);
+    if (bypassFade.isResuming())
+        resetDspState();
 
     const int totalInputChannels = getTotalNumInputChannels();
     const int totalOutputChannels = getTotalNumOutputChannels();
     for (int i = totalInputChannels; i < totalOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    const auto preMetrics = analyzer.analyze(buffer);
+    const auto params = readParameters();
+    preAnalyzer.beginBlock(quality.runsPreAnalysis());
+    postAnalyzer.beginBlock(quality.runsPostAnalysis());
+
+    JuicyKernelContext context;
+    context.preAnalyzer = &preAnalyzer;
+    context.postAnalyzer = &postAnalyzer;
+    context.profiler = &profiler;
+    context.workerPool = &workerPool.get();
+    context.parallelChannelThreshold = parallelChannelThreshold.load(std::memory_order_relaxed);
+    context.reducedDsp = quality.runsReducedDsp();
+    context.offlineQuality = quality.runsOfflineQuality();
+    if (! kernel.process(buffer, params, context))
+        return;
+
+    const auto preMetrics = juicyProfiled(&profiler, JuicyProfileStage::preAnalysis, [this] { return preAnalyzer.finishBlock(); });
+    const auto metrics = juicyProfiled(&profiler, JuicyProfileStage::postAnalysis, [this] { return postAnalyzer.finishBlock(); });
+    publishMetrics(preMetrics, metrics);
+}
 
-    if (totalInputChannels < 2)
+void JuicyWidthAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    if (! bypass.processBypassed(buffer))
     {
-        auto metrics = analyzer.analyze(buffer);
-        latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-        latestPostScore.store(metrics.score, std::memory_order_relaxed);
-        latestScore.store(metrics.score, std::memory_order_relaxed);
-        latestPunch.store(metrics.punch, std::memory_order_relaxed);
-        latestRichness.store(metrics.richness, std::memory_order_relaxed);
-        latestClarity.store(metrics.clarity, std::memory_order_relaxed);
-        latestWidth.store(metrics.width, std::memory_order_relaxed);
-        latestMonoSafety.store(metrics.monoSafety, std::memory_order_relaxed);
-        pushJuicinessToHost(metrics.score);
+        processBlock(buffer, midiMessages);
         return;
     }
 
-    const int delayBufferSize = delayBuffer.getNumSamples();
-    const int delaySamples = static_cast<int>(getSampleRate() * (*parameters.getRawParameterValue("haasMs") * 0.001f));
-    float width = *parameters.getRawParameterValue("width");
-    const float monoSafe = *parameters.getRawParameterValue("monoSafe");
-    const float mix = *parameters.getRawParameterValue("mix");
-    const float outputDb = *parameters.getRawParameterValue("output");
-    const float outputGain = juce::Decibels::decibelsToGain(outputDb);
-
-    auto* left = buffer.getWritePointer(0);
-    auto* right = buffer.getWritePointer(1);
-    auto* delayLeft = delayBuffer.getWritePointer(0);
-    auto* delayRight = delayBuffer.getWritePointer(1);
-
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    if (bypass.runsBypassMeter())
     {
-        const float dryL = left[i];
-        const float dryR = right[i];
-
-        const float corrProxy = juce::jlimit(-1.0f, 1.0f, dryL * dryR * 12.0f);
-        const float dynamicLimit = juce::jmap(monoSafe, 0.0f, 1.0f, 1.0f, 0.35f);
-        if (corrProxy < -0.1f)
-            width *= dynamicLimit;
-
-        const float mid = 0.5f * (dryL + dryR);
-        const float side = 0.5f * (dryL - dryR) * (1.0f + width);
-        float wetL = mid + side;
-        float wetR = mid - side;
-
-        delayLeft[delayWritePosition] = wetL;
-        delayRight[delayWritePosition] = wetR;
-
-        int readPos = delayWritePosition - delaySamples;
-        if (readPos < 0)
-            readPos += delayBufferSize;
-
-        // Haas shift: delay right relative to left for controlled decorrelation.
-        const float haasL = wetL;
-        const float haasR = delayRight[readPos];
-        wetL = haasL;
-        wetR = haasR;
-
-        left[i] = (dryL + mix * (wetL - dryL)) * outputGain;
-        right[i] = (dryR + mix * (wetR - dryR)) * outputGain;
-
-        ++delayWritePosition;
-        if (delayWritePosition >= delayBufferSize)
-            delayWritePosition = 0;
+        const auto metrics = postAnalyzer.analyze(buffer);
+        publishMetrics(metrics, metrics);
     }
+}
+
+void JuicyWidthAudioProcessor::publishMetrics(const JuicinessMetrics& pre, const JuicinessMetrics& post)
+{
+    JUICY_PROFILE_STAGE(&profiler, JuicyProfileStage::hostNotification);
+    latestPreScore.store(pre.score, std::memory_order_relaxed);
+    latestPostScore.store(post.score, std::memory_order_relaxed);
+    latestScore.store(post.score, std::memory_order_relaxed);
+    latestPunch.store(post.punch, std::memory_order_relaxed);
+    latestRichness.store(post.richness, std::memory_order_relaxed);
+    latestClarity.store(post.clarity, std::memory_order_relaxed);
+    latestWidth.store(post.width, std::memory_order_relaxed);
+    latestMonoSafety.store(post.monoSafety, std::memory_order_relaxed);
+    pushJuicinessToHost(post.score);
+}
+
+void JuicyWidthAudioProcessor::resetDspState() noexcept
+{
+    kernel.reset();
+    preAnalyzer.reset();
+    postAnalyzer.reset();
+}
 
-    auto metrics = analyzer.analyze(buffer);
-    latestPreScore.store(preMetrics.score, std::memory_order_relaxed);
-    latestPostScore.store(metrics.score, std::memory_order_relaxed);
-    latestScore.store(metrics.score, std::memory_order_relaxed);
-    latestPunch.store(metrics.punch, std::memory_order_relaxed);
-    latestRichness.store(metrics.richness, std::memory_order_relaxed);
-    latestClarity.store(metrics.clarity, std::memory_order_relaxed);
-    latestWidth.store(metrics.width, std::memory_order_relaxed);
-    latestMonoSafety.store(metrics.monoSafety, std::memory_order_relaxed);
-    pushJuicinessToHost(metrics.score);
+JuicyWidthParameters JuicyWidthAudioProcessor::readParameters() const
+{
+    JuicyWidthParameters p;
+    p.width = *parameters.getRawParameterValue("width");
+    p.haasMs = *parameters.getRawParameterValue("haasMs");
+    p.monoSafe = *parameters.getRawParameterValue("monoSafe");
+    p.mix = *parameters.getRawParameterValue("mix");
+    p.outputDb = *parameters.getRawParameterValue("output");
+    return p;
 }
 
 juce::AudioProcessorEditor* JuicyWidthAudioProcessor::createEditor()
 {
-    return new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Width");
+    auto* editor = new JuicyPluginEditor(*this, parameters, [this]() { return getLatestMetrics(); }, "Juicy Width");
+    editor->setStageProfiler(&profiler);
+    return editor;
 }
 
 void JuicyWidthAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    writeJuicyState(destData, parameters, stateParameterIds);
 }
 
 void JuicyWidthAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    if (readJuicyState(data, sizeInBytes, parameters, stateParameterIds))
+        return;
+
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState == nullptr)
         return;
@@ -223,6 +234,7 @@ JuicinessMetrics JuicyWidthAudioProcessor::getLatestMetrics() const noexcept
     m.clarity = latestClarity.load(std::memory_order_relaxed);
     m.width = latestWidth.load(std::memory_order_relaxed);
     m.monoSafety = latestMonoSafety.load(std::memory_order_relaxed);
+    m.qualityTier = static_cast<int>(quality.getTier());
     return m;
 }
 
@@ -235,10 +247,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout JuicyWidthAudioProcessor::cr
     params.push_back(std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 1.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("output", "Output (dB)", -18.0f, 18.0f, 0.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("juiciness", "Juiciness Score", 0.0f, 100.0f, 0.0f));
+    // Written by the quality governor only: a read-out for the host, never automation.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("qualitytier", "Quality Tier", juce::NormalisableRange<float>(0.0f, 3.0f), 0.0f,
+                                                                 juce::AudioParameterFloatAttributes().withAutomatable(false)
+                                                                     .withCategory(juce::AudioProcessorParameter::otherMeter)));
     return { params.begin(), params.end() };
 }
 
+#if ! JUICY_BUNDLED_PROCESSORS
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new JuicyWidthAudioProcessor();
 }
+#endif
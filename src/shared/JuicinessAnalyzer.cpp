@@ -1,5 +1,22 @@
 #include "JuicinessAnalyzer.h"
 
+const std::array<JuicinessMetricField, numJuicinessMetricFields> juicinessMetricFields { {
+    { "score", [](const JuicinessMetrics& m) { return m.score; } },
+    { "preScore", [](const JuicinessMetrics& m) { return m.preScore; } },
+    { "postScore", [](const JuicinessMetrics& m) { return m.postScore; } },
+    { "emphasis", [](const JuicinessMetrics& m) { return m.emphasis; } },
+    { "coherence", [](const JuicinessMetrics& m) { return m.coherence; } },
+    { "synesthesia", [](const JuicinessMetrics& m) { return m.synesthesia; } },
+    { "fatigueRisk", [](const JuicinessMetrics& m) { return m.fatigueRisk; } },
+    { "repetitionDensity", [](const JuicinessMetrics& m) { return m.repetitionDensity; } },
+    { "punch", [](const JuicinessMetrics& m) { return m.punch; } },
+    { "richness", [](const JuicinessMetrics& m) { return m.richness; } },
+    { "clarity", [](const JuicinessMetrics& m) { return m.clarity; } },
+    { "width", [](const JuicinessMetrics& m) { return m.width; } },
+    { "monoSafety", [](const JuicinessMetrics& m) { return m.monoSafety; } },
+    { "qualityTier", [](const JuicinessMetrics& m) { return static_cast<float>(m.qualityTier); } }
+} };
+
 void JuicinessAnalyzer::prepare(double sampleRate, int samplesPerBlock, int numChannels)
 {
     juce::ignoreUnused(samplesPerBlock);
@@ -7,6 +24,11 @@ void JuicinessAnalyzer::prepare(double sampleRate, int samplesPerBlock, int numC
     channels = juce::jmax(1, numChannels);
     lowCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 250.0f / static_cast<float>(sampleRate));
     highCoeff = 1.0f - std::exp(-2.0f * juce::MathConstants<float>::pi * 2500.0f / static_cast<float>(sampleRate));
+    attackShort = std::exp(-1.0f / static_cast<float>(sr * 0.003));
+    releaseShort = std::exp(-1.0f / static_cast<float>(sr * 0.030));
+    attackLong = std::exp(-1.0f / static_cast<float>(sr * 0.050));
+    releaseLong = std::exp(-1.0f / static_cast<float>(sr * 0.300));
+    onsetRateDecay = std::exp(-1.0f / static_cast<float>(sr * onsetRateSeconds));
     reset();
 }
 
@@ -16,9 +38,12 @@ void JuicinessAnalyzer::reset()
     longEnv = 0.0f;
     lowBandState = 0.0f;
     highBandState = 0.0f;
-    repetitionEma = 0.0f;
+    onsetRate = 0.0f;
     fatigueEma = 0.0f;
     onsetCooldown = 0;
+    block = {};
+    analysingBlock = true;
+    lastMetrics = {};
 }
 
 float JuicinessAnalyzer::updateEnvelope(float input, float attackCoeff, float releaseCoeff, float& env) const noexcept
@@ -30,29 +55,25 @@ float JuicinessAnalyzer::updateEnvelope(float input, float attackCoeff, float re
 
 JuicinessMetrics JuicinessAnalyzer::analyze(const juce::AudioBuffer<float>& buffer)
 {
-    JuicinessMetrics m;
-    const auto numSamples = buffer.getNumSamples();
-    if (numSamples <= 0)
-        return m;
+    beginBlock();
+    accumulate(buffer, 0, buffer.getNumSamples());
+    return finishBlock();
+}
+
+void JuicinessAnalyzer::beginBlock(bool shouldAnalyse) noexcept
+{
+    block = {};
+    analysingBlock = shouldAnalyse;
+}
+
+void JuicinessAnalyzer::accumulate(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (numSamples <= 0 || ! analysingBlock)
+        return;
 
-    const float attackShort = std::exp(-1.0f / static_cast<float>(sr * 0.003));
-    const float releaseShort = std::exp(-1.0f / static_cast<float>(sr * 0.030));
-    const float attackLong = std::exp(-1.0f / static_cast<float>(sr * 0.050));
-    const float releaseLong = std::exp(-1.0f / static_cast<float>(sr * 0.300));
-
-    float transientAccum = 0.0f;
-    int onsetCount = 0;
-    float rmsAccum = 0.0f;
-    float peak = 0.0f;
-    float lowAccum = 0.0f;
-    float highAccum = 0.0f;
-    float sideAccum = 0.0f;
-    float midAccum = 0.0f;
-    float corrAccum = 0.0f;
-    int corrCount = 0;
-
-    const auto* left = buffer.getReadPointer(0);
-    const float* right = channels > 1 ? buffer.getReadPointer(1) : nullptr;
+    auto acc = block;
+    const auto* left = buffer.getReadPointer(0, startSample);
+    const float* right = channels > 1 ? buffer.getReadPointer(1, startSample) : nullptr;
 
     for (int i = 0; i < numSamples; ++i)
     {
@@ -65,32 +86,64 @@ JuicinessMetrics JuicinessAnalyzer::analyze(const juce::AudioBuffer<float>& buff
         updateEnvelope(absMono, attackLong, releaseLong, longEnv);
 
         const float transient = juce::jmax(0.0f, shortEnv - longEnv);
-        transientAccum += transient;
+        acc.transientAccum += transient;
+        // Leaky onset counter: each onset adds 1 / onsetRateSeconds, so the value reads as
+        // onsets per second.
+        onsetRate *= onsetRateDecay;
         if (onsetCooldown > 0)
             --onsetCooldown;
         if (transient > 0.045f && onsetCooldown <= 0)
         {
-            ++onsetCount;
+            onsetRate += 1.0f / onsetRateSeconds;
             onsetCooldown = static_cast<int>(sr * 0.035);
         }
-        rmsAccum += mono * mono;
-        peak = juce::jmax(peak, std::abs(mono));
+        acc.rmsAccum += mono * mono;
+        acc.peak = juce::jmax(acc.peak, std::abs(mono));
 
         lowBandState += lowCoeff * (mono - lowBandState);
         highBandState += highCoeff * (mono - highBandState);
         const float low = lowBandState;
         const float high = mono - highBandState;
-        lowAccum += low * low;
-        highAccum += high * high;
+        acc.lowAccum += low * low;
+        acc.highAccum += high * high;
 
         const float mid = 0.5f * (l + r);
         const float side = 0.5f * (l - r);
-        midAccum += mid * mid;
-        sideAccum += side * side;
-        corrAccum += l * r;
-        ++corrCount;
+        acc.midAccum += mid * mid;
+        acc.sideAccum += side * side;
+        acc.corrAccum += l * r;
+        ++acc.corrCount;
+
+        // Same summation as AudioBuffer::getRMSLevel(), so slicing does not change the result.
+        acc.leftSquares += l * l;
+        if (right != nullptr)
+            acc.rightSquares += r * r;
     }
 
+    acc.numSamples += numSamples;
+    block = acc;
+}
+
+JuicinessMetrics JuicinessAnalyzer::finishBlock() noexcept
+{
+    if (! analysingBlock)
+        return lastMetrics;
+
+    JuicinessMetrics m;
+    const auto numSamples = block.numSamples;
+    if (numSamples <= 0)
+        return m;
+
+    const float transientAccum = block.transientAccum;
+    const float rmsAccum = block.rmsAccum;
+    const float peak = block.peak;
+    const float lowAccum = block.lowAccum;
+    const float highAccum = block.highAccum;
+    const float sideAccum = block.sideAccum;
+    const float midAccum = block.midAccum;
+    const float corrAccum = block.corrAccum;
+    const int corrCount = block.corrCount;
+
     const float invN = 1.0f / static_cast<float>(numSamples);
     const float rms = std::sqrt(rmsAccum * invN + 1.0e-12f);
     const float crest = peak / (rms + 1.0e-6f);
@@ -102,8 +155,8 @@ JuicinessMetrics JuicinessAnalyzer::analyze(const juce::AudioBuffer<float>& buff
     float corr = 1.0f;
     if (corrCount > 0)
     {
-        const float lEnergy = buffer.getRMSLevel(0, 0, numSamples);
-        const float rEnergy = channels > 1 ? buffer.getRMSLevel(1, 0, numSamples) : lEnergy;
+        const float lEnergy = static_cast<float>(std::sqrt(block.leftSquares / numSamples));
+        const float rEnergy = channels > 1 ? static_cast<float>(std::sqrt(block.rightSquares / numSamples)) : lEnergy;
         corr = corrAccum * invN / (lEnergy * rEnergy + 1.0e-6f);
         corr = juce::jlimit(-1.0f, 1.0f, corr);
     }
@@ -122,9 +175,7 @@ JuicinessMetrics JuicinessAnalyzer::analyze(const juce::AudioBuffer<float>& buff
     const float monoSafety = juce::jlimit(0.0f, 1.0f, 0.5f * (corr + 1.0f));
 
     const float blockSeconds = static_cast<float>(numSamples) / static_cast<float>(sr);
-    const float onsetRate = blockSeconds > 0.0f ? static_cast<float>(onsetCount) / blockSeconds : 0.0f;
-    repetitionEma += (onsetRate - repetitionEma) * 0.08f;
-    const float repetitionDensity = juce::jlimit(0.0f, 1.0f, repetitionEma / 12.0f);
+    const float repetitionDensity = juce::jlimit(0.0f, 1.0f, onsetRate / 12.0f);
 
     const float emphasis = juce::jlimit(0.0f, 1.0f, 0.62f * punch + 0.38f * juce::jlimit(0.0f, 1.0f, transientAccum * invN * 8.5f));
     const float coherence = juce::jlimit(0.0f, 1.0f, 0.50f * clarity + 0.30f * monoSafety + 0.20f * (1.0f - std::abs(width - 0.45f)));
@@ -133,7 +184,8 @@ JuicinessMetrics JuicinessAnalyzer::analyze(const juce::AudioBuffer<float>& buff
     const float crestPenalty = juce::jlimit(0.0f, 1.0f, (1.8f - crest) * 1.1f);
     const float harshPenalty = juce::jlimit(0.0f, 1.0f, highEnergy * 12.0f);
     const float instantFatigue = juce::jlimit(0.0f, 1.0f, 0.35f * crestPenalty + 0.35f * harshPenalty + 0.30f * repetitionDensity);
-    fatigueEma += (instantFatigue - fatigueEma) * 0.06f;
+    // Weighted by the block's duration so the smoothing time does not follow the block size.
+    fatigueEma += (instantFatigue - fatigueEma) * (1.0f - std::exp(-blockSeconds / fatigueSeconds));
     const float fatigueRisk = juce::jlimit(0.0f, 1.0f, fatigueEma);
 
     float score = 100.0f * (0.30f * punch + 0.25f * richness + 0.25f * clarity + 0.20f * width);
@@ -151,5 +203,6 @@ JuicinessMetrics JuicinessAnalyzer::analyze(const juce::AudioBuffer<float>& buff
     m.clarity = clarity;
     m.width = width;
     m.monoSafety = monoSafety;
+    lastMetrics = m;
     return m;
 }
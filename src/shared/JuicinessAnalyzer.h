@@ -2,6 +2,7 @@
 
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_dsp/juce_dsp.h>
+#include <array>
 
 struct JuicinessMetrics
 {
@@ -18,8 +19,20 @@ struct JuicinessMetrics
     float clarity = 0.0f;
     float width = 0.0f;
     float monoSafety = 1.0f;
+    int qualityTier = 0;
 };
 
+// Every JuicinessMetrics field by name, in declaration order, for tools that write metrics
+// out as CSV or JSON.
+struct JuicinessMetricField
+{
+    const char* name;
+    float (*read)(const JuicinessMetrics&);
+};
+
+constexpr size_t numJuicinessMetricFields = 14;
+extern const std::array<JuicinessMetricField, numJuicinessMetricFields> juicinessMetricFields;
+
 class JuicinessAnalyzer
 {
 public:
@@ -27,18 +40,54 @@ public:
     void reset();
     JuicinessMetrics analyze(const juce::AudioBuffer<float>& buffer);
 
+    // Incremental form of analyze(): a block fed through beginBlock/accumulate/finishBlock
+    // in any number of consecutive slices yields exactly the same metrics. A block begun with
+    // shouldAnalyse false is skipped: accumulate() ignores it and finishBlock() repeats the
+    // metrics of the last analysed block.
+    void beginBlock(bool shouldAnalyse = true) noexcept;
+    void accumulate(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+    JuicinessMetrics finishBlock() noexcept;
+
 private:
+    struct BlockAccumulator
+    {
+        float transientAccum = 0.0f;
+        float rmsAccum = 0.0f;
+        float peak = 0.0f;
+        float lowAccum = 0.0f;
+        float highAccum = 0.0f;
+        float sideAccum = 0.0f;
+        float midAccum = 0.0f;
+        float corrAccum = 0.0f;
+        int corrCount = 0;
+        double leftSquares = 0.0;
+        double rightSquares = 0.0;
+        int numSamples = 0;
+    };
+
     float updateEnvelope(float input, float attackCoeff, float releaseCoeff, float& env) const noexcept;
 
+    // Smoothing times of the repetition and fatigue readings.
+    static constexpr float onsetRateSeconds = 0.145f;
+    static constexpr float fatigueSeconds = 0.19f;
+
     double sr = 44100.0;
     int channels = 2;
+    float attackShort = 0.0f;
+    float releaseShort = 0.0f;
+    float attackLong = 0.0f;
+    float releaseLong = 0.0f;
+    BlockAccumulator block;
+    bool analysingBlock = true;
+    JuicinessMetrics lastMetrics;
     float shortEnv = 0.0f;
     float longEnv = 0.0f;
     float lowBandState = 0.0f;
     float highBandState = 0.0f;
     float lowCoeff = 0.0f;
     float highCoeff = 0.0f;
-    float repetitionEma = 0.0f;
+    float onsetRateDecay = 0.0f;
+    float onsetRate = 0.0f; // onsets per second, updated per sample
     float fatigueEma = 0.0f;
     int onsetCooldown = 0;
 };
@@ -0,0 +1,129 @@
+#include "JuicyBypass.h"
+#include "JuicyQualityGovernor.h"
+
+JuicyBypass::ScopedFade::ScopedFade(JuicyBypass& bypassToUse, juce::AudioBuffer<float>& bufferToFade) noexcept
+    : bypass(bypassToUse),
+      buffer(bufferToFade)
+{
+    const bool bypassing = bypass.bypassRequested;
+    bypass.bypassRequested = false;
+    if (! bypassing && bypass.fullyBypassed)
+    {
+        resuming = true;
+        bypass.fullyBypassed = false;
+    }
+
+    // The dry copy only spans the prepared block size, so a block that overruns it can fade in but
+    // not out; engaging bypass waits for the next block that fits.
+    const bool fits = buffer.getNumSamples() <= bypass.dry.getNumSamples();
+    bypass.fadeTarget = bypassing && fits ? 0.0f : 1.0f;
+    bypass.fading = bypass.wetGain != bypass.fadeTarget;
+    if (bypass.fading || bypass.latency > 0)
+        bypass.storeDry(buffer);
+}
+
+JuicyBypass::ScopedFade::~ScopedFade()
+{
+    if (bypass.fading)
+        bypass.applyFade(buffer);
+}
+
+void JuicyBypass::prepare(double sampleRate, int maximumBlockSize, int numChannels, int latencySamples)
+{
+    fadeStep = 1.0f / static_cast<float>(juce::jmax(1.0, sampleRate * juicyBypassFadeSeconds));
+    latency = juce::jmax(0, latencySamples);
+    dry.setSize(juce::jmax(1, numChannels), juce::jmax(1, maximumBlockSize));
+    latencyLine.setSize(juce::jmax(1, numChannels), juce::jmax(1, latency));
+    reset();
+}
+
+void JuicyBypass::reset() noexcept
+{
+    latencyLine.clear();
+    latencyWritePosition = 0;
+    wetGain = 1.0f;
+    fadeTarget = 1.0f;
+    bypassRequested = false;
+    fading = false;
+    fullyBypassed = false;
+    meterThisBlock = false;
+    bypassedBlocks = 0;
+}
+
+bool JuicyBypass::processBypassed(juce::AudioBuffer<float>& buffer) noexcept
+{
+    bypassRequested = true;
+    if (! fullyBypassed)
+        return false;
+
+    bypassRequested = false;
+    if (latency > 0)
+        delayInto(buffer, buffer);
+    meterThisBlock = meterWhileBypassed.load(std::memory_order_relaxed) && bypassedBlocks++ % juicyAnalysisDecimation == 0;
+    return true;
+}
+
+void JuicyBypass::storeDry(const juce::AudioBuffer<float>& input) noexcept
+{
+    if (latency > 0)
+    {
+        delayInto(input, dry);
+        return;
+    }
+
+    const int numSamples = juce::jmin(input.getNumSamples(), dry.getNumSamples());
+    for (int ch = 0; ch < juce::jmin(input.getNumChannels(), dry.getNumChannels()); ++ch)
+        dry.copyFrom(ch, 0, input, ch, 0, numSamples);
+}
+
+// Pushes the input through the latency line; input and output may be the same buffer. An output
+// shorter than the input keeps only the start, but the line still takes every input sample.
+void JuicyBypass::delayInto(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output) noexcept
+{
+    const int numSamples = input.getNumSamples();
+    const int numOutput = juce::jmin(numSamples, output.getNumSamples());
+    const int numChannels = juce::jmin(input.getNumChannels(), output.getNumChannels(), latencyLine.getNumChannels());
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* in = input.getReadPointer(ch);
+        auto* out = output.getWritePointer(ch);
+        auto* line = latencyLine.getWritePointer(ch);
+        int position = latencyWritePosition;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = in[i];
+            if (i < numOutput)
+                out[i] = line[position];
+            line[position] = x;
+            if (++position == latency)
+                position = 0;
+        }
+    }
+    latencyWritePosition = static_cast<int>((latencyWritePosition + static_cast<juce::int64>(numSamples)) % latency);
+}
+
+void JuicyBypass::applyFade(juce::AudioBuffer<float>& buffer) noexcept
+{
+    // A fade in on a block past the prepared size ends within the dry copy, shortened if need be,
+    // and the overrun keeps the processed signal.
+    const int numSamples = buffer.getNumSamples();
+    const float distance = std::abs(fadeTarget - wetGain);
+    const int rampLength = juce::jmin(numSamples, dry.getNumSamples(), static_cast<int>(std::ceil(distance / fadeStep)));
+    const float endGain = rampLength < numSamples ? fadeTarget
+                                                  : juce::jlimit(0.0f, 1.0f, wetGain + (fadeTarget > wetGain ? 1.0f : -1.0f) * fadeStep * static_cast<float>(rampLength));
+
+    for (int ch = 0; ch < juce::jmin(buffer.getNumChannels(), dry.getNumChannels()); ++ch)
+    {
+        buffer.applyGainRamp(ch, 0, rampLength, wetGain, endGain);
+        buffer.addFromWithRamp(ch, 0, dry.getReadPointer(ch), rampLength, 1.0f - wetGain, 1.0f - endGain);
+        if (rampLength < numSamples && fadeTarget == 0.0f)
+            buffer.copyFrom(ch, rampLength, dry, ch, rampLength, numSamples - rampLength);
+    }
+
+    wetGain = endGain;
+    if (wetGain == 0.0f)
+    {
+        fullyBypassed = true;
+        bypassedBlocks = 0;
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+// Length of the crossfade between the processed and the dry signal when host bypass toggles.
+constexpr double juicyBypassFadeSeconds = 0.005;
+
+// Host bypass for processBlockBypassed. Engaging bypass keeps the processor running for one
+// crossfade into the dry signal; after that bypassed blocks skip all DSP and analysis and only
+// pass the input through, delayed by the processor's latency so the host's compensation stays
+// valid. Releasing bypass resumes from cleared DSP state and crossfades back in. Nothing is
+// allocated after prepare, so blocks longer than the prepared size fade within its length.
+class JuicyBypass
+{
+public:
+    // Wraps one processBlock call: construct it before the buffer is touched. It keeps a dry copy
+    // while a crossfade runs and mixes it in when it goes out of scope, early returns included.
+    class ScopedFade
+    {
+    public:
+        ScopedFade(JuicyBypass& bypassToUse, juce::AudioBuffer<float>& bufferToFade) noexcept;
+        ~ScopedFade();
+
+        // True for the first processed block after a full bypass; the processor's state is
+        // whatever it was when bypass engaged and has to be cleared before use.
+        bool isResuming() const noexcept { return resuming; }
+
+    private:
+        JuicyBypass& bypass;
+        juce::AudioBuffer<float>& buffer;
+        bool resuming = false;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedFade)
+    };
+
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels, int latencySamples);
+    void reset() noexcept;
+
+    // Call first thing in processBlockBypassed. Returns true when the block is fully bypassed and
+    // the buffer already holds the output; false while the fade out still needs processBlock.
+    bool processBypassed(juce::AudioBuffer<float>& buffer) noexcept;
+
+    // Fully bypassed blocks can keep feeding one analyzer every juicyAnalysisDecimation blocks so
+    // the meters stay alive at a fraction of the cost.
+    void setMeterWhileBypassed(bool shouldMeter) noexcept { meterWhileBypassed.store(shouldMeter); }
+    bool runsBypassMeter() const noexcept { return meterThisBlock; }
+
+private:
+    void storeDry(const juce::AudioBuffer<float>& input) noexcept;
+    void delayInto(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output) noexcept;
+    void applyFade(juce::AudioBuffer<float>& buffer) noexcept;
+
+    juce::AudioBuffer<float> dry;
+    juce::AudioBuffer<float> latencyLine;
+    int latency = 0;
+    int latencyWritePosition = 0;
+    float fadeStep = 1.0f;
+    float wetGain = 1.0f; // 1 processed, 0 bypassed
+    float fadeTarget = 1.0f;
+    bool bypassRequested = false;
+    bool fading = false;
+    bool fullyBypassed = false;
+    bool meterThisBlock = false;
+    juce::uint32 bypassedBlocks = 0;
+    std::atomic<bool> meterWhileBypassed { true };
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Large beds are split into groups of juicyChannelGroupSize channels, one worker-pool task
+// each. Inside a group every channel runs its own scalar loop over the sub-block, in place on
+// the buffer, with its state held in locals and stored back once at the end.
+constexpr int juicyChannelGroupSize = 8;
+
+inline int juicyChannelGroups(int numChannels) noexcept
+{
+    return (juce::jmax(0, numChannels) + juicyChannelGroupSize - 1) / juicyChannelGroupSize;
+}
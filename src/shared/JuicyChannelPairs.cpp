@@ -0,0 +1,46 @@
+#include "JuicyChannelPairs.h"
+#include <array>
+#include <utility>
+
+std::vector<JuicyChannelPair> findJuicyChannelPairs(const juce::AudioChannelSet& layout)
+{
+    using Type = juce::AudioChannelSet::ChannelType;
+    std::vector<JuicyChannelPair> pairs;
+
+    if (layout.isDiscreteLayout())
+    {
+        for (int ch = 0; ch + 1 < layout.size(); ch += 2)
+            pairs.push_back({ ch, ch + 1 });
+        if (layout.size() % 2 != 0)
+            pairs.push_back({ layout.size() - 1, layout.size() - 1 });
+        return pairs;
+    }
+
+    constexpr std::array<std::pair<Type, Type>, 9> designated { {
+        { juce::AudioChannelSet::left, juce::AudioChannelSet::right },
+        { juce::AudioChannelSet::leftCentre, juce::AudioChannelSet::rightCentre },
+        { juce::AudioChannelSet::wideLeft, juce::AudioChannelSet::wideRight },
+        { juce::AudioChannelSet::leftSurround, juce::AudioChannelSet::rightSurround },
+        { juce::AudioChannelSet::leftSurroundSide, juce::AudioChannelSet::rightSurroundSide },
+        { juce::AudioChannelSet::leftSurroundRear, juce::AudioChannelSet::rightSurroundRear },
+        { juce::AudioChannelSet::topFrontLeft, juce::AudioChannelSet::topFrontRight },
+        { juce::AudioChannelSet::topSideLeft, juce::AudioChannelSet::topSideRight },
+        { juce::AudioChannelSet::topRearLeft, juce::AudioChannelSet::topRearRight }
+    } };
+
+    for (const auto& [leftType, rightType] : designated)
+    {
+        const int left = layout.getChannelIndexForType(leftType);
+        const int right = layout.getChannelIndexForType(rightType);
+        if (left >= 0 && right >= 0)
+            pairs.push_back({ left, right });
+    }
+
+    std::vector<bool> paired(static_cast<size_t>(layout.size()), false);
+    for (const auto& pair : pairs)
+        paired[static_cast<size_t>(pair.left)] = paired[static_cast<size_t>(pair.right)] = true;
+    for (int ch = 0; ch < layout.size(); ++ch)
+        if (! paired[static_cast<size_t>(ch)])
+            pairs.push_back({ ch, ch });
+    return pairs;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+struct JuicyChannelPair
+{
+    int left = 0;
+    int right = 1;
+};
+
+// Designated left/right pairs of a bus layout: front, wide, side, rear and height pairs,
+// followed by every channel without a partner (centre, LFE, top centre, the last channel of
+// an odd discrete layout) as a single-channel pair { ch, ch }, so the stereo processors still
+// apply their mix and output gain there. Discrete layouts carry no speaker names and are
+// paired in channel order.
+std::vector<JuicyChannelPair> findJuicyChannelPairs(const juce::AudioChannelSet& layout);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// The cheapest monotonic counter the CPU offers: the time-stamp counter on x86, the virtual
+// counter on 64-bit ARM, and the high-resolution clock elsewhere.
+inline juce::uint64 juicyReadCycles() noexcept
+{
+   #if JUCE_INTEL
+    return static_cast<juce::uint64>(__rdtsc());
+   #elif JUCE_ARM && JUCE_64BIT && (JUCE_GCC || JUCE_CLANG)
+    juce::uint64 value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+   #else
+    return static_cast<juce::uint64>(juce::Time::getHighResolutionTicks());
+   #endif
+}
+
+// Counter rate measured against the high-resolution clock. The measurement spins for a couple
+// of milliseconds, which places the rate within a fraction of a percent; it runs once, on the
+// first call, and every later call returns the same value. Make that first call off the audio
+// thread.
+inline double juicyCyclesPerSecond()
+{
+    static const double cyclesPerSecond = []
+    {
+        const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = juicyReadCycles();
+        auto elapsedTicks = static_cast<juce::int64>(0);
+        while (static_cast<double>(elapsedTicks) < 0.002 * ticksPerSecond)
+            elapsedTicks = juce::Time::getHighResolutionTicks() - startTicks;
+        const auto elapsedCycles = juicyReadCycles() - startCycles;
+        return juce::jmax(1.0, static_cast<double>(elapsedCycles) * ticksPerSecond / static_cast<double>(elapsedTicks));
+    }();
+    return cyclesPerSecond;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+#include <limits>
+
+// Level treated as digital silence (-120 dBFS). Tails are reported as the time their slowest
+// feedback path needs to fall from full scale to this level.
+constexpr float juicySilenceThreshold = 1.0e-6f;
+
+inline bool isJuicyBufferSilent(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+    for (int ch = 0; ch < juce::jmin(numChannels, buffer.getNumChannels()); ++ch)
+        if (buffer.getMagnitude(ch, 0, buffer.getNumSamples()) > juicySilenceThreshold)
+            return false;
+    return true;
+}
+
+inline bool isJuicyStateSilent(const float* state, int count) noexcept
+{
+    for (int i = 0; i < count; ++i)
+        if (std::abs(state[i]) > juicySilenceThreshold)
+            return false;
+    return true;
+}
+
+// Seconds a state multiplied by feedbackPerSample every sample takes to decay to silence.
+inline double juicyDecaySeconds(double feedbackPerSample, double sampleRate) noexcept
+{
+    const double g = std::abs(feedbackPerSample);
+    if (g <= 0.0 || sampleRate <= 0.0)
+        return 0.0;
+    if (g >= 1.0)
+        return std::numeric_limits<double>::infinity();
+    return std::log(static_cast<double>(juicySilenceThreshold)) / std::log(g) / sampleRate;
+}
+
+// Decides when processBlock can take the idle path: the input is silent, and either the
+// processor's state has decayed below the threshold or the input has been silent for longer
+// than the state can ring (the bound for processors whose own noise keeps state alive).
+// The state is cleared once on entry; the first non-silent block wakes the processor and runs
+// the full path from that cleared state, which only differs from the decayed one below -120 dB.
+class JuicyIdleDetector
+{
+public:
+    void reset() noexcept
+    {
+        silentSamples = 0;
+        idle = false;
+        entered = false;
+    }
+
+    template <typename StateCheck>
+    bool update(bool inputSilent, int numSamples, double maxSilentSeconds, double sampleRate, StateCheck&& isStateSilent) noexcept
+    {
+        entered = false;
+        if (! inputSilent)
+        {
+            silentSamples = 0;
+            idle = false;
+            return false;
+        }
+
+        const bool ringOut = static_cast<double>(silentSamples) >= maxSilentSeconds * sampleRate;
+        silentSamples += numSamples;
+        if (! idle && (ringOut || isStateSilent()))
+            idle = entered = true;
+        return idle;
+    }
+
+    // True for the block that switched to idle, so the processor clears its state once.
+    bool hasJustEntered() const noexcept { return entered; }
+
+private:
+    juce::int64 silentSamples = 0;
+    bool idle = false;
+    bool entered = false;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "JuicinessAnalyzer.h"
+#include "JuicyStageProfiler.h"
+#include "JuicyWorkerPool.h"
+
+// Everything a DSP kernel takes from its host for one block besides the audio and its
+// parameters. Kernels feed the analyzers from inside their sub-block loops, so the host begins
+// and finishes the analysis blocks around process(); a null analyzer is simply not fed. With a
+// profiler, the feeding is charged to the pre and post analysis stages.
+struct JuicyKernelContext
+{
+    JuicinessAnalyzer* preAnalyzer = nullptr;
+    JuicinessAnalyzer* postAnalyzer = nullptr;
+    JuicyWorkerPool* workerPool = nullptr;
+    JuicyStageProfiler* profiler = nullptr;
+    int parallelChannelThreshold = 0; // 0 keeps the kernel serial
+    bool reducedDsp = false;          // JuicyQualityTier::reducedDsp
+    bool offlineQuality = false;      // non-realtime render path
+    juce::int64 samplePosition = 0;   // JuicyTimeline position of the block's first sample
+
+    void analyseInput(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) const noexcept
+    {
+        if (preAnalyzer != nullptr)
+        {
+            JUICY_PROFILE_STAGE(profiler, JuicyProfileStage::preAnalysis);
+            preAnalyzer->accumulate(buffer, startSample, numSamples);
+        }
+    }
+
+    void analyseOutput(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) const noexcept
+    {
+        if (postAnalyzer != nullptr)
+        {
+            JUICY_PROFILE_STAGE(profiler, JuicyProfileStage::postAnalysis);
+            postAnalyzer->accumulate(buffer, startSample, numSamples);
+        }
+    }
+
+    bool runsParallel(int numChannels) const noexcept
+    {
+        return workerPool != nullptr && parallelChannelThreshold > 0 && numChannels >= parallelChannelThreshold;
+    }
+
+    // Calls task(index) for every index in [0, numTasks), on the worker pool when the layout is
+    // wide enough and on the calling thread otherwise.
+    template <typename Fn>
+    void forEachTask(int numChannels, int numTasks, Fn&& task) const noexcept
+    {
+        if (runsParallel(numChannels))
+            workerPool->run(numTasks, task);
+        else
+            for (int index = 0; index < numTasks; ++index)
+                task(index);
+    }
+};
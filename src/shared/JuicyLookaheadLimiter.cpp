@@ -0,0 +1,115 @@
+#include "JuicyLookaheadLimiter.h"
+#include "JuicyIdle.h"
+#include <algorithm>
+
+namespace
+{
+// Required gains are summed as fixed point, so adding a value and later removing the same value
+// leaves the sum exactly where it was. They are rounded down, which never lets the average
+// above the gain a peak needs.
+constexpr double gainOne = 1073741824.0; // 2^30
+}
+
+void JuicyLookaheadLimiter::prepare(double sampleRate, int channels, double lookaheadSeconds, double releaseSeconds)
+{
+    numChannels = juce::jmax(1, channels);
+    lookahead = juce::jmax(1, juce::roundToInt(lookaheadSeconds * sampleRate));
+    window = lookahead + 1;
+    releaseCoeff = 1.0f - std::exp(-1.0f / static_cast<float>(juce::jmax(1.0e-4, releaseSeconds) * sampleRate));
+
+    arena.beginLayout();
+    delaySlot = arena.reserveHot<float>(static_cast<size_t>(numChannels * lookahead));
+    peakSlot = arena.reserveHot<PeakEntry>(static_cast<size_t>(window));
+    gainSlot = arena.reserveHot<uint32_t>(static_cast<size_t>(window));
+    arena.allocate();
+    reset();
+}
+
+void JuicyLookaheadLimiter::reset() noexcept
+{
+    arena.fill(delaySlot, 0.0f);
+    arena.fill(gainSlot, static_cast<uint32_t>(gainOne));
+    delayPos = 0;
+    peakHead = 0;
+    peakCount = 0;
+    gainPos = 0;
+    gainSum = static_cast<uint64_t>(window) * static_cast<uint64_t>(gainOne);
+    gain = 1.0f;
+    now = 0;
+}
+
+bool JuicyLookaheadLimiter::isSilent() const noexcept
+{
+    return isJuicyStateSilent(arena.get(delaySlot), numChannels * lookahead);
+}
+
+void JuicyLookaheadLimiter::readPending(float* destination, int destinationChannels) const noexcept
+{
+    const auto* delay = arena.get(delaySlot);
+    for (int ch = 0; ch < destinationChannels; ++ch)
+        for (int i = 0; i < lookahead; ++i)
+            destination[ch * lookahead + i] = delay != nullptr && ch < numChannels
+                                                  ? delay[ch * lookahead + (delayPos + i) % lookahead] * gain
+                                                  : 0.0f;
+}
+
+void JuicyLookaheadLimiter::resetWithPending(const float* source, int sourceChannels) noexcept
+{
+    reset();
+    if (auto* delay = arena.get(delaySlot))
+        std::copy(source, source + juce::jmin(numChannels, sourceChannels) * lookahead, delay);
+}
+
+void JuicyLookaheadLimiter::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, float ceiling) noexcept
+{
+    auto* delay = arena.get(delaySlot);
+    auto* peaks = arena.get(peakSlot);
+    auto* gains = arena.get(gainSlot);
+    if (delay == nullptr)
+        return;
+
+    const int channels = juce::jmin(numChannels, buffer.getNumChannels());
+    auto* const* data = buffer.getArrayOfWritePointers();
+    const double boxScale = 1.0 / (gainOne * static_cast<double>(window));
+
+    for (int i = startSample; i < startSample + numSamples; ++i)
+    {
+        float peak = 0.0f;
+        for (int ch = 0; ch < channels; ++ch)
+            peak = juce::jmax(peak, std::abs(data[ch][i]));
+
+        // Sliding maximum: entries stay sorted by falling peak, so the front is the loudest
+        // sample still inside the window.
+        if (peakCount > 0 && now - peaks[peakHead].time >= static_cast<uint32_t>(window))
+        {
+            peakHead = (peakHead + 1) % window;
+            --peakCount;
+        }
+        while (peakCount > 0 && peaks[(peakHead + peakCount - 1) % window].peak <= peak)
+            --peakCount;
+        peaks[(peakHead + peakCount) % window] = { peak, now };
+        ++peakCount;
+        ++now;
+
+        const float windowPeak = peaks[peakHead].peak;
+        const float required = windowPeak > ceiling ? ceiling / windowPeak : 1.0f;
+        const auto fixedRequired = static_cast<uint32_t>(static_cast<double>(required) * gainOne);
+        gainSum += fixedRequired;
+        gainSum -= gains[gainPos];
+        gains[gainPos] = fixedRequired;
+        gainPos = (gainPos + 1) % window;
+
+        // Falling gain follows the average at once; rising gain releases smoothly.
+        const float target = juce::jmin(1.0f, static_cast<float>(static_cast<double>(gainSum) * boxScale));
+        gain = target < gain ? target : gain + (target - gain) * releaseCoeff;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            float& slot = delay[ch * lookahead + delayPos];
+            const float delayed = slot;
+            slot = data[ch][i];
+            data[ch][i] = delayed * gain;
+        }
+        delayPos = (delayPos + 1) % lookahead;
+    }
+}
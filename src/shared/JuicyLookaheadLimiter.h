@@ -0,0 +1,59 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstdint>
+#include "JuicyStateArena.h"
+
+// Linked peak limiter with a short lookahead. The output is the input delayed by
+// getLatencySamples(); every channel gets the same gain, driven by the loudest of them.
+//
+// The peak over the lookahead window comes from a monotonic deque, so each sample costs O(1)
+// amortised whatever the window length. The gain that peak needs is then box-averaged over the
+// same window, as a running sum of fixed-point gains that stays exact without resyncing. Every
+// value in the average was computed while the peak was already in view, so the gain has ramped
+// fully down by the time the peak leaves the delay line and the ceiling is never crossed,
+// without clipping or an instant gain step.
+class JuicyLookaheadLimiter
+{
+public:
+    void prepare(double sampleRate, int numChannels, double lookaheadSeconds, double releaseSeconds);
+    void reset() noexcept;
+
+    int getLatencySamples() const noexcept { return lookahead; }
+
+    // Limits the first numChannels channels of [startSample, startSample + numSamples) in place.
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, float ceiling) noexcept;
+
+    // True when nothing audible is still waiting in the delay line.
+    bool isSilent() const noexcept;
+
+    // The samples waiting in the delay line, oldest first and getLatencySamples() per channel,
+    // for handing them to a plain delay that replaces the limiter. readPending() applies the
+    // current gain; resetWithPending() is reset() with the delay line holding the given samples.
+    void readPending(float* destination, int destinationChannels) const noexcept;
+    void resetWithPending(const float* source, int sourceChannels) noexcept;
+
+private:
+    struct PeakEntry
+    {
+        float peak;
+        uint32_t time;
+    };
+
+    JuicyStateArena arena;
+    JuicyStateArena::Slot<float> delaySlot;
+    JuicyStateArena::Slot<PeakEntry> peakSlot;
+    JuicyStateArena::Slot<uint32_t> gainSlot;
+    int numChannels = 0;
+    int lookahead = 0;
+    int window = 0;
+    float releaseCoeff = 0.0f;
+
+    int delayPos = 0;
+    int peakHead = 0;
+    int peakCount = 0;
+    int gainPos = 0;
+    uint64_t gainSum = 0;
+    float gain = 1.0f;
+    uint32_t now = 0;
+};
@@ -30,6 +30,7 @@ void JuicyMeterPanel::setMetrics(const JuicinessMetrics& newMetrics)
     metrics.clarity = smoothValue(metrics.clarity, newMetrics.clarity);
     metrics.width = smoothValue(metrics.width, newMetrics.width);
     metrics.monoSafety = smoothValue(metrics.monoSafety, newMetrics.monoSafety);
+    metrics.qualityTier = newMetrics.qualityTier;
     repaint();
 }
 
@@ -125,7 +126,17 @@ void JuicyMeterPanel::paint(juce::Graphics& g)
 
     g.setColour(juce::Colour(0xffe4e9ef));
     g.setFont(juce::FontOptions(13.0f, juce::Font::bold));
-    g.drawText("JUICINESS INDEX", top.removeFromTop(26), juce::Justification::centredLeft);
+    auto titleRow = top.removeFromTop(26);
+    g.drawText("JUICINESS INDEX", titleRow, juce::Justification::centredLeft);
+    if (metrics.qualityTier > 0)
+    {
+        // Shown only while the processor is saving CPU, matching JuicyQualityTier.
+        static const char* const tierNames[] = { "FULL", "POST ANALYSIS ONLY", "DECIMATED ANALYSIS", "REDUCED DSP" };
+        const int tier = juce::jlimit(0, 3, metrics.qualityTier);
+        g.setColour(juce::Colour(0xfff39c12).withAlpha(0.85f));
+        g.setFont(juce::FontOptions(11.0f, juce::Font::bold));
+        g.drawText(juce::String("CPU SAVER: ") + tierNames[tier], titleRow, juce::Justification::centredRight);
+    }
     auto metersRow = top.removeFromTop(70).reduced(0, 4);
     auto leftMeter = metersRow.removeFromLeft((metersRow.getWidth() - 10) / 2);
     metersRow.removeFromLeft(10);
@@ -1,5 +1,13 @@
 #include "JuicyPluginEditor.h"
 
+// Long parameter lists (the chain plugin) spread over more columns instead of squashing rows.
+static int columnsForControls(size_t numControls)
+{
+    if (numControls > 16)
+        return 4;
+    return numControls > 4 ? 2 : 1;
+}
+
 static juce::Colour accentFromTitle(const juce::String& title)
 {
     const juce::uint32 h = static_cast<juce::uint32>(title.hashCode());
@@ -30,9 +38,18 @@ JuicyPluginEditor::JuicyPluginEditor(juce::AudioProcessor& audioProcessor,
     meterPanel.setShowGhostStats(showGhostStats);
     meterPanel.setShowTriangleMetrics(showTriangleMetrics);
     addAndMakeVisible(meterPanel);
+    profilerPanel.setAccentColour(accent);
+    addChildComponent(profilerPanel);
+    profilerToggle.setClickingTogglesState(true);
+    profilerToggle.setColour(juce::TextButton::buttonColourId, juce::Colour(0xff171b21));
+    profilerToggle.setColour(juce::TextButton::buttonOnColourId, accent.withMultipliedSaturation(0.72f));
+    profilerToggle.onClick = [this] { showProfiler(profilerToggle.getToggleState()); };
+    addChildComponent(profilerToggle);
     createControls();
 
-    setSize(880, 560);
+    const int columns = columnsForControls(controls.size());
+    const int rows = (static_cast<int>(controls.size()) + columns - 1) / columns;
+    setSize(columns > 2 ? 1320 : 880, juce::jmax(560, 330 + rows * 58));
     startTimerHz(20);
 }
 
@@ -45,22 +62,23 @@ void JuicyPluginEditor::resized()
 {
     auto bounds = getLocalBounds().reduced(22, 20);
     auto header = bounds.removeFromTop(36);
+    profilerToggle.setBounds(header.removeFromRight(56).reduced(0, 6));
     titleLabel.setBounds(header);
     bounds.removeFromTop(10);
 
     const int meterHeight = juce::jlimit(214, 260, static_cast<int>(bounds.getHeight() * 0.46f));
-    meterPanel.setBounds(bounds.removeFromTop(meterHeight));
+    const auto meterArea = bounds.removeFromTop(meterHeight);
+    meterPanel.setBounds(meterArea);
+    profilerPanel.setBounds(meterArea);
     bounds.removeFromTop(14);
 
     auto controlsArea = bounds;
     if (controls.empty())
         return;
 
-    const int columns = controls.size() > 4 ? 2 : 1;
+    const int columns = columnsForControls(controls.size());
     const int gap = 14;
-    const int columnWidth = columns == 1
-        ? controlsArea.getWidth()
-        : (controlsArea.getWidth() - gap) / 2;
+    const int columnWidth = (controlsArea.getWidth() - gap * (columns - 1)) / columns;
     const int rows = (static_cast<int>(controls.size()) + columns - 1) / columns;
     const int rowHeight = juce::jmax(58, controlsArea.getHeight() / juce::jmax(1, rows));
 
@@ -82,8 +100,34 @@ void JuicyPluginEditor::resized()
     }
 }
 
+void JuicyPluginEditor::setStageProfiler(JuicyStageProfiler* profilerToShow)
+{
+    if (! JuicyStageProfiler::isEnabled())
+        return;
+
+    profiler = profilerToShow;
+    profilerToggle.setVisible(profiler != nullptr);
+}
+
+void JuicyPluginEditor::showProfiler(bool shouldShow)
+{
+    // Figures start from scratch each time the panel opens, so they describe what is playing now.
+    if (shouldShow && profiler != nullptr)
+        profiler->requestReset();
+    profilerPanel.setVisible(shouldShow);
+    meterPanel.setVisible(! shouldShow);
+}
+
 void JuicyPluginEditor::timerCallback()
 {
+    if (profiler != nullptr && profilerPanel.isVisible())
+    {
+        std::array<JuicyStageLoad, juicyNumProfileStages> loads;
+        for (int stage = 0; stage < juicyNumProfileStages; ++stage)
+            loads[static_cast<size_t>(stage)] = profiler->getLoad(static_cast<JuicyProfileStage>(stage));
+        profilerPanel.setLoads(loads);
+    }
+
     if (!metricsProvider)
         return;
     meterPanel.setMetrics(metricsProvider());
@@ -107,7 +151,8 @@ void JuicyPluginEditor::createControls()
             || withID->paramID == "synesthesia"
             || withID->paramID == "fatigue"
             || withID->paramID == "repetition"
-            || withID->paramID == "contextfit")
+            || withID->paramID == "contextfit"
+            || withID->paramID == "qualitytier")
             continue;
 
         ParamControl control;
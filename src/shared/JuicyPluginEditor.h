@@ -5,6 +5,7 @@
 #include <vector>
 #include <functional>
 #include "JuicyMeterPanel.h"
+#include "JuicyProfilerPanel.h"
 
 class JuicyPluginEditor : public juce::AudioProcessorEditor, private juce::Timer
 {
@@ -22,6 +23,10 @@ public:
     void resized() override;
     void paint(juce::Graphics& g) override;
 
+    // Adds a CPU toggle to the header that swaps the meters for the per-stage profile. Does
+    // nothing in builds without JUICY_PROFILE_STAGES.
+    void setStageProfiler(JuicyStageProfiler* profilerToShow);
+
 private:
     struct ParamControl
     {
@@ -32,11 +37,15 @@ private:
 
     void timerCallback() override;
     void createControls();
+    void showProfiler(bool shouldShow);
 
     juce::AudioProcessorValueTreeState& state;
     MetricsProvider metricsProvider;
     juce::Label titleLabel;
     JuicyMeterPanel meterPanel;
+    JuicyProfilerPanel profilerPanel;
+    juce::TextButton profilerToggle { "CPU" };
+    JuicyStageProfiler* profiler = nullptr;
     std::vector<ParamControl> controls;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuicyPluginEditor)
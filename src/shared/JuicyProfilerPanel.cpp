@@ -0,0 +1,74 @@
+#include "JuicyProfilerPanel.h"
+
+void JuicyProfilerPanel::setLoads(const std::array<JuicyStageLoad, juicyNumProfileStages>& newLoads)
+{
+    loads = newLoads;
+    repaint();
+}
+
+void JuicyProfilerPanel::setAccentColour(juce::Colour colour)
+{
+    accent = colour;
+    repaint();
+}
+
+void JuicyProfilerPanel::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+    g.setColour(juce::Colour(0xff12161b));
+    g.fillRect(bounds);
+    g.setColour(juce::Colour(0xff2a323b));
+    g.drawRect(bounds, 1);
+
+    auto content = bounds.reduced(14, 10);
+    g.setColour(juce::Colour(0xffe4e9ef));
+    g.setFont(juce::FontOptions(13.0f, juce::Font::bold));
+    auto titleRow = content.removeFromTop(26);
+    g.drawText("CPU PER STAGE", titleRow, juce::Justification::centredLeft);
+    g.setColour(juce::Colour(0xffb9c2cd).withAlpha(0.6f));
+    g.setFont(juce::FontOptions(11.0f, juce::Font::plain));
+    g.drawText("% of block deadline: bar mean | tick p99 | line max", titleRow, juce::Justification::centredRight);
+    content.removeFromTop(6);
+
+    // The bars share one scale so the stages compare directly; it grows past the deadline
+    // only when a stage overruns it.
+    float scale = 100.0f;
+    for (const auto& load : loads)
+        scale = juce::jmax(scale, load.max);
+
+    static const char* const stageNames[] = { "Pre analysis", "DSP", "Post analysis", "Host notification" };
+    const int gap = 6;
+    const int row = juce::jmax(26, (content.getHeight() - gap * (juicyNumProfileStages - 1)) / juicyNumProfileStages);
+
+    for (int stage = 0; stage < juicyNumProfileStages; ++stage)
+    {
+        const auto& load = loads[static_cast<size_t>(stage)];
+        auto bg = content.removeFromTop(row).reduced(0, 4);
+        content.removeFromTop(gap);
+
+        g.setColour(juce::Colour(0xff171c22));
+        g.fillRect(bg);
+        g.setColour(juce::Colour(0xff2a313a));
+        g.drawRect(bg, 1);
+
+        const auto xFor = [&bg, scale](float percent)
+        {
+            return bg.getX() + juce::jlimit(0, bg.getWidth(), static_cast<int>(std::round(percent / scale * static_cast<float>(bg.getWidth()))));
+        };
+
+        g.setColour(accent.withMultipliedSaturation(0.72f));
+        g.fillRect(bg.withRight(xFor(load.mean)));
+        g.setColour(juce::Colour(0xffe4ebf2).withAlpha(0.7f));
+        g.fillRect(juce::Rectangle<int>(xFor(load.p99) - 1, bg.getY() + 2, 3, bg.getHeight() - 4));
+        g.setColour(juce::Colour(0xfff26d6d).withAlpha(0.8f));
+        g.drawVerticalLine(xFor(load.max), static_cast<float>(bg.getY() + 2), static_cast<float>(bg.getBottom() - 2));
+
+        g.setColour(juce::Colour(0xffd8dee7));
+        g.setFont(juce::FontOptions(12.0f, juce::Font::plain));
+        g.drawText(stageNames[stage], bg.reduced(10, 0), juce::Justification::centredLeft);
+        g.setFont(juce::FontOptions(12.0f, juce::Font::bold));
+        g.setColour(juce::Colour(0xffe8edf2));
+        g.drawText(juce::String(load.mean, 2) + "% | " + juce::String(load.p99, 2) + "% | " + juce::String(load.max, 2) + "%",
+                   bg.reduced(10, 0), juce::Justification::centredRight);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "JuicyStageProfiler.h"
+
+// Shows JuicyStageProfiler's per-stage loads: a bar for the mean, a tick for p99 and one for
+// the max, all scaled to the block deadline.
+class JuicyProfilerPanel : public juce::Component
+{
+public:
+    void setLoads(const std::array<JuicyStageLoad, juicyNumProfileStages>& newLoads);
+    void setAccentColour(juce::Colour colour);
+    void paint(juce::Graphics& g) override;
+
+private:
+    std::array<JuicyStageLoad, juicyNumProfileStages> loads {};
+    juce::Colour accent = juce::Colour(0xfff39c12);
+};
@@ -0,0 +1,133 @@
+#include "JuicyQualityGovernor.h"
+
+namespace
+{
+// Share of the block deadline one processor may use before it steps down a tier, and the share
+// of the host's cycle that may be gone when a block finishes. The load is the larger of the two
+// measured against its budget; under recoverLoad it is allowed back up. The gap keeps the
+// tiers from flapping.
+constexpr float ownBudget = 0.5f;
+constexpr float cycleBudget = 0.75f;
+constexpr float recoverLoad = 0.4f;
+// The schedule may drift this share of a block per block, which follows any drift between the
+// audio clock and the cycle counter but not a lasting overload. A block starting this many
+// periods late is taken as a pause in the stream (transport stop, host idle) and re-anchors it.
+constexpr double scheduleDriftShare = 1.0e-4;
+constexpr double schedulePauseBlocks = 4.0;
+// Time a new tier gets to show its effect before the next step down, and how long the load has
+// to stay low before a step back up.
+constexpr double holdSeconds = 0.25;
+constexpr double recoverySeconds = 2.0;
+}
+
+JuicyQualityGovernor::ScopedBlock::ScopedBlock(JuicyQualityGovernor& governorToUse, int numSamples, bool isNonRealtime) noexcept
+    : governor(governorToUse),
+      blockSamples(numSamples),
+      startCycles(juicyReadCycles())
+{
+    governor.beginBlock(isNonRealtime);
+}
+
+JuicyQualityGovernor::ScopedBlock::~ScopedBlock()
+{
+    governor.endBlock(blockSamples, startCycles, juicyReadCycles());
+}
+
+void JuicyQualityGovernor::prepare(double sampleRate, JuicyQualityTier lowestTier)
+{
+    sr = sampleRate;
+    cyclesPerSecond = juicyCyclesPerSecond();
+    scheduleAnchored = false;
+    streamedSamples = 0;
+    cheapestTier = lowestTier;
+    blockIndex = 0;
+    smoothedLoad = 0.0f;
+    holdSamples = 0;
+    recoverySamples = 0;
+    setTier(JuicyQualityTier::full);
+    blockTier = JuicyQualityTier::full;
+}
+
+void JuicyQualityGovernor::beginBlock(bool isNonRealtime) noexcept
+{
+    blockIsNonRealtime = isNonRealtime;
+    if (isNonRealtime && getTier() != JuicyQualityTier::full)
+        setTier(JuicyQualityTier::full);
+
+    blockTier = getTier();
+    ++blockIndex;
+}
+
+float JuicyQualityGovernor::measureCycleShare(int numSamples, juce::uint64 startCycles, juce::uint64 endCycles) noexcept
+{
+    // Blocks of a healthy stream start one period after another, give or take the host's
+    // jitter and the work it runs ahead of this block. The earliest such start is the cycle's
+    // start as far as this block can tell; how far past it the block ends is the share of the
+    // cycle used so far, including by every instance that ran before this one.
+    const double period = static_cast<double>(numSamples) / sr;
+    const double start = static_cast<double>(startCycles) / cyclesPerSecond;
+    const double end = static_cast<double>(endCycles) / cyclesPerSecond;
+    const double offset = start - static_cast<double>(streamedSamples) / sr;
+    streamedSamples += numSamples;
+
+    if (! scheduleAnchored || offset < scheduleOffset || offset - scheduleOffset > schedulePauseBlocks * period)
+    {
+        scheduleOffset = offset;
+        scheduleAnchored = true;
+    }
+    else
+        scheduleOffset += scheduleDriftShare * period;
+
+    const double cycleStart = scheduleOffset + static_cast<double>(streamedSamples - numSamples) / sr;
+    return static_cast<float>(juce::jmax(0.0, end - cycleStart) / period);
+}
+
+void JuicyQualityGovernor::endBlock(int numSamples, juce::uint64 startCycles, juce::uint64 endCycles) noexcept
+{
+    if (blockIsNonRealtime || numSamples <= 0 || cyclesPerSecond <= 0.0)
+    {
+        scheduleAnchored = false;
+        return;
+    }
+
+    const double deadlineCycles = static_cast<double>(numSamples) / sr * cyclesPerSecond;
+    const auto ownShare = static_cast<float>(static_cast<double>(endCycles - startCycles) / deadlineCycles);
+    const float cycleShare = measureCycleShare(numSamples, startCycles, endCycles);
+    const float load = juce::jmax(ownShare / ownBudget, cycleShare / cycleBudget);
+    // Rise fast so a burst of overruns acts within a few blocks, fall slowly so one quiet
+    // block does not hide a heavy passage.
+    smoothedLoad += (load - smoothedLoad) * (load > smoothedLoad ? 0.5f : 0.1f);
+
+    const auto tier = getTier();
+    holdSamples = juce::jmax(static_cast<juce::int64>(0), holdSamples - numSamples);
+    if (smoothedLoad > 1.0f)
+    {
+        recoverySamples = 0;
+        if (holdSamples == 0 && tier < cheapestTier)
+        {
+            setTier(static_cast<JuicyQualityTier>(static_cast<int>(tier) + 1));
+            holdSamples = static_cast<juce::int64>(holdSeconds * sr);
+        }
+    }
+    else if (smoothedLoad < recoverLoad && tier != JuicyQualityTier::full)
+    {
+        recoverySamples += numSamples;
+        if (recoverySamples >= static_cast<juce::int64>(recoverySeconds * sr))
+        {
+            setTier(static_cast<JuicyQualityTier>(static_cast<int>(tier) - 1));
+            recoverySamples = 0;
+            holdSamples = static_cast<juce::int64>(holdSeconds * sr);
+        }
+    }
+    else
+    {
+        recoverySamples = 0;
+    }
+}
+
+void JuicyQualityGovernor::setTier(JuicyQualityTier newTier) noexcept
+{
+    publishedTier.store(static_cast<int>(newTier), std::memory_order_relaxed);
+    if (hostParameter != nullptr)
+        hostParameter->setValueNotifyingHost(hostParameter->getNormalisableRange().convertTo0to1(static_cast<float>(newTier)));
+}
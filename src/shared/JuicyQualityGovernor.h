@@ -0,0 +1,88 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include "JuicyCycleCounter.h"
+
+// Processing tiers from most to least expensive. Each tier also drops what the tiers above
+// it dropped. Analysis only drives the meters and host outputs, so it goes first.
+enum class JuicyQualityTier
+{
+    full,              // pre and post analysis on every block
+    postAnalysisOnly,  // input analysis off, the pre score holds its last value
+    decimatedAnalysis, // post analysis on one block in every juicyAnalysisDecimation
+    reducedDsp         // processors with optional DSP detail render without it
+};
+
+constexpr int juicyAnalysisDecimation = 4;
+
+// Times every processBlock against its real-time deadline and steps the processor down a tier
+// when the session is running out of time, then back up once it has stayed well inside the
+// deadline for a while. Two measurements count: this processor's own share of the deadline,
+// and how far into the host's audio cycle the block finishes. The second grows with
+// everything the host ran before this block, so a session of hundreds of light instances
+// steps down even though no single one is expensive. Non-realtime rendering always runs at
+// full quality, so offline bounces do not depend on the machine they are rendered on. Tiers
+// only change between blocks.
+class JuicyQualityGovernor
+{
+public:
+    // Times one processBlock call: construct it first thing in processBlock and let it go out of
+    // scope with the call, so early returns are measured too.
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(JuicyQualityGovernor& governorToUse, int numSamples, bool isNonRealtime) noexcept;
+        ~ScopedBlock();
+
+    private:
+        JuicyQualityGovernor& governor;
+        const int blockSamples;
+        const juce::uint64 startCycles;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    // lowestTier is the cheapest tier this processor has anything to drop for.
+    void prepare(double sampleRate, JuicyQualityTier lowestTier);
+
+    // The governor pushes every tier change to this parameter, mirroring how the juiciness
+    // score reaches the host.
+    void setHostParameter(juce::RangedAudioParameter* parameter) noexcept { hostParameter = parameter; }
+
+    JuicyQualityTier getTier() const noexcept { return static_cast<JuicyQualityTier>(publishedTier.load(std::memory_order_relaxed)); }
+
+    // What the current block runs; only meaningful on the audio thread inside a ScopedBlock.
+    bool runsPreAnalysis() const noexcept { return blockTier == JuicyQualityTier::full; }
+    bool runsPostAnalysis() const noexcept
+    {
+        return blockTier < JuicyQualityTier::decimatedAnalysis || blockIndex % juicyAnalysisDecimation == 0;
+    }
+    bool runsReducedDsp() const noexcept { return blockTier == JuicyQualityTier::reducedDsp; }
+    // Non-realtime blocks render through the processor's offline path, which may trade any
+    // amount of CPU for quality while sharing the real-time parameter mapping.
+    bool runsOfflineQuality() const noexcept { return blockIsNonRealtime; }
+
+private:
+    void beginBlock(bool isNonRealtime) noexcept;
+    void endBlock(int numSamples, juce::uint64 startCycles, juce::uint64 endCycles) noexcept;
+    float measureCycleShare(int numSamples, juce::uint64 startCycles, juce::uint64 endCycles) noexcept;
+    void setTier(JuicyQualityTier newTier) noexcept;
+
+    double sr = 44100.0;
+    double cyclesPerSecond = 1.0;
+    // The host's cycle schedule as seen from here: the earliest a block has started relative
+    // to the samples streamed so far, in seconds.
+    bool scheduleAnchored = false;
+    double scheduleOffset = 0.0;
+    juce::int64 streamedSamples = 0;
+    JuicyQualityTier cheapestTier = JuicyQualityTier::decimatedAnalysis;
+    JuicyQualityTier blockTier = JuicyQualityTier::full;
+    bool blockIsNonRealtime = false;
+    juce::uint32 blockIndex = 0;
+    float smoothedLoad = 0.0f;
+    juce::int64 holdSamples = 0;
+    juce::int64 recoverySamples = 0;
+    std::atomic<int> publishedTier { 0 };
+    juce::RangedAudioParameter* hostParameter = nullptr;
+};
@@ -0,0 +1,114 @@
+#include "JuicyStageProfiler.h"
+
+#if JUICY_PROFILE_STAGES
+#include <cmath>
+
+namespace
+{
+std::atomic<juce::uint32> nextInstanceId { 1 };
+}
+
+JuicyStageProfiler::JuicyStageProfiler()
+    : instanceId(nextInstanceId.fetch_add(1, std::memory_order_relaxed))
+{
+    JuicyTrace::startFromEnvironment();
+}
+
+void JuicyStageProfiler::prepare(double sampleRate)
+{
+    sr = sampleRate;
+    cyclesPerSecond = juicyCyclesPerSecond();
+    requestReset();
+}
+
+void JuicyStageProfiler::beginBlock(int numSamples) noexcept
+{
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+    {
+        for (auto& histogram : histograms)
+        {
+            for (auto& count : histogram.counts)
+                count.store(0, std::memory_order_relaxed);
+            histogram.blocks.store(0, std::memory_order_relaxed);
+            histogram.shareSum.store(0.0, std::memory_order_relaxed);
+            histogram.maxShare.store(0.0f, std::memory_order_relaxed);
+        }
+    }
+
+    deadlineCycles = juce::jmax(1.0, static_cast<double>(numSamples) / sr * cyclesPerSecond);
+    blockSamples = numSamples;
+    stageCycles.fill(0);
+    activeStage = JuicyProfileStage::dsp;
+    blockThread = juce::Thread::getCurrentThreadId();
+    blockActive = true;
+    lastCycles = juicyReadCycles();
+    if (JuicyTrace::isActive())
+        JuicyTrace::record(JuicyTrace::begin, JuicyTrace::blockName, instanceId, blockSamples, lastCycles);
+}
+
+void JuicyStageProfiler::endBlock() noexcept
+{
+    charge(juicyReadCycles());
+    blockActive = false;
+    if (JuicyTrace::isActive())
+        JuicyTrace::record(JuicyTrace::end, JuicyTrace::blockName, instanceId, blockSamples, lastCycles);
+
+    // Only this thread writes the histograms, so plain load/store pairs are enough; the
+    // atomics are there for the editor's reads.
+    for (size_t stage = 0; stage < histograms.size(); ++stage)
+    {
+        auto& histogram = histograms[stage];
+        const auto share = static_cast<float>(static_cast<double>(stageCycles[stage]) / deadlineCycles);
+        const int bucket = share > 0.0f
+            ? juce::jlimit(0, numBuckets - 1, static_cast<int>(std::floor((std::log2(share) - lowestOctave) * bucketsPerOctave)))
+            : 0;
+
+        auto& count = histogram.counts[static_cast<size_t>(bucket)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        histogram.shareSum.store(histogram.shareSum.load(std::memory_order_relaxed) + share, std::memory_order_relaxed);
+        if (share > histogram.maxShare.load(std::memory_order_relaxed))
+            histogram.maxShare.store(share, std::memory_order_relaxed);
+        histogram.blocks.store(histogram.blocks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+float JuicyStageProfiler::bucketUpperShare(int bucket) noexcept
+{
+    return std::exp2(static_cast<float>(bucket + 1) / static_cast<float>(bucketsPerOctave) + static_cast<float>(lowestOctave));
+}
+
+JuicyStageLoad JuicyStageProfiler::getLoad(JuicyProfileStage stage) const noexcept
+{
+    const auto& histogram = histograms[static_cast<size_t>(stage)];
+    const auto blocks = histogram.blocks.load(std::memory_order_acquire);
+    JuicyStageLoad load;
+    if (blocks == 0)
+        return load;
+
+    // The reads are not one snapshot, so the bucket total can run a block ahead of or behind
+    // the block count; the percentile is taken over whatever the buckets hold.
+    std::array<juce::uint32, numBuckets> counts {};
+    juce::uint64 total = 0;
+    for (size_t bucket = 0; bucket < counts.size(); ++bucket)
+    {
+        counts[bucket] = histogram.counts[bucket].load(std::memory_order_relaxed);
+        total += counts[bucket];
+    }
+
+    load.mean = 100.0f * static_cast<float>(histogram.shareSum.load(std::memory_order_relaxed) / static_cast<double>(blocks));
+    load.max = 100.0f * histogram.maxShare.load(std::memory_order_relaxed);
+
+    const auto target = static_cast<juce::uint64>(std::ceil(0.99 * static_cast<double>(total)));
+    juce::uint64 seen = 0;
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+    {
+        seen += counts[static_cast<size_t>(bucket)];
+        if (seen >= target)
+        {
+            load.p99 = juce::jmin(load.max, 100.0f * bucketUpperShare(bucket));
+            break;
+        }
+    }
+    return load;
+}
+#endif
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <atomic>
+
+// Set by the JUICY_ENABLE_PROFILER CMake option. Without it the profiling macros below expand
+// to nothing and JuicyStageProfiler is an empty placeholder.
+#ifndef JUICY_PROFILE_STAGES
+ #define JUICY_PROFILE_STAGES 0
+#endif
+
+#if JUICY_PROFILE_STAGES
+ #include "JuicyTrace.h"
+#endif
+
+// The parts of processBlock the profiler tells apart. Time not spent inside one of the other
+// stages is charged to DSP.
+enum class JuicyProfileStage
+{
+    preAnalysis,
+    dsp,
+    postAnalysis,
+    hostNotification
+};
+
+constexpr int juicyNumProfileStages = 4;
+
+// One stage's cost as a percentage of the block deadline (block length / sample rate).
+struct JuicyStageLoad
+{
+    float mean = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+#if JUICY_PROFILE_STAGES
+// Times the stages of every processBlock with the CPU cycle counter. Stage timers nest: an
+// inner stage pauses the one around it, so each cycle is charged to exactly one stage. Only
+// the thread that runs the block records; analysis that a kernel hands to the worker pool is
+// counted as DSP. At the end of each block every stage's share of the deadline goes into a
+// log-bucket histogram made of atomics, which the editor reads without locking. While a
+// JuicyTrace session runs, the same scopes are also written out as timeline events.
+class JuicyStageProfiler
+{
+public:
+    // Also starts a trace session when the JUICY_TRACE environment variable names a file, so
+    // any host, the Standalone build included, can record a timeline without code changes.
+    JuicyStageProfiler();
+
+    static constexpr bool isEnabled() noexcept { return true; }
+
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(JuicyStageProfiler* profilerToUse, int numSamples) noexcept
+            : profiler(profilerToUse)
+        {
+            if (profiler != nullptr)
+                profiler->beginBlock(numSamples);
+        }
+
+        ~ScopedBlock()
+        {
+            if (profiler != nullptr)
+                profiler->endBlock();
+        }
+
+    private:
+        JuicyStageProfiler* profiler;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    class ScopedStage
+    {
+    public:
+        ScopedStage(JuicyStageProfiler* profilerToUse, JuicyProfileStage stage) noexcept
+            : profiler(profilerToUse != nullptr && profilerToUse->isRecordingOnThisThread() ? profilerToUse : nullptr)
+        {
+            if (profiler != nullptr)
+                previous = profiler->enterStage(stage);
+        }
+
+        ~ScopedStage()
+        {
+            if (profiler != nullptr)
+                profiler->leaveStage(previous);
+        }
+
+    private:
+        JuicyStageProfiler* profiler;
+        JuicyProfileStage previous = JuicyProfileStage::dsp;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    // Calibrates the cycle counter against the high-resolution clock, so call it off the
+    // audio thread (prepareToPlay).
+    void prepare(double sampleRate);
+
+    // Message thread: the stage's load over every block since the last reset.
+    JuicyStageLoad getLoad(JuicyProfileStage stage) const noexcept;
+    // Message thread: the audio thread clears the histograms at the start of its next block.
+    void requestReset() noexcept { resetRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    static constexpr int numBuckets = 64;
+    static constexpr int bucketsPerOctave = 4;
+    static constexpr int lowestOctave = -13; // bucket 0 ends at about 0.015 % of the deadline
+
+    struct Histogram
+    {
+        std::array<std::atomic<juce::uint32>, numBuckets> counts {};
+        std::atomic<juce::uint32> blocks { 0 };
+        std::atomic<double> shareSum { 0.0 };
+        std::atomic<float> maxShare { 0.0f };
+    };
+
+    bool isRecordingOnThisThread() const noexcept
+    {
+        return blockActive && juce::Thread::getCurrentThreadId() == blockThread;
+    }
+
+    JuicyProfileStage enterStage(JuicyProfileStage stage) noexcept
+    {
+        charge(juicyReadCycles());
+        if (JuicyTrace::isActive())
+            JuicyTrace::record(JuicyTrace::begin, static_cast<int>(stage), instanceId, blockSamples, lastCycles);
+        const auto outer = activeStage;
+        activeStage = stage;
+        return outer;
+    }
+
+    void leaveStage(JuicyProfileStage outer) noexcept
+    {
+        charge(juicyReadCycles());
+        if (JuicyTrace::isActive())
+            JuicyTrace::record(JuicyTrace::end, static_cast<int>(activeStage), instanceId, blockSamples, lastCycles);
+        activeStage = outer;
+    }
+
+    void charge(juce::uint64 now) noexcept
+    {
+        stageCycles[static_cast<size_t>(activeStage)] += now - lastCycles;
+        lastCycles = now;
+    }
+
+    void beginBlock(int numSamples) noexcept;
+    void endBlock() noexcept;
+    static float bucketUpperShare(int bucket) noexcept;
+
+    const juce::uint32 instanceId;
+    double sr = 44100.0;
+    double cyclesPerSecond = 1.0;
+    int blockSamples = 0;
+    double deadlineCycles = 1.0;
+    bool blockActive = false;
+    juce::Thread::ThreadID blockThread = nullptr;
+    JuicyProfileStage activeStage = JuicyProfileStage::dsp;
+    juce::uint64 lastCycles = 0;
+    std::array<juce::uint64, juicyNumProfileStages> stageCycles {};
+    std::array<Histogram, juicyNumProfileStages> histograms;
+    std::atomic<bool> resetRequested { false };
+};
+
+ #define JUICY_PROFILE_BLOCK(profiler, numSamples) \
+    const JuicyStageProfiler::ScopedBlock juicyProfiledBlock((profiler), (numSamples))
+ #define JUICY_PROFILE_STAGE(profiler, stage) \
+    const JuicyStageProfiler::ScopedStage JUCE_JOIN_MACRO(juicyProfiledStage, __LINE__)((profiler), (stage))
+#else
+class JuicyStageProfiler
+{
+public:
+    static constexpr bool isEnabled() noexcept { return false; }
+    void prepare(double) noexcept {}
+    JuicyStageLoad getLoad(JuicyProfileStage) const noexcept { return {}; }
+    void requestReset() noexcept {}
+};
+
+ #define JUICY_PROFILE_BLOCK(profiler, numSamples)
+ #define JUICY_PROFILE_STAGE(profiler, stage)
+#endif
+
+// Implemented by every processor, so tools that only hold a juce::AudioProcessor (the micro
+// benchmark) can read its stage loads.
+class JuicyProfiledProcessor
+{
+public:
+    virtual ~JuicyProfiledProcessor() = default;
+    virtual const JuicyStageProfiler& getStageProfiler() const noexcept = 0;
+};
+
+// Returns fn() with its cost charged to one stage, for results that have to outlive the timer.
+template <typename Fn>
+auto juicyProfiled(JuicyStageProfiler* profiler, JuicyProfileStage stage, Fn&& fn)
+{
+    juce::ignoreUnused(profiler, stage);
+    JUICY_PROFILE_STAGE(profiler, stage);
+    return fn();
+}
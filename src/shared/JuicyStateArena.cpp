@@ -0,0 +1,20 @@
+#include "JuicyStateArena.h"
+
+void JuicyStateArena::beginLayout()
+{
+    storage.free();
+    base = nullptr;
+    hotBytes = 0;
+    coldBytes = 0;
+}
+
+void JuicyStateArena::allocate()
+{
+    const auto total = getTotalBytes();
+    if (total == 0)
+        return;
+
+    storage.calloc(total + alignment);
+    const auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+    base = storage.get() + (alignUp(static_cast<size_t>(address)) - static_cast<size_t>(address));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <type_traits>
+
+// Per-instance block holding all DSP state in one 64-byte aligned allocation.
+// Slots are reserved in prepareToPlay(), then allocate() places every hot slot
+// (per-sample state) first and every cold slot (delay lines) after it, so the
+// audio thread only ever touches memory that was allocated up front.
+class JuicyStateArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    template <typename T>
+    struct Slot
+    {
+        size_t offset = 0;
+        size_t count = 0;
+        bool cold = false;
+    };
+
+    void beginLayout();
+    void allocate();
+
+    template <typename T>
+    Slot<T> reserveHot(size_t count) { return reserve<T>(count, false); }
+
+    template <typename T>
+    Slot<T> reserveCold(size_t count) { return reserve<T>(count, true); }
+
+    template <typename T>
+    T* get(const Slot<T>& slot) const noexcept
+    {
+        if (base == nullptr || slot.count == 0)
+            return nullptr;
+        return reinterpret_cast<T*>(base + (slot.cold ? hotBytes : 0) + slot.offset);
+    }
+
+    template <typename T>
+    void fill(const Slot<T>& slot, const T& value) noexcept
+    {
+        if (auto* data = get(slot))
+            std::fill(data, data + slot.count, value);
+    }
+
+    size_t getHotBytes() const noexcept { return hotBytes; }
+    size_t getTotalBytes() const noexcept { return hotBytes + coldBytes; }
+
+private:
+    template <typename T>
+    Slot<T> reserve(size_t count, bool cold)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena slots are never destroyed");
+        static_assert(alignof(T) <= alignment, "arena slots are only 64-byte aligned");
+
+        auto& bytes = cold ? coldBytes : hotBytes;
+        Slot<T> slot;
+        slot.offset = bytes;
+        slot.count = count;
+        slot.cold = cold;
+        bytes += alignUp(count * sizeof(T));
+        return slot;
+    }
+
+    static size_t alignUp(size_t bytes) noexcept { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+    juce::HeapBlock<char> storage;
+    char* base = nullptr;
+    size_t hotBytes = 0;
+    size_t coldBytes = 0;
+};
@@ -0,0 +1,106 @@
+#include "JuicyStateFormat.h"
+
+namespace
+{
+constexpr juce::uint32 stateMagic = 0x4349554a; // "JUIC" as it appears in the file
+constexpr size_t headerBytes = 8;
+constexpr size_t trailerBytes = 4;
+
+juce::uint32 crc32(const void* data, size_t numBytes) noexcept
+{
+    static const auto table = []
+    {
+        std::array<juce::uint32, 256> t {};
+        for (juce::uint32 i = 0; i < 256; ++i)
+        {
+            juce::uint32 c = i;
+            for (int bit = 0; bit < 8; ++bit)
+                c = (c & 1u) != 0 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    juce::uint32 crc = 0xffffffffu;
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    for (size_t i = 0; i < numBytes; ++i)
+        crc = table[(crc ^ bytes[i]) & 0xffu] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+}
+
+void writeJuicyState(juce::MemoryBlock& destData, juce::AudioProcessorValueTreeState& parameters,
+                     const char* const* parameterIds, size_t numParameterIds,
+                     const juce::MemoryBlock& extraData)
+{
+    destData.reset();
+    {
+        juce::MemoryOutputStream out(destData, false);
+        out.writeInt(static_cast<int>(stateMagic));
+        out.writeShort(static_cast<short>(juicyStateVersion));
+        out.writeShort(static_cast<short>(numParameterIds));
+        for (size_t i = 0; i < numParameterIds; ++i)
+        {
+            auto* parameter = parameters.getParameter(parameterIds[i]);
+            jassert(parameter != nullptr); // every ID in a state table must exist
+            out.writeFloat(parameter != nullptr ? parameter->convertFrom0to1(parameter->getValue()) : 0.0f);
+        }
+        out.writeInt(static_cast<int>(extraData.getSize()));
+        out.write(extraData.getData(), extraData.getSize());
+    }
+    const auto checksum = juce::ByteOrder::swapIfBigEndian(crc32(destData.getData(), destData.getSize()));
+    destData.append(&checksum, sizeof(checksum));
+}
+
+bool readJuicyState(const void* data, int sizeInBytes, juce::AudioProcessorValueTreeState& parameters,
+                    const char* const* parameterIds, size_t numParameterIds,
+                    juce::MemoryBlock* extraData)
+{
+    if (data == nullptr || sizeInBytes < static_cast<int>(headerBytes + 4 + trailerBytes))
+        return false;
+
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    const auto size = static_cast<size_t>(sizeInBytes);
+    if (juce::ByteOrder::littleEndianInt(bytes) != stateMagic)
+        return false;
+    if (juce::ByteOrder::littleEndianInt(bytes + size - trailerBytes) != crc32(bytes, size - trailerBytes))
+    {
+        DBG("Juicy state: CRC mismatch, the saved state is damaged and was not loaded");
+        return false;
+    }
+
+    // Sections a newer version adds after the extra bytes are skipped; this build's own states
+    // must end right after them.
+    const auto version = juce::ByteOrder::littleEndianShort(bytes + 4);
+    const size_t numValues = juce::ByteOrder::littleEndianShort(bytes + 6);
+    const size_t extraOffset = headerBytes + 4 * numValues;
+    const size_t extraSize = extraOffset + 4 + trailerBytes <= size ? juce::ByteOrder::littleEndianInt(bytes + extraOffset) : 0;
+    const size_t knownEnd = extraOffset + 4 + extraSize + trailerBytes;
+    if (knownEnd > size || (version <= juicyStateVersion && knownEnd != size))
+    {
+        DBG("Juicy state: version " << version << " state has inconsistent sizes and was not loaded");
+        return false;
+    }
+
+    // Values beyond this build's table came from a newer build and are skipped; parameters beyond
+    // the saved count keep their current values. They all land in one replaceState, as with the
+    // XML format, rather than one host notification per parameter.
+    auto state = parameters.copyState();
+    for (size_t i = 0; i < juce::jmin(numValues, numParameterIds); ++i)
+    {
+        auto* parameter = parameters.getParameter(parameterIds[i]);
+        auto child = state.getChildWithProperty("id", juce::String(parameterIds[i]));
+        if (parameter == nullptr || ! child.isValid())
+            continue;
+
+        const auto plain = juce::ByteOrder::littleEndianInt(bytes + headerBytes + 4 * i);
+        float value = 0.0f;
+        std::memcpy(&value, &plain, sizeof(value));
+        child.setProperty("value", parameter->convertFrom0to1(parameter->convertTo0to1(value)), nullptr);
+    }
+    parameters.replaceState(state);
+
+    if (extraData != nullptr)
+        extraData->replaceAll(bytes + extraOffset + 4, extraSize);
+    return true;
+}
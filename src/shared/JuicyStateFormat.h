@@ -0,0 +1,38 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+
+// Compact binary plugin state, little-endian:
+//   magic | version (u16) | value count (u16) | values (f32, plain units) | extra size (u32) |
+//   extra bytes | CRC-32 of everything before it (u32)
+// Values follow the processor's fixed parameter-ID table. Tables only ever grow at the end, so
+// a state saved by an older build loads with the newer parameters left where they are. The
+// extra bytes carry whatever the processor learns at run time that is not a parameter.
+// A later version may only add to this layout: more values, more extra bytes, or sections
+// between the extra bytes and the CRC. Older builds read what they know and skip the rest.
+constexpr juce::uint16 juicyStateVersion = 1;
+
+void writeJuicyState(juce::MemoryBlock& destData, juce::AudioProcessorValueTreeState& parameters,
+                     const char* const* parameterIds, size_t numParameterIds,
+                     const juce::MemoryBlock& extraData = {});
+
+// Returns false without touching anything when the data is not a binary state (no magic, so
+// the caller can fall back to the XML format older sessions were saved in) or is damaged.
+bool readJuicyState(const void* data, int sizeInBytes, juce::AudioProcessorValueTreeState& parameters,
+                    const char* const* parameterIds, size_t numParameterIds,
+                    juce::MemoryBlock* extraData = nullptr);
+
+template <size_t numIds>
+void writeJuicyState(juce::MemoryBlock& destData, juce::AudioProcessorValueTreeState& parameters,
+                     const std::array<const char*, numIds>& parameterIds, const juce::MemoryBlock& extraData = {})
+{
+    writeJuicyState(destData, parameters, parameterIds.data(), numIds, extraData);
+}
+
+template <size_t numIds>
+bool readJuicyState(const void* data, int sizeInBytes, juce::AudioProcessorValueTreeState& parameters,
+                    const std::array<const char*, numIds>& parameterIds, juce::MemoryBlock* extraData = nullptr)
+{
+    return readJuicyState(data, sizeInBytes, parameters, parameterIds.data(), numIds, extraData);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Internal slice length for processBlock. Every stage (pre-analysis, DSP, post-analysis)
+// runs over one slice before the next slice starts, so each stage reads samples the
+// previous stage has just left in L1 instead of re-streaming the whole host buffer.
+constexpr int juicySubBlockSize = 64;
+
+template <typename Fn>
+void forEachJuicySubBlock(int numSamples, Fn&& fn)
+{
+    for (int start = 0; start < numSamples; start += juicySubBlockSize)
+        fn(start, juce::jmin(juicySubBlockSize, numSamples - start));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstdint>
+
+// Position of each block's first sample on the processor's timeline. Kernels key their noise,
+// free-running modulators and analysis frames to it, so what they render at a sample depends
+// on where that sample is and not on how the host cut the stream into blocks. While the host
+// transport plays the position follows it; otherwise it counts the samples processed since
+// prepare.
+class JuicyTimeline
+{
+public:
+    void reset() noexcept { nextPosition = 0; }
+
+    // Audio thread, once per processBlock.
+    juce::int64 beginBlock(juce::AudioPlayHead* playHead, int numSamples) noexcept
+    {
+        if (playHead != nullptr)
+            if (const auto info = playHead->getPosition())
+                if (info->getIsPlaying())
+                    if (const auto time = info->getTimeInSamples())
+                        nextPosition = *time;
+
+        const auto position = nextPosition;
+        nextPosition += numSamples;
+        return position;
+    }
+
+private:
+    juce::int64 nextPosition = 0;
+};
+
+// Counter-based noise: a well-mixed 32-bit value for (seed, index), so a draw can be made for
+// any timeline position without replaying the draws before it.
+inline uint32_t juicyNoiseHash(uint32_t seed, uint64_t index) noexcept
+{
+    uint64_t h = index * 0x9e3779b97f4a7c15ull + seed;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<uint32_t>(h ^ (h >> 31));
+}
@@ -0,0 +1,219 @@
+#include "JuicyTrace.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+std::atomic<bool> JuicyTrace::active { false };
+
+namespace
+{
+// Enough for every audio thread of a large session; threads beyond it lose their events.
+constexpr juce::uint32 numRings = 32;
+// Events per ring, a power of two. The writer drains every 20 ms, so this covers hundreds of
+// small blocks' worth of events per thread between drains.
+constexpr juce::uint32 ringCapacity = 1u << 14;
+constexpr const char* eventNames[] = { "Pre analysis", "DSP", "Post analysis", "Host notification", "Block" };
+
+struct TraceEvent
+{
+    juce::uint64 cycles;
+    juce::uint32 instance;
+    juce::int32 blockSize;
+    juce::uint8 phase;
+    juce::uint8 name;
+};
+
+// One producer, the thread that claimed it, and one consumer, the writer thread.
+struct Ring
+{
+    std::array<TraceEvent, ringCapacity> events;
+    std::atomic<juce::uint32> writeCount { 0 };
+    std::atomic<juce::uint32> readCount { 0 };
+    std::atomic<juce::uint32> dropped { 0 };
+};
+
+class Session : private juce::Thread
+{
+public:
+    explicit Session(std::unique_ptr<juce::FileOutputStream> streamToUse)
+        : juce::Thread("Juicy trace writer"),
+          stream(std::move(streamToUse)),
+          rings(std::make_unique<std::array<Ring, numRings>>())
+    {
+        cyclesPerSecond = juicyCyclesPerSecond();
+        startCycles = juicyReadCycles();
+        stream->writeText("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", false, false, nullptr);
+        startThread();
+    }
+
+    ~Session() override { finish(); }
+
+    Ring* claimRing() noexcept
+    {
+        const auto index = nextRing.fetch_add(1, std::memory_order_relaxed);
+        return index < numRings ? &(*rings)[index] : nullptr;
+    }
+
+    void countUnclaimedDrop() noexcept { unclaimedDrops.fetch_add(1, std::memory_order_relaxed); }
+
+    void finish()
+    {
+        if (finished)
+            return;
+        finished = true;
+        stopThread(2000);
+        drain();
+
+        juce::uint64 dropped = unclaimedDrops.load(std::memory_order_relaxed);
+        writeEvent("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Juicy plugins\"}}");
+        for (juce::uint32 index = 0; index < claimedRings(); ++index)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Audio thread %u\"}}",
+                          index + 1, index + 1);
+            writeEvent(line);
+            dropped += (*rings)[index].dropped.load(std::memory_order_relaxed);
+        }
+        if (dropped > 0)
+        {
+            char line[160];
+            std::snprintf(line, sizeof(line), "{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"g\",\"ts\":0,\"pid\":1,\"args\":{\"count\":%llu}}",
+                          static_cast<unsigned long long>(dropped));
+            writeEvent(line);
+        }
+        stream->writeText("\n]}\n", false, false, nullptr);
+        stream->flush();
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            drain();
+            wait(20);
+        }
+    }
+
+    juce::uint32 claimedRings() const noexcept { return juce::jmin(numRings, nextRing.load(std::memory_order_relaxed)); }
+
+    void drain()
+    {
+        for (juce::uint32 index = 0; index < claimedRings(); ++index)
+        {
+            auto& ring = (*rings)[index];
+            const auto written = ring.writeCount.load(std::memory_order_acquire);
+            auto read = ring.readCount.load(std::memory_order_relaxed);
+            for (; read != written; ++read)
+                writeTraceEvent(ring.events[read & (ringCapacity - 1)], index + 1);
+            ring.readCount.store(read, std::memory_order_release);
+        }
+    }
+
+    void writeTraceEvent(const TraceEvent& event, juce::uint32 threadIndex)
+    {
+        const auto elapsed = static_cast<double>(static_cast<juce::int64>(event.cycles - startCycles));
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "{\"name\":\"%s\",\"cat\":\"juicy\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,"
+                      "\"args\":{\"instance\":%u,\"blockSize\":%d}}",
+                      eventNames[juce::jlimit(0, JuicyTrace::blockName, static_cast<int>(event.name))],
+                      event.phase == JuicyTrace::begin ? "B" : "E", 1.0e6 * elapsed / cyclesPerSecond, threadIndex,
+                      event.instance, event.blockSize);
+        writeEvent(line);
+    }
+
+    void writeEvent(const char* json)
+    {
+        if (! firstEvent)
+            stream->write(",\n", 2);
+        firstEvent = false;
+        stream->write(json, std::strlen(json));
+    }
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::unique_ptr<std::array<Ring, numRings>> rings;
+    std::atomic<juce::uint32> nextRing { 0 };
+    std::atomic<juce::uint32> unclaimedDrops { 0 };
+    double cyclesPerSecond = 1.0;
+    juce::uint64 startCycles = 0;
+    bool firstEvent = true;
+    bool finished = false;
+};
+
+std::atomic<bool> sessionStarted { false };
+std::atomic<Session*> currentSession { nullptr };
+
+// Kept until exit rather than deleted in stop(): an audio thread that saw isActive() just
+// before stop() may still be writing into its ring.
+std::unique_ptr<Session>& sessionHolder()
+{
+    static std::unique_ptr<Session> holder;
+    return holder;
+}
+}
+
+bool JuicyTrace::start(const juce::File& outputFile)
+{
+    if (sessionStarted.exchange(true))
+        return false;
+
+    outputFile.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(outputFile);
+    if (! stream->openedOk())
+        return false;
+
+    sessionHolder() = std::make_unique<Session>(std::move(stream));
+    currentSession.store(sessionHolder().get(), std::memory_order_release);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+void JuicyTrace::startFromEnvironment()
+{
+    if (sessionStarted.load())
+        return;
+
+    const auto path = juce::SystemStats::getEnvironmentVariable("JUICY_TRACE", {});
+    if (path.isNotEmpty())
+        start(juce::File::getCurrentWorkingDirectory().getChildFile(path));
+}
+
+void JuicyTrace::stop()
+{
+    active.store(false, std::memory_order_relaxed);
+    if (auto* session = currentSession.load(std::memory_order_acquire))
+        session->finish();
+}
+
+void JuicyTrace::record(Phase phase, int name, juce::uint32 instance, int blockSize, juce::uint64 cycles) noexcept
+{
+    auto* session = currentSession.load(std::memory_order_acquire);
+    if (session == nullptr)
+        return;
+
+    thread_local Ring* ring = nullptr;
+    thread_local bool claimed = false;
+    if (! claimed)
+    {
+        ring = session->claimRing();
+        claimed = true;
+    }
+    if (ring == nullptr)
+    {
+        session->countUnclaimedDrop();
+        return;
+    }
+
+    const auto written = ring->writeCount.load(std::memory_order_relaxed);
+    if (written - ring->readCount.load(std::memory_order_acquire) >= ringCapacity)
+    {
+        ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->events[written & (ringCapacity - 1)] = { cycles, instance, static_cast<juce::int32>(blockSize),
+                                                   static_cast<juce::uint8>(phase), static_cast<juce::uint8>(name) };
+    ring->writeCount.store(written + 1, std::memory_order_release);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include "JuicyCycleCounter.h"
+
+// Process-wide timeline of audio-thread events for debugging dropouts across instances.
+// Producers (JuicyStageProfiler's block and stage scopes) write begin/end events into a ring
+// owned by their thread; a background thread drains the rings into a Chrome trace JSON file,
+// which chrome://tracing and ui.perfetto.dev both open. Recording an event is a counter read
+// and a few stores, with no locks or allocation. One session per process: it runs from start()
+// until stop() or exit, and a later start() is refused.
+class JuicyTrace
+{
+public:
+    enum Phase : juce::uint8
+    {
+        begin,
+        end
+    };
+
+    // Event names 0 to 3 are the JuicyProfileStage values, in order.
+    static constexpr int blockName = 4;
+
+    static bool start(const juce::File& outputFile);
+    // Starts a session writing to the file named by the JUICY_TRACE environment variable, if
+    // it is set and no session has run yet.
+    static void startFromEnvironment();
+    // Drains what is left, closes the JSON and stops the writer thread.
+    static void stop();
+
+    static bool isActive() noexcept { return active.load(std::memory_order_relaxed); }
+
+    // Audio thread. Events are dropped, and counted, when the thread's ring is full or every
+    // ring has been claimed by other threads.
+    static void record(Phase phase, int name, juce::uint32 instance, int blockSize, juce::uint64 cycles) noexcept;
+
+private:
+    static std::atomic<bool> active;
+};
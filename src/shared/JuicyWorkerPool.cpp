@@ -0,0 +1,284 @@
+#include "JuicyWorkerPool.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <chrono>
+#include <climits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #include <immintrin.h>
+#endif
+
+#if defined(_WIN32)
+ #include <windows.h>
+ #pragma comment(lib, "Synchronization.lib")
+#else
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#if defined(__linux__)
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif defined(__APPLE__)
+ #include <dispatch/dispatch.h>
+#elif ! defined(_WIN32)
+ #include <semaphore.h>
+#endif
+
+namespace
+{
+inline void spinPause() noexcept
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Workers finish tasks the audio thread is spinning on, so they must not queue behind the
+// host's GUI and disk threads. Failing is fine: runErased bounds the wait either way.
+void raiseToRealtimePriority() noexcept
+{
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+    sched_param param {};
+    param.sched_priority = juce::jmax(sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO) - 10);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+#endif
+}
+
+std::atomic<JuicyWorkerPool::TaskObserver> taskObserver { nullptr };
+}
+
+void JuicyWorkerPool::setTaskObserver(TaskObserver observer) noexcept
+{
+    taskObserver.store(observer);
+}
+
+JuicyWorkerPool::JuicyWorkerPool()
+{
+#if defined(__APPLE__)
+    semaphore = dispatch_semaphore_create(0);
+#elif ! defined(__linux__) && ! defined(_WIN32)
+    auto* posixSemaphore = new sem_t;
+    sem_init(posixSemaphore, 0, 0);
+    semaphore = posixSemaphore;
+#endif
+}
+
+JuicyWorkerPool::~JuicyWorkerPool()
+{
+    shouldExit.store(true);
+    wakeParked(static_cast<int>(workers.size()));
+    for (auto& worker : workers)
+        worker.join();
+
+#if defined(__APPLE__)
+    dispatch_release(static_cast<dispatch_semaphore_t>(semaphore));
+#elif ! defined(__linux__) && ! defined(_WIN32)
+    sem_destroy(static_cast<sem_t*>(semaphore));
+    delete static_cast<sem_t*>(semaphore);
+#endif
+}
+
+void JuicyWorkerPool::start()
+{
+    const std::lock_guard<std::mutex> lock(startMutex);
+    if (! workers.empty())
+        return;
+
+    const int count = juce::jmin(maxWorkers, juce::SystemStats::getNumCpus() - 1);
+    for (int i = 0; i < count; ++i)
+        workers.emplace_back([this] { workerLoop(); });
+    numWorkers.store(count, std::memory_order_release);
+}
+
+// A task belongs to whoever flips it from pending to started, so a worker that took an index
+// from the counter but was preempted before starting it can still lose it to the caller.
+bool JuicyWorkerPool::Job::runTask(int index) noexcept
+{
+    auto expected = static_cast<juce::uint8>(pending);
+    if (! taskStates[static_cast<size_t>(index)].compare_exchange_strong(expected, static_cast<juce::uint8>(started),
+                                                                          std::memory_order_acq_rel))
+        return false;
+
+    function(context, index);
+    finishedTasks.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool JuicyWorkerPool::Job::work() noexcept
+{
+    bool didWork = false;
+    for (int index = nextTask.fetch_add(1, std::memory_order_relaxed); index < numTasks;
+         index = nextTask.fetch_add(1, std::memory_order_relaxed))
+        didWork = runTask(index) || didWork;
+    return didWork;
+}
+
+void JuicyWorkerPool::Job::takeOver() noexcept
+{
+    for (int index = 0; index < numTasks; ++index)
+        runTask(index);
+}
+
+JuicyWorkerPool::Job* JuicyWorkerPool::claimJob() noexcept
+{
+    for (auto& job : jobs)
+    {
+        int expected = Job::free;
+        if (job.state.compare_exchange_strong(expected, Job::claimed, std::memory_order_acquire))
+            return &job;
+    }
+    return nullptr;
+}
+
+bool JuicyWorkerPool::hasPublishedJob() const noexcept
+{
+    for (const auto& job : jobs)
+        if (job.state.load() == Job::published)
+            return true;
+    return false;
+}
+
+void JuicyWorkerPool::runErased(int numTasks, void* context, TaskFunction function) noexcept
+{
+    bool serial = numTasks <= 1 || numTasks > maxTasksPerJob || getNumWorkers() == 0;
+    if (! serial && serialJobsLeft.load(std::memory_order_relaxed) > 0)
+    {
+        serialJobsLeft.fetch_sub(1, std::memory_order_relaxed);
+        serial = true;
+    }
+
+    Job* job = serial ? nullptr : claimJob();
+    if (job == nullptr)
+    {
+        for (int index = 0; index < numTasks; ++index)
+            function(context, index);
+        return;
+    }
+
+    job->function = function;
+    job->context = context;
+    job->numTasks = numTasks;
+    for (int index = 0; index < numTasks; ++index)
+        job->taskStates[static_cast<size_t>(index)].store(Job::pending, std::memory_order_relaxed);
+    job->nextTask.store(0, std::memory_order_relaxed);
+    job->finishedTasks.store(0, std::memory_order_relaxed);
+    job->state.store(Job::published);
+
+    // Pairs with park(): a worker counts itself parked before it looks for jobs, and both sides
+    // are sequentially consistent, so either it sees this job or this sees it parked.
+    if (const int parked = numParked.load(); parked > 0)
+        wakeParked(parked);
+
+    job->work();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(maxWaitMicroseconds);
+    bool tookOver = false;
+    for (int spins = 1; job->finishedTasks.load(std::memory_order_acquire) < numTasks; ++spins)
+    {
+        spinPause();
+        if (! tookOver && spins % 64 == 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            tookOver = true;
+            job->takeOver();
+            serialJobsLeft.store(serialFallbackJobs, std::memory_order_relaxed);
+        }
+    }
+
+    // A worker registers in activeWorkers before it re-checks the state, so once the job is
+    // closed and the count reads zero nobody can still be touching it.
+    job->state.store(Job::closing);
+    while (job->activeWorkers.load() != 0)
+        spinPause();
+    job->state.store(Job::free, std::memory_order_release);
+}
+
+void JuicyWorkerPool::park() noexcept
+{
+    const auto epoch = wakeEpoch.load();
+    numParked.fetch_add(1);
+    if (! shouldExit.load() && ! hasPublishedJob())
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<juce::uint32*>(&wakeEpoch), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+        auto expected = epoch;
+        WaitOnAddress(&wakeEpoch, &expected, sizeof(expected), INFINITE);
+#elif defined(__APPLE__)
+        juce::ignoreUnused(epoch);
+        dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(semaphore), DISPATCH_TIME_FOREVER);
+#else
+        juce::ignoreUnused(epoch);
+        sem_wait(static_cast<sem_t*>(semaphore));
+#endif
+    }
+    numParked.fetch_sub(1);
+}
+
+// The futex and WaitOnAddress waits return at once if the epoch moved after the worker read
+// it, and a semaphore keeps its count, so no wake-up is lost; a surplus one only makes a worker
+// spin through one more idle round.
+void JuicyWorkerPool::wakeParked(int count) noexcept
+{
+    wakeEpoch.fetch_add(1);
+#if defined(__linux__)
+    juce::ignoreUnused(count);
+    syscall(SYS_futex, reinterpret_cast<juce::uint32*>(&wakeEpoch), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    juce::ignoreUnused(count);
+    WakeByAddressAll(&wakeEpoch);
+#elif defined(__APPLE__)
+    for (int i = 0; i < count; ++i)
+        dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(semaphore));
+#else
+    for (int i = 0; i < count; ++i)
+        sem_post(static_cast<sem_t*>(semaphore));
+#endif
+}
+
+void JuicyWorkerPool::workerLoop()
+{
+    juce::ScopedNoDenormals noDenormals;
+    raiseToRealtimePriority();
+    int idleSpins = 0;
+
+    while (! shouldExit.load(std::memory_order_acquire))
+    {
+        bool didWork = false;
+        for (auto& job : jobs)
+        {
+            if (job.state.load(std::memory_order_acquire) != Job::published)
+                continue;
+
+            job.activeWorkers.fetch_add(1);
+            if (job.state.load() == Job::published)
+            {
+                const auto observer = taskObserver.load(std::memory_order_relaxed);
+                if (observer != nullptr)
+                    observer(true);
+                didWork = job.work() || didWork;
+                if (observer != nullptr)
+                    observer(false);
+            }
+            job.activeWorkers.fetch_sub(1);
+        }
+
+        if (didWork)
+        {
+            idleSpins = 0;
+            continue;
+        }
+
+        if (++idleSpins < spinsBeforeParking)
+        {
+            spinPause();
+            continue;
+        }
+
+        idleSpins = 0;
+        park();
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Channel count from which a processor spreads its channel groups over the worker pool.
+// setParallelChannelThreshold(0) keeps a processor serial whatever its layout.
+constexpr int juicyDefaultParallelThreshold = 16;
+
+// Implemented by the processors that spread channels over the pool, so tools that only hold a
+// juce::AudioProcessor (the real-time checker) can force it on for any layout.
+class JuicyParallelProcessor
+{
+public:
+    virtual ~JuicyParallelProcessor() = default;
+    virtual void setParallelChannelThreshold(int numChannels) noexcept = 0;
+};
+
+// Small pool of pre-spawned workers shared by every plugin instance in the process; hold it
+// through juce::SharedResourcePointer. run() publishes a job, hands out task indices through
+// an atomic counter, works on them on the calling thread as well and spins until every task
+// has finished, so processBlock never takes a lock. Idle workers spin for a short while and
+// then park until the next job; a job that finds no free slot or no workers simply runs
+// serially. Waking a parked worker is one futex or semaphore call, made only when a worker
+// has actually parked, so dispatching to spinning workers makes no system call at all.
+//
+// Workers ask for realtime scheduling when they start. Where the system refuses, or a worker
+// is preempted anyway, the caller stops waiting after maxWaitMicroseconds and runs every task
+// no worker has started yet itself; only a task already running on a worker is waited for.
+// Such a job also switches the pool to serial for the next serialFallbackJobs jobs, so a
+// starved pool costs one late block instead of one per block.
+class JuicyWorkerPool
+{
+public:
+    JuicyWorkerPool();
+    ~JuicyWorkerPool();
+
+    // Spawns the workers on first use. Call from prepareToPlay, never from the audio thread.
+    void start();
+    int getNumWorkers() const noexcept { return numWorkers.load(std::memory_order_acquire); }
+
+    // Called on a worker thread with true before it works on a job and false after, for
+    // diagnostics that track what runs on behalf of the audio thread. Never set in the plugins.
+    using TaskObserver = void (*)(bool entering) noexcept;
+    static void setTaskObserver(TaskObserver observer) noexcept;
+
+    // Calls task(index) for every index in [0, numTasks) and returns once all calls are done.
+    // Tasks run concurrently, so each must only write state that no other task touches.
+    template <typename Fn>
+    void run(int numTasks, Fn&& task) noexcept
+    {
+        using Task = std::remove_reference_t<Fn>;
+        runErased(numTasks, const_cast<void*>(static_cast<const void*>(std::addressof(task))),
+                  [](void* context, int index) { (*static_cast<Task*>(context))(index); });
+    }
+
+private:
+    using TaskFunction = void (*)(void*, int);
+    static constexpr int maxTasksPerJob = 64;
+
+    struct alignas(64) Job
+    {
+        enum State { free, claimed, published, closing };
+        enum TaskState : juce::uint8 { pending, started };
+
+        bool runTask(int index) noexcept;
+        bool work() noexcept;
+        void takeOver() noexcept;
+
+        std::atomic<int> state { free };
+        std::atomic<int> nextTask { 0 };
+        std::atomic<int> finishedTasks { 0 };
+        std::atomic<int> activeWorkers { 0 };
+        std::array<std::atomic<juce::uint8>, maxTasksPerJob> taskStates {};
+        TaskFunction function = nullptr;
+        void* context = nullptr;
+        int numTasks = 0;
+    };
+
+    static constexpr int maxWorkers = 7;
+    static constexpr int maxJobs = 16;
+    static constexpr int spinsBeforeParking = 4000;
+    static constexpr int maxWaitMicroseconds = 200;
+    static constexpr int serialFallbackJobs = 512;
+
+    void runErased(int numTasks, void* context, TaskFunction function) noexcept;
+    Job* claimJob() noexcept;
+    bool hasPublishedJob() const noexcept;
+    void workerLoop();
+    void park() noexcept;
+    void wakeParked(int count) noexcept;
+
+    std::array<Job, maxJobs> jobs;
+    std::vector<std::thread> workers;
+    std::atomic<int> numWorkers { 0 };
+    std::atomic<int> numParked { 0 };
+    std::atomic<juce::uint32> wakeEpoch { 0 };
+    void* semaphore = nullptr; // where there is no futex-style wait on wakeEpoch
+    std::atomic<int> serialJobsLeft { 0 };
+    std::atomic<bool> shouldExit { false };
+    std::mutex startMutex;
+
+    JUCE_DECLARE_NON_COPYABLE(JuicyWorkerPool)
+};
@@ -0,0 +1,370 @@
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "shared/JuicinessAnalyzer.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct AnalyzeSettings
+{
+    int hopSize = 1024;
+    int numThreads = static_cast<int>(juce::jmax(1u, std::thread::hardware_concurrency()));
+    bool json = false;
+    juce::File hopDirectory; // per-hop files are skipped when this is unset
+};
+
+struct InputFile
+{
+    juce::File file;
+    juce::String name; // path relative to the argument it was found under
+    juce::int64 size = 0;
+};
+
+// What one file boils down to. Kept for every input so the summary can be written in input
+// order; a few hundred bytes per file, whatever the audio length.
+struct FileSummary
+{
+    juce::String error;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    juce::int64 numSamples = 0;
+    int numHops = 0;
+    std::array<double, numJuicinessMetricFields> mean {};
+    std::array<float, numJuicinessMetricFields> max {};
+};
+
+std::vector<InputFile> collectInputs(const juce::StringArray& paths, const juce::String& wildcard)
+{
+    std::vector<InputFile> inputs;
+    for (const auto& path : paths)
+    {
+        const auto root = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+        if (root.isDirectory())
+        {
+            for (const auto& entry : juce::RangedDirectoryIterator(root, true, wildcard, juce::File::findFiles))
+                inputs.push_back({ entry.getFile(), entry.getFile().getRelativePathFrom(root), entry.getFileSize() });
+        }
+        else
+        {
+            inputs.push_back({ root, path, root.getSize() });
+        }
+    }
+    return inputs;
+}
+
+// Memory-mapped where the format supports it (WAV, AIFF), so pages come straight from the file
+// cache; otherwise a buffered streaming reader.
+std::unique_ptr<juce::AudioFormatReader> openReader(juce::AudioFormatManager& formats, const juce::File& file)
+{
+    if (auto* format = formats.findFormatForFileExtension(file.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return mapped;
+    }
+    return std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(file));
+}
+
+class HopWriter
+{
+public:
+    HopWriter(const juce::File& file, bool writeJson)
+        : json(writeJson)
+    {
+        file.deleteFile();
+        stream = std::make_unique<juce::FileOutputStream>(file);
+        if (! stream->openedOk())
+        {
+            stream.reset();
+            return;
+        }
+
+        if (json)
+        {
+            *stream << "[\n";
+            return;
+        }
+        *stream << "time";
+        for (const auto& field : juicinessMetricFields)
+            *stream << "," << field.name;
+        *stream << "\n";
+    }
+
+    ~HopWriter()
+    {
+        if (stream != nullptr && json)
+            *stream << "\n]\n";
+    }
+
+    void write(double time, const JuicinessMetrics& metrics)
+    {
+        if (stream == nullptr)
+            return;
+
+        if (json)
+        {
+            *stream << (first ? "" : ",\n") << "{\"time\":" << juce::String(time, 6);
+            for (const auto& field : juicinessMetricFields)
+                *stream << ",\"" << field.name << "\":" << juce::String(field.read(metrics), 6);
+            *stream << "}";
+        }
+        else
+        {
+            *stream << juce::String(time, 6);
+            for (const auto& field : juicinessMetricFields)
+                *stream << "," << juce::String(field.read(metrics), 6);
+            *stream << "\n";
+        }
+        first = false;
+    }
+
+private:
+    std::unique_ptr<juce::FileOutputStream> stream;
+    bool json;
+    bool first = true;
+};
+
+// Decodes one hop at a time into a fixed buffer and runs it through a fresh analyzer, so a
+// file's cost in memory is one hop whatever its length.
+FileSummary analyzeFile(const InputFile& input, const AnalyzeSettings& settings, juce::AudioFormatManager& formats,
+                        juce::AudioBuffer<float>& hop)
+{
+    FileSummary summary;
+    const auto reader = openReader(formats, input.file);
+    if (reader == nullptr)
+    {
+        summary.error = "unreadable or unsupported format";
+        return summary;
+    }
+
+    summary.sampleRate = reader->sampleRate;
+    summary.numChannels = static_cast<int>(reader->numChannels);
+    summary.numSamples = reader->lengthInSamples;
+    if (summary.sampleRate <= 0.0 || summary.numChannels <= 0)
+    {
+        summary.error = "no audio";
+        return summary;
+    }
+
+    // The analyzer looks at the first two channels, like the plugins' meters.
+    const int channels = juce::jmin(2, summary.numChannels);
+    hop.setSize(channels, settings.hopSize, false, false, true);
+    JuicinessAnalyzer analyzer;
+    analyzer.prepare(summary.sampleRate, settings.hopSize, channels);
+
+    std::unique_ptr<HopWriter> hopWriter;
+    if (settings.hopDirectory != juce::File())
+    {
+        const auto name = juce::File::createLegalFileName(input.name.replaceCharacters("/\\", "__"));
+        hopWriter = std::make_unique<HopWriter>(settings.hopDirectory.getChildFile(name + (settings.json ? ".hops.json" : ".hops.csv")),
+                                                settings.json);
+    }
+
+    for (juce::int64 position = 0; position < summary.numSamples; position += settings.hopSize)
+    {
+        const auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(settings.hopSize), summary.numSamples - position));
+        if (! reader->read(&hop, 0, numSamples, position, true, channels > 1))
+        {
+            summary.error = "read failed at sample " + juce::String(position);
+            break;
+        }
+
+        analyzer.beginBlock();
+        analyzer.accumulate(hop, 0, numSamples);
+        const auto metrics = analyzer.finishBlock();
+        for (size_t i = 0; i < juicinessMetricFields.size(); ++i)
+        {
+            const float value = juicinessMetricFields[i].read(metrics);
+            summary.mean[i] += value;
+            summary.max[i] = summary.numHops == 0 ? value : juce::jmax(summary.max[i], value);
+        }
+        ++summary.numHops;
+
+        if (hopWriter != nullptr)
+            hopWriter->write(static_cast<double>(position) / summary.sampleRate, metrics);
+    }
+
+    for (auto& mean : summary.mean)
+        mean /= juce::jmax(1, summary.numHops);
+    return summary;
+}
+
+juce::String csvField(const juce::String& text)
+{
+    return text.containsAnyOf(",\"\n") ? "\"" + text.replace("\"", "\"\"") + "\"" : text;
+}
+
+void writeSummary(juce::OutputStream& out, const std::vector<InputFile>& inputs, const std::vector<FileSummary>& summaries, bool json)
+{
+    if (json)
+    {
+        out << "[\n";
+        for (size_t index = 0; index < inputs.size(); ++index)
+        {
+            const auto& summary = summaries[index];
+            out << (index == 0 ? "" : ",\n") << "{\"file\":" << juce::JSON::toString(inputs[index].file.getFullPathName());
+            if (summary.error.isNotEmpty())
+            {
+                out << ",\"error\":" << juce::JSON::toString(summary.error) << "}";
+                continue;
+            }
+            out << ",\"sampleRate\":" << juce::String(summary.sampleRate) << ",\"channels\":" << summary.numChannels
+                << ",\"seconds\":" << juce::String(static_cast<double>(summary.numSamples) / summary.sampleRate, 6)
+                << ",\"hops\":" << summary.numHops;
+            for (const auto* statistic : { "mean", "max" })
+            {
+                out << ",\"" << statistic << "\":{";
+                for (size_t i = 0; i < juicinessMetricFields.size(); ++i)
+                {
+                    const double value = juce::String(statistic) == "mean" ? summary.mean[i] : static_cast<double>(summary.max[i]);
+                    out << (i == 0 ? "" : ",") << "\"" << juicinessMetricFields[i].name << "\":" << juce::String(value, 6);
+                }
+                out << "}";
+            }
+            out << "}";
+        }
+        out << "\n]\n";
+        return;
+    }
+
+    out << "file,error,sampleRate,channels,seconds,hops";
+    for (const auto* statistic : { "mean", "max" })
+        for (const auto& field : juicinessMetricFields)
+            out << "," << field.name << "_" << statistic;
+    out << "\n";
+
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        const auto& summary = summaries[index];
+        out << csvField(inputs[index].file.getFullPathName()) << "," << csvField(summary.error);
+        if (summary.error.isNotEmpty())
+        {
+            out << "\n";
+            continue;
+        }
+        out << "," << juce::String(summary.sampleRate) << "," << summary.numChannels << ","
+            << juce::String(static_cast<double>(summary.numSamples) / summary.sampleRate, 6) << "," << summary.numHops;
+        for (const auto& mean : summary.mean)
+            out << "," << juce::String(mean, 6);
+        for (const auto& max : summary.max)
+            out << "," << juce::String(max, 6);
+        out << "\n";
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name) -> juce::String
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    // Anything that is neither an option nor an option's value is a file or directory.
+    juce::StringArray paths;
+    for (int i = 0; i < args.size(); ++i)
+    {
+        if (args[i].startsWith("--"))
+            ++i;
+        else
+            paths.add(args[i]);
+    }
+
+    if (paths.isEmpty())
+    {
+        std::fprintf(stderr, "usage: juicy-analyze <file|dir>... [--output summary.csv|.json] [--hops dir] [--hop samples] "
+                             "[--threads n] [--format csv|json]\n");
+        return 2;
+    }
+
+    const auto outputPath = option("--output");
+    AnalyzeSettings settings;
+    if (option("--hop").isNotEmpty())
+        settings.hopSize = juce::jlimit(16, 1 << 20, option("--hop").getIntValue());
+    if (option("--threads").isNotEmpty())
+        settings.numThreads = juce::jmax(1, option("--threads").getIntValue());
+    settings.json = option("--format").isNotEmpty() ? option("--format") == "json" : outputPath.endsWithIgnoreCase(".json");
+    if (option("--hops").isNotEmpty())
+    {
+        settings.hopDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(option("--hops"));
+        if (! settings.hopDirectory.createDirectory())
+        {
+            std::fprintf(stderr, "cannot create %s\n", settings.hopDirectory.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+
+    juce::AudioFormatManager probeFormats;
+    probeFormats.registerBasicFormats();
+    auto inputs = collectInputs(paths, probeFormats.getWildcardForAllFormats());
+
+    // Largest files first, so no worker is left with one long file after the rest are done.
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&inputs](size_t a, size_t b) { return inputs[a].size > inputs[b].size; });
+
+    // Workers take the next file from a shared counter as soon as they are free, so uneven file
+    // lengths balance themselves out. Each owns its format manager and hop buffer.
+    std::vector<FileSummary> summaries(inputs.size());
+    std::atomic<size_t> nextFile { 0 };
+    std::atomic<int> filesDone { 0 };
+    std::mutex progressMutex;
+    const auto worker = [&]
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        juce::AudioBuffer<float> hop;
+        for (size_t next = nextFile.fetch_add(1); next < order.size(); next = nextFile.fetch_add(1))
+        {
+            const auto index = order[next];
+            summaries[index] = analyzeFile(inputs[index], settings, formats, hop);
+
+            const int done = filesDone.fetch_add(1) + 1;
+            if (summaries[index].error.isNotEmpty() || done % 100 == 0 || done == static_cast<int>(inputs.size()))
+            {
+                const std::lock_guard<std::mutex> lock(progressMutex);
+                if (summaries[index].error.isNotEmpty())
+                    std::fprintf(stderr, "%s: %s\n", inputs[index].name.toRawUTF8(), summaries[index].error.toRawUTF8());
+                std::fprintf(stderr, "%d/%d files\n", done, static_cast<int>(inputs.size()));
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < juce::jmin(settings.numThreads, static_cast<int>(inputs.size())); ++thread)
+        workers.emplace_back(worker);
+    for (auto& thread : workers)
+        thread.join();
+
+    const int failures = static_cast<int>(std::count_if(summaries.begin(), summaries.end(), [](const FileSummary& s) { return s.error.isNotEmpty(); }));
+    if (outputPath.isNotEmpty())
+    {
+        const auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputPath);
+        outputFile.deleteFile();
+        juce::FileOutputStream out(outputFile);
+        if (! out.openedOk())
+        {
+            std::fprintf(stderr, "cannot write %s\n", outputFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+        writeSummary(out, inputs, summaries, settings.json);
+    }
+    else
+    {
+        juce::MemoryOutputStream out;
+        writeSummary(out, inputs, summaries, settings.json);
+        std::fwrite(out.getData(), 1, out.getDataSize(), stdout);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,429 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace
+{
+constexpr int goldenMagic = 0x444c474a; // "JGLD"
+constexpr int goldenVersion = 1;
+constexpr double goldenSampleRate = 48000.0;
+constexpr double fixtureSeconds = 2.0;
+constexpr int maxBlockSize = 4096;
+
+// Irregular host block sizes, so the sub-block, idle and channel-group paths all see partial blocks.
+constexpr int blockSizes[] = { 512, 37, 2048, 1, 300, 4096, 64, 129 };
+
+// The host-visible metrics every block publishes; plugins only have some of them.
+const char* const metricIds[] = { "juiciness", "emphasis", "coherence", "synesthesia", "fatigue", "repetition", "contextfit", "qualitytier" };
+
+// How far a render may drift from its golden file. Resonant and recursive plugins amplify
+// rounding differences, so those are judged on error energy instead of per-sample ULPs.
+struct Tolerance
+{
+    int maxUlp = 0;
+    double maxErrorDb = 0.0; // used instead of maxUlp when below zero
+    float metricTolerance = 0.05f;
+};
+
+Tolerance defaultTolerance()
+{
+    const juce::String name(JucePlugin_Name);
+    Tolerance tolerance;
+    if (name == "Juicy Infer")
+        tolerance.maxUlp = 4;
+    else if (name == "Juicy Width")
+        tolerance.maxUlp = 16;
+    else if (name == "Juicy Punch" || name == "Juicy Saturator")
+        tolerance.maxUlp = 64;
+    else if (name == "Juicy Cohere" || name == "Juicy Motion")
+        tolerance.maxUlp = 256;
+    else
+        tolerance.maxErrorDb = -90.0;
+    return tolerance;
+}
+
+struct Preset
+{
+    juce::String name;
+    int program = -1;
+    juce::String choiceId;
+    int choiceIndex = 0;
+};
+
+std::vector<Preset> listPresets(juce::AudioProcessor& processor)
+{
+    std::vector<Preset> presets;
+    presets.push_back({ "default" });
+
+    if (processor.getNumPrograms() > 1)
+        for (int program = 0; program < processor.getNumPrograms(); ++program)
+            presets.push_back({ "program-" + processor.getProgramName(program), program });
+
+    for (auto* parameter : processor.getParameters())
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter))
+            for (int index = 0; index < choice->choices.size(); ++index)
+                presets.push_back({ choice->paramID + "-" + choice->choices[index], -1, choice->paramID, index });
+    return presets;
+}
+
+void applyPreset(juce::AudioProcessor& processor, const Preset& preset)
+{
+    if (preset.program >= 0)
+        processor.setCurrentProgram(preset.program);
+
+    if (preset.choiceId.isNotEmpty())
+        for (auto* parameter : processor.getParameters())
+            if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter); choice != nullptr && choice->paramID == preset.choiceId)
+                choice->setValueNotifyingHost(choice->convertTo0to1(static_cast<float>(preset.choiceIndex)));
+}
+
+// Fixed input fixtures, generated from fixed seeds so they are identical on every machine.
+// The last quarter is silent so the idle paths and tails are covered as well.
+void fillFixture(juce::AudioBuffer<float>& buffer, const juce::String& fixture)
+{
+    juce::Random random(0x474f4c44);
+    const auto sr = static_cast<float>(goldenSampleRate);
+    const int silentFrom = buffer.getNumSamples() * 3 / 4;
+
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        const float t = static_cast<float>(i) / sr;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            float x = 0.0f;
+            if (fixture == "drums")
+            {
+                const float beat = std::fmod(t, 0.5f);
+                const float offBeat = std::fmod(t + 0.25f, 0.5f);
+                x = 0.8f * std::sin(juce::MathConstants<float>::twoPi * (50.0f + 120.0f * std::exp(-beat * 40.0f)) * beat) * std::exp(-beat * 12.0f)
+                  + 0.35f * (2.0f * random.nextFloat() - 1.0f) * std::exp(-offBeat * 90.0f);
+            }
+            else if (fixture == "pads")
+            {
+                const float detune = 1.0f + 0.002f * static_cast<float>(ch);
+                for (const float hz : { 220.0f, 277.18f, 329.63f })
+                    x += 0.18f * std::sin(juce::MathConstants<float>::twoPi * hz * detune * t);
+            }
+            else
+            {
+                x = 0.5f * (2.0f * random.nextFloat() - 1.0f);
+            }
+            buffer.setSample(ch, i, i < silentFrom ? x : 0.0f);
+        }
+    }
+}
+
+struct Render
+{
+    juce::AudioBuffer<float> audio;
+    juce::StringArray metricNames;
+    std::vector<float> metrics; // one row of metricNames.size() values per block
+    int numBlocks = 0;
+};
+
+// Renders run non-realtime, where the quality governor always stays at the full tier, so the
+// output does not depend on how loaded the machine is.
+Render render(const juce::AudioBuffer<float>& input, const Preset& preset)
+{
+    const int numChannels = input.getNumChannels();
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    processor->setPlayConfigDetails(numChannels, numChannels, goldenSampleRate, maxBlockSize);
+    processor->setNonRealtime(true);
+    applyPreset(*processor, preset);
+    processor->prepareToPlay(goldenSampleRate, maxBlockSize);
+
+    Render result;
+    std::vector<juce::RangedAudioParameter*> metricParameters;
+    for (const auto* id : metricIds)
+        for (auto* parameter : processor->getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == id)
+            {
+                metricParameters.push_back(ranged);
+                result.metricNames.add(id);
+            }
+
+    result.audio.makeCopyOf(input);
+    juce::AudioBuffer<float> block(numChannels, maxBlockSize);
+    juce::MidiBuffer midi;
+    for (int start = 0, k = 0; start < input.getNumSamples(); ++k)
+    {
+        const int num = juce::jmin(blockSizes[k % static_cast<int>(std::size(blockSizes))], input.getNumSamples() - start);
+        block.setSize(numChannels, num, false, false, true);
+        for (int ch = 0; ch < numChannels; ++ch)
+            block.copyFrom(ch, 0, result.audio, ch, start, num);
+        processor->processBlock(block, midi);
+        for (int ch = 0; ch < numChannels; ++ch)
+            result.audio.copyFrom(ch, start, block, ch, 0, num);
+
+        for (auto* parameter : metricParameters)
+            result.metrics.push_back(parameter->convertFrom0to1(parameter->getValue()));
+        ++result.numBlocks;
+        start += num;
+    }
+    return result;
+}
+
+bool writeGolden(const juce::File& file, const Render& render)
+{
+    juce::MemoryOutputStream out;
+    out.writeInt(goldenMagic);
+    out.writeInt(goldenVersion);
+    out.writeInt(render.audio.getNumChannels());
+    out.writeInt(render.audio.getNumSamples());
+    out.writeInt(render.metricNames.size());
+    out.writeInt(render.numBlocks);
+    for (const auto& name : render.metricNames)
+        out.writeString(name);
+    for (int ch = 0; ch < render.audio.getNumChannels(); ++ch)
+        for (int i = 0; i < render.audio.getNumSamples(); ++i)
+            out.writeFloat(render.audio.getSample(ch, i));
+    for (const float value : render.metrics)
+        out.writeFloat(value);
+
+    file.getParentDirectory().createDirectory();
+    return file.replaceWithData(out.getData(), out.getDataSize());
+}
+
+bool readGolden(const juce::File& file, Render& render)
+{
+    juce::MemoryBlock data;
+    if (! file.loadFileAsData(data))
+        return false;
+
+    juce::MemoryInputStream in(data, false);
+    if (in.readInt() != goldenMagic || in.readInt() != goldenVersion)
+        return false;
+    const int numChannels = in.readInt();
+    const int numSamples = in.readInt();
+    const int numMetrics = in.readInt();
+    render.numBlocks = in.readInt();
+    if (numChannels <= 0 || numSamples < 0 || numMetrics < 0 || render.numBlocks < 0)
+        return false;
+
+    for (int m = 0; m < numMetrics; ++m)
+        render.metricNames.add(in.readString());
+    const auto payloadBytes = sizeof(float) * (static_cast<size_t>(numChannels) * static_cast<size_t>(numSamples)
+                                               + static_cast<size_t>(numMetrics) * static_cast<size_t>(render.numBlocks));
+    if (static_cast<size_t>(in.getNumBytesRemaining()) != payloadBytes)
+        return false;
+
+    render.audio.setSize(numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            render.audio.setSample(ch, i, in.readFloat());
+    render.metrics.resize(static_cast<size_t>(numMetrics * render.numBlocks));
+    for (auto& value : render.metrics)
+        value = in.readFloat();
+    return true;
+}
+
+// Distance in representable floats; values within -140 dBFS of each other count as equal so
+// that denormal-level noise around zero does not read as millions of ULPs.
+juce::int64 ulpDistance(float a, float b)
+{
+    if (std::abs(a - b) <= 1.0e-7f)
+        return 0;
+    const auto ordered = [](float x)
+    {
+        juce::int32 bits = 0;
+        std::memcpy(&bits, &x, sizeof bits);
+        return bits < 0 ? static_cast<juce::int64>(std::numeric_limits<juce::int32>::min()) - bits : static_cast<juce::int64>(bits);
+    };
+    return std::abs(ordered(a) - ordered(b));
+}
+
+// Returns an empty string when the render matches, otherwise where and how it first diverged.
+juce::String compare(const Render& expected, const Render& actual, const Tolerance& tolerance, bool compareMetrics)
+{
+    if (expected.audio.getNumChannels() != actual.audio.getNumChannels() || expected.audio.getNumSamples() != actual.audio.getNumSamples())
+        return "audio has a different shape";
+
+    double errorEnergy = 0.0, referenceEnergy = 0.0;
+    juce::int64 worstUlp = 0;
+    juce::String firstDivergence;
+    const double referenceRms = [&expected]
+    {
+        double sum = 0.0;
+        for (int ch = 0; ch < expected.audio.getNumChannels(); ++ch)
+            for (int i = 0; i < expected.audio.getNumSamples(); ++i)
+                sum += static_cast<double>(expected.audio.getSample(ch, i)) * expected.audio.getSample(ch, i);
+        return std::sqrt(sum / juce::jmax(1, expected.audio.getNumChannels() * expected.audio.getNumSamples()));
+    }();
+    const double sampleThreshold = tolerance.maxErrorDb < 0.0 ? referenceRms * std::pow(10.0, tolerance.maxErrorDb / 20.0) : 0.0;
+
+    for (int i = 0; i < expected.audio.getNumSamples(); ++i)
+    {
+        for (int ch = 0; ch < expected.audio.getNumChannels(); ++ch)
+        {
+            const float e = expected.audio.getSample(ch, i);
+            const float a = actual.audio.getSample(ch, i);
+            const auto ulps = ulpDistance(e, a);
+            worstUlp = juce::jmax(worstUlp, ulps);
+            const double d = static_cast<double>(a) - e;
+            errorEnergy += d * d;
+            referenceEnergy += static_cast<double>(e) * e;
+
+            const bool diverged = tolerance.maxErrorDb < 0.0 ? std::abs(d) > sampleThreshold : ulps > tolerance.maxUlp;
+            if (diverged && firstDivergence.isEmpty())
+                firstDivergence = "first divergent sample " + juce::String(i) + " ch " + juce::String(ch) + ": expected "
+                                + juce::String(e, 9) + ", got " + juce::String(a, 9) + " (" + juce::String(ulps) + " ulp)";
+        }
+    }
+
+    if (tolerance.maxErrorDb < 0.0)
+    {
+        const double errorDb = errorEnergy <= 0.0 ? -400.0 : 10.0 * std::log10(errorEnergy / juce::jmax(referenceEnergy, 1.0e-30));
+        if (errorDb > tolerance.maxErrorDb)
+            return "error " + juce::String(errorDb, 1) + " dB exceeds " + juce::String(tolerance.maxErrorDb, 1) + " dB; " + firstDivergence;
+    }
+    else if (worstUlp > tolerance.maxUlp)
+    {
+        return "worst " + juce::String(worstUlp) + " ulp exceeds " + juce::String(tolerance.maxUlp) + "; " + firstDivergence;
+    }
+
+    if (! compareMetrics)
+        return {};
+    if (expected.numBlocks != actual.numBlocks)
+        return "metrics cover a different number of blocks";
+
+    // Matched by name: the baseline processors publish fewer metrics than the current ones.
+    const int numExpected = expected.metricNames.size();
+    const int numActual = actual.metricNames.size();
+    for (int m = 0; m < numExpected; ++m)
+    {
+        const int a = actual.metricNames.indexOf(expected.metricNames[m]);
+        if (a < 0)
+            return "metric " + expected.metricNames[m] + " is no longer published";
+
+        for (int b = 0; b < expected.numBlocks; ++b)
+        {
+            const float e = expected.metrics[static_cast<size_t>(b * numExpected + m)];
+            const float value = actual.metrics[static_cast<size_t>(b * numActual + a)];
+            if (std::abs(e - value) > tolerance.metricTolerance)
+                return "metric " + expected.metricNames[m] + " diverges at block " + juce::String(b) + ": expected "
+                     + juce::String(e, 4) + ", got " + juce::String(value, 4);
+        }
+    }
+    return {};
+}
+
+// Offline renders must never leave the full tier; one that does is a governor bug, not noise.
+bool stayedAtFullQuality(const Render& render)
+{
+    const int tierIndex = render.metricNames.indexOf("qualitytier");
+    if (tierIndex < 0)
+        return true;
+    for (int b = 0; b < render.numBlocks; ++b)
+        if (render.metrics[static_cast<size_t>(b * render.metricNames.size() + tierIndex)] > 0.5f)
+            return false;
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name) -> juce::String
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    const bool recording = option("--record").isNotEmpty();
+    const auto root = juce::File::getCurrentWorkingDirectory().getChildFile(recording ? option("--record") : option("--check"));
+    if (! recording && option("--check").isEmpty())
+    {
+        std::printf("usage: --record <dir> | --check <dir> [--ulp n] [--db x] [--channels n] [--preset text]\n");
+        return 2;
+    }
+
+    auto tolerance = defaultTolerance();
+    if (option("--ulp").isNotEmpty())
+    {
+        tolerance.maxUlp = option("--ulp").getIntValue();
+        tolerance.maxErrorDb = 0.0;
+    }
+    if (option("--db").isNotEmpty())
+        tolerance.maxErrorDb = option("--db").getDoubleValue();
+    const int numChannels = option("--channels").isNotEmpty() ? juce::jmax(1, option("--channels").getIntValue()) : 2;
+    const auto presetFilter = option("--preset");
+
+    std::vector<Preset> presets;
+    {
+        std::unique_ptr<juce::AudioProcessor> probe(createPluginFilter());
+        for (auto& preset : listPresets(*probe))
+            if (presetFilter.isEmpty() || preset.name.containsIgnoreCase(presetFilter))
+                presets.push_back(preset);
+    }
+
+    const auto pluginDirectory = root.getChildFile(juce::String(JucePlugin_Name).removeCharacters(" "));
+    if (! recording && ! pluginDirectory.isDirectory())
+    {
+        std::printf("FAIL %s: no golden files in %s; record them as described in the README\n", JucePlugin_Name,
+                    pluginDirectory.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    int failures = 0, passed = 0;
+    for (const auto* fixture : { "drums", "pads", "noise" })
+    {
+        juce::AudioBuffer<float> input(numChannels, static_cast<int>(fixtureSeconds * goldenSampleRate));
+        fillFixture(input, fixture);
+
+        for (const auto& preset : presets)
+        {
+            const auto caseName = juce::File::createLegalFileName(preset.name + "_" + fixture + "_offline_" + juce::String(numChannels) + "ch");
+            const auto file = pluginDirectory.getChildFile(caseName + ".golden");
+            const auto actual = render(input, preset);
+
+            if (! stayedAtFullQuality(actual))
+            {
+                std::printf("FAIL %s: the quality governor left the full tier in an offline render\n", caseName.toRawUTF8());
+                ++failures;
+                continue;
+            }
+
+            if (recording)
+            {
+                if (! writeGolden(file, actual))
+                {
+                    std::printf("FAIL %s: cannot write %s\n", caseName.toRawUTF8(), file.getFullPathName().toRawUTF8());
+                    ++failures;
+                }
+                continue;
+            }
+
+            Render expected;
+            if (! readGolden(file, expected))
+            {
+                std::printf("FAIL %s: missing or unreadable golden file\n", caseName.toRawUTF8());
+                ++failures;
+                continue;
+            }
+
+            const auto problem = compare(expected, actual, tolerance, true);
+            if (problem.isNotEmpty())
+            {
+                std::printf("FAIL %s: %s\n", caseName.toRawUTF8(), problem.toRawUTF8());
+                ++failures;
+            }
+            else
+            {
+                ++passed;
+            }
+        }
+    }
+
+    std::printf("%s: %d passed, %d failed\n", JucePlugin_Name, passed, failures);
+    return failures == 0 ? 0 : 1;
+}
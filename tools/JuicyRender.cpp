@@ -0,0 +1,842 @@
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include "plugins/JuicyCohere/PluginProcessor.h"
+#include "plugins/JuicyInfer/PluginProcessor.h"
+#include "plugins/JuicyMotion/PluginProcessor.h"
+#include "plugins/JuicyPunch/PluginProcessor.h"
+#include "plugins/JuicySaturator/PluginProcessor.h"
+#include "plugins/JuicyTexture/PluginProcessor.h"
+#include "plugins/JuicyWidth/PluginProcessor.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct ProcessorType
+{
+    const char* key;
+    juce::AudioProcessor* (*create)();
+};
+
+const ProcessorType processorTypes[] = {
+    { "infer", [] () -> juce::AudioProcessor* { return new JuicyInferAudioProcessor(); } },
+    { "punch", [] () -> juce::AudioProcessor* { return new JuicyPunchAudioProcessor(); } },
+    { "saturator", [] () -> juce::AudioProcessor* { return new JuicySaturatorAudioProcessor(); } },
+    { "width", [] () -> juce::AudioProcessor* { return new JuicyWidthAudioProcessor(); } },
+    { "cohere", [] () -> juce::AudioProcessor* { return new JuicyCohereAudioProcessor(); } },
+    { "texture", [] () -> juce::AudioProcessor* { return new JuicyTextureAudioProcessor(); } },
+    { "motion", [] () -> juce::AudioProcessor* { return new JuicyMotionAudioProcessor(); } }
+};
+
+// Longest tail rendered after the input ends, whatever the processors report.
+constexpr double maxTailSeconds = 30.0;
+// Where chunks of a file meet, the next chunk fades in over this long.
+constexpr double crossfadeSeconds = 0.01;
+
+struct StageSpec
+{
+    const ProcessorType* type = nullptr;
+    juce::String preset; // program name or index; empty keeps the processor's default
+};
+
+// "--set punch.drive=0.7" sets every Punch stage, "--set 2.drive=0.7" only the second stage.
+struct Override
+{
+    juce::String stage;
+    juce::String parameterId;
+    float value = 0.0f;
+};
+
+struct RenderSettings
+{
+    std::vector<StageSpec> stages;
+    std::vector<Override> overrides;
+    juce::File outputDirectory;
+    int blockSize = 1024;
+    int numThreads = static_cast<int>(juce::jmax(1u, std::thread::hardware_concurrency()));
+    int bitsPerSample = 32;
+    double tailSeconds = -1.0; // below zero: the chain's own tail length
+    bool offline = true;
+    double chunkSeconds = 0.0;    // 0 renders every file in one piece
+    double prerollSeconds = -1.0; // below zero: the chain's tail length, at least a second
+    bool verify = false;
+    double verifyThresholdDb = -80.0;
+};
+
+struct InputFile
+{
+    juce::File file;
+    juce::String name; // path relative to the argument it was found under
+    juce::int64 size = 0;
+};
+
+// Mean and max of every metric over a render's blocks.
+struct MetricsSummary
+{
+    std::array<double, numJuicinessMetricFields> mean {};
+    std::array<float, numJuicinessMetricFields> max {};
+    int numHops = 0;
+
+    void add(const JuicinessMetrics& metrics)
+    {
+        for (size_t i = 0; i < juicinessMetricFields.size(); ++i)
+        {
+            const float value = juicinessMetricFields[i].read(metrics);
+            mean[i] += value;
+            max[i] = numHops == 0 ? value : juce::jmax(max[i], value);
+        }
+        ++numHops;
+    }
+
+    juce::var toVar() const
+    {
+        auto* means = new juce::DynamicObject();
+        auto* maxima = new juce::DynamicObject();
+        for (size_t i = 0; i < juicinessMetricFields.size(); ++i)
+        {
+            means->setProperty(juicinessMetricFields[i].name, mean[i] / juce::jmax(1, numHops));
+            maxima->setProperty(juicinessMetricFields[i].name, max[i]);
+        }
+        auto* result = new juce::DynamicObject();
+        result->setProperty("mean", juce::var(means));
+        result->setProperty("max", juce::var(maxima));
+        return juce::var(result);
+    }
+};
+
+// Tells the stages where each block sits in the file. Their noise, modulators and analysis
+// frames are keyed to that position, which is what lets a chunk rendered on its own line up
+// with the serial render of the same file.
+class RenderPlayHead : public juce::AudioPlayHead
+{
+public:
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setIsPlaying(true);
+        info.setTimeInSamples(position);
+        return info;
+    }
+
+    juce::int64 position = 0;
+};
+
+class Chain
+{
+public:
+    // Builds the stages with their presets and overrides; returns an error message on failure.
+    juce::String create(const RenderSettings& settings)
+    {
+        for (size_t index = 0; index < settings.stages.size(); ++index)
+        {
+            const auto& spec = settings.stages[index];
+            std::unique_ptr<juce::AudioProcessor> processor(spec.type->create());
+            processor->setPlayHead(&playHead);
+
+            if (spec.preset.isNotEmpty())
+            {
+                int program = -1;
+                for (int i = 0; i < processor->getNumPrograms() && program < 0; ++i)
+                    if (processor->getProgramName(i).equalsIgnoreCase(spec.preset))
+                        program = i;
+                if (program < 0 && spec.preset.containsOnly("0123456789") && spec.preset.getIntValue() < processor->getNumPrograms())
+                    program = spec.preset.getIntValue();
+                if (program < 0)
+                    return juce::String(spec.type->key) + " has no preset \"" + spec.preset + "\"";
+                processor->setCurrentProgram(program);
+            }
+
+            for (const auto& change : settings.overrides)
+            {
+                if (change.stage != spec.type->key && change.stage != juce::String(static_cast<int>(index) + 1))
+                    continue;
+                bool found = false;
+                for (auto* parameter : processor->getParameters())
+                    if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter); ranged != nullptr && ranged->paramID == change.parameterId)
+                    {
+                        ranged->setValueNotifyingHost(ranged->convertTo0to1(change.value));
+                        found = true;
+                    }
+                if (! found)
+                    return juce::String(spec.type->key) + " has no parameter \"" + change.parameterId + "\"";
+            }
+            stages.push_back(std::move(processor));
+        }
+        return {};
+    }
+
+    // Called before every file, so each render starts from freshly prepared state.
+    bool prepare(int numChannels, double sampleRate, int blockSize, bool offline)
+    {
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+        buses.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+        for (auto& stage : stages)
+        {
+            if (! stage->setBusesLayout(buses))
+                return false;
+            stage->setNonRealtime(offline);
+            stage->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            stage->prepareToPlay(sampleRate, blockSize);
+        }
+        return true;
+    }
+
+    int getLatencySamples() const
+    {
+        int latency = 0;
+        for (const auto& stage : stages)
+            latency += stage->getLatencySamples();
+        return latency;
+    }
+
+    double getTailLengthSeconds() const
+    {
+        double tail = 0.0;
+        for (const auto& stage : stages)
+            tail += stage->getTailLengthSeconds();
+        return tail;
+    }
+
+    // position: where the block's first sample sits in the input.
+    void process(juce::AudioBuffer<float>& block, juce::int64 position)
+    {
+        playHead.position = position;
+        for (auto& stage : stages)
+        {
+            midi.clear();
+            stage->processBlock(block, midi);
+        }
+    }
+
+private:
+    RenderPlayHead playHead;
+    std::vector<std::unique_ptr<juce::AudioProcessor>> stages;
+    juce::MidiBuffer midi;
+};
+
+// A file rendered in chunks by several workers. Output sample t belongs to chunk
+// t / chunkLength. Each chunk starts processing prerollLength samples early, so the stages'
+// filters and feedback have settled by the time its output begins, and it renders
+// crossfadeLength samples past its end for the next chunk to fade in over. The worker that
+// finishes the last chunk stitches the parts into the output file.
+struct ChunkPlan
+{
+    const InputFile* input = nullptr;
+    juce::File output;
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    juce::int64 inputLength = 0;
+    juce::int64 outputLength = 0;
+    juce::int64 latency = 0;
+    juce::int64 chunkLength = 0;
+    juce::int64 prerollLength = 0;
+    int crossfadeLength = 0;
+    int numChunks = 1;
+    std::atomic<int> chunksLeft { 0 };
+    std::atomic<juce::int64> renderTicks { 0 };
+    std::mutex errorMutex;
+    juce::String error;
+
+    juce::File partFile(int chunk) const { return output.withFileExtension("part" + juce::String(chunk) + ".wav"); }
+
+    void fail(const juce::String& problem)
+    {
+        const std::lock_guard<std::mutex> lock(errorMutex);
+        if (error.isEmpty())
+            error = problem;
+    }
+};
+
+std::vector<InputFile> collectInputs(const juce::StringArray& paths, const juce::String& wildcard)
+{
+    std::vector<InputFile> inputs;
+    for (const auto& path : paths)
+    {
+        const auto root = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+        if (root.isDirectory())
+        {
+            for (const auto& entry : juce::RangedDirectoryIterator(root, true, wildcard, juce::File::findFiles))
+                inputs.push_back({ entry.getFile(), entry.getFile().getRelativePathFrom(root), entry.getFileSize() });
+        }
+        else
+        {
+            inputs.push_back({ root, root.getFileName(), root.getSize() });
+        }
+    }
+    return inputs;
+}
+
+std::unique_ptr<juce::AudioFormatReader> openReader(juce::AudioFormatManager& formats, const juce::File& file)
+{
+    if (auto* format = formats.findFormatForFileExtension(file.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return mapped;
+    }
+    return std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(file));
+}
+
+std::unique_ptr<juce::AudioFormatWriter> createWavWriter(const juce::File& file, double sampleRate, int numChannels, int bitsPerSample,
+                                                         juce::String& problem)
+{
+    if (! file.getParentDirectory().createDirectory())
+    {
+        problem = "cannot create " + file.getParentDirectory().getFullPathName();
+        return {};
+    }
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (! stream->openedOk())
+    {
+        problem = "cannot write " + file.getFullPathName();
+        return {};
+    }
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(numChannels),
+                                                                        bitsPerSample, {}, 0));
+    if (writer == nullptr)
+    {
+        problem = "cannot encode " + juce::String(numChannels) + " channels at " + juce::String(bitsPerSample) + " bits";
+        return {};
+    }
+    stream.release();
+    return writer;
+}
+
+// Runs the chain a block at a time from processing position processStart and hands every
+// output sample in [begin, end) to output(block, startInBlock, num). Output sample t leaves the
+// chain at processing position t + latency. Each block read from the input is handed to
+// input(block, num) before it is processed. Nothing grows with the file length.
+template <typename InputFn, typename OutputFn>
+juce::String streamThroughChain(juce::AudioFormatReader& reader, Chain& chain, juce::AudioBuffer<float>& block, int blockSize,
+                                juce::int64 processStart, juce::int64 begin, juce::int64 end, juce::int64 latency,
+                                InputFn&& input, OutputFn&& output)
+{
+    const int numChannels = static_cast<int>(reader.numChannels);
+    for (juce::int64 position = processStart; position < end + latency; position += blockSize)
+    {
+        const auto num = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize), end + latency - position));
+        block.setSize(numChannels, num, false, false, true);
+        block.clear();
+
+        const auto readable = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(num), reader.lengthInSamples - position));
+        if (readable > 0)
+        {
+            if (! reader.read(&block, 0, readable, position, true, true))
+                return "read failed at sample " + juce::String(position);
+            input(block, readable);
+        }
+
+        chain.process(block, position);
+
+        const auto skip = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(num), begin + latency - position));
+        const int keep = num - skip;
+        if (keep > 0)
+        {
+            const auto problem = output(block, skip, keep);
+            if (problem.isNotEmpty())
+                return problem;
+        }
+    }
+    return {};
+}
+
+juce::String writeSidecar(const juce::File& output, const InputFile& input, double sampleRate, int numChannels, juce::int64 inputLength,
+                          juce::int64 outputLength, juce::int64 latency, int numChunks, double renderSeconds,
+                          const MetricsSummary& inputMetrics, const MetricsSummary& outputMetrics)
+{
+    const double audioSeconds = static_cast<double>(outputLength) / sampleRate;
+    auto* sidecar = new juce::DynamicObject();
+    sidecar->setProperty("source", input.file.getFullPathName());
+    sidecar->setProperty("sampleRate", sampleRate);
+    sidecar->setProperty("channels", numChannels);
+    sidecar->setProperty("inputSeconds", static_cast<double>(inputLength) / sampleRate);
+    sidecar->setProperty("outputSeconds", audioSeconds);
+    sidecar->setProperty("latencySamples", static_cast<int>(latency));
+    sidecar->setProperty("chunks", numChunks);
+    // For chunked renders, the time of all chunks and the stitch added up.
+    sidecar->setProperty("renderSeconds", renderSeconds);
+    sidecar->setProperty("realtimeFactor", audioSeconds / juce::jmax(renderSeconds, 1.0e-12));
+    sidecar->setProperty("input", inputMetrics.toVar());
+    sidecar->setProperty("output", outputMetrics.toVar());
+    if (! output.withFileExtension("metrics.json").replaceWithText(juce::JSON::toString(juce::var(sidecar))))
+        return "cannot write the metrics sidecar";
+    return {};
+}
+
+double getTailSeconds(const Chain& chain, const RenderSettings& settings)
+{
+    return juce::jlimit(0.0, maxTailSeconds, settings.tailSeconds >= 0.0 ? settings.tailSeconds : chain.getTailLengthSeconds());
+}
+
+// Streams one file through the chain in a single pass. The chain's latency is trimmed from the
+// start of the output and its tail rendered past the end of the input, so the result lines up
+// with the source.
+juce::String renderFile(const InputFile& input, const juce::File& output, Chain& chain, const RenderSettings& settings,
+                        juce::AudioFormatManager& formats, juce::AudioBuffer<float>& block, double& audioSeconds)
+{
+    const auto reader = openReader(formats, input.file);
+    if (reader == nullptr)
+        return "unreadable or unsupported format";
+
+    const double sampleRate = reader->sampleRate;
+    const int numChannels = static_cast<int>(reader->numChannels);
+    const auto inputLength = reader->lengthInSamples;
+    if (sampleRate <= 0.0 || numChannels <= 0)
+        return "no audio";
+    if (! chain.prepare(numChannels, sampleRate, settings.blockSize, settings.offline))
+        return juce::String(numChannels) + " channels are not supported by every stage";
+
+    juce::String problem;
+    auto writer = createWavWriter(output, sampleRate, numChannels, settings.bitsPerSample, problem);
+    if (writer == nullptr)
+        return problem;
+
+    const auto outputLength = inputLength + static_cast<juce::int64>(std::ceil(getTailSeconds(chain, settings) * sampleRate));
+    const auto latency = static_cast<juce::int64>(chain.getLatencySamples());
+
+    const int analysedChannels = juce::jmin(2, numChannels);
+    JuicinessAnalyzer inputAnalyzer, outputAnalyzer;
+    inputAnalyzer.prepare(sampleRate, settings.blockSize, analysedChannels);
+    outputAnalyzer.prepare(sampleRate, settings.blockSize, analysedChannels);
+    MetricsSummary inputMetrics, outputMetrics;
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    problem = streamThroughChain(*reader, chain, block, settings.blockSize, 0, 0, outputLength, latency,
+        [&](const juce::AudioBuffer<float>& in, int num)
+        {
+            inputAnalyzer.beginBlock();
+            inputAnalyzer.accumulate(in, 0, num);
+            inputMetrics.add(inputAnalyzer.finishBlock());
+        },
+        [&](const juce::AudioBuffer<float>& out, int startSample, int num) -> juce::String
+        {
+            if (! writer->writeFromAudioSampleBuffer(out, startSample, num))
+                return "write failed for " + output.getFullPathName();
+            outputAnalyzer.beginBlock();
+            outputAnalyzer.accumulate(out, startSample, num);
+            outputMetrics.add(outputAnalyzer.finishBlock());
+            return {};
+        });
+    if (problem.isNotEmpty())
+        return problem;
+    writer.reset();
+    const double renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    audioSeconds = static_cast<double>(outputLength) / sampleRate;
+    return writeSidecar(output, input, sampleRate, numChannels, inputLength, outputLength, latency, 1, renderSeconds, inputMetrics, outputMetrics);
+}
+
+// Reads the file's format and asks a prepared chain for its latency and tail to lay out the
+// chunks. Files that cannot be opened, or are no longer than one chunk, stay in one piece and
+// report their problems from renderFile.
+void planChunks(ChunkPlan& plan, Chain& probe, const RenderSettings& settings, juce::AudioFormatManager& formats)
+{
+    plan.numChunks = 1;
+    const auto reader = openReader(formats, plan.input->file);
+    if (settings.chunkSeconds <= 0.0 || reader == nullptr || reader->sampleRate <= 0.0 || reader->numChannels == 0)
+        return;
+
+    plan.sampleRate = reader->sampleRate;
+    plan.numChannels = static_cast<int>(reader->numChannels);
+    plan.inputLength = reader->lengthInSamples;
+    if (! probe.prepare(plan.numChannels, plan.sampleRate, settings.blockSize, settings.offline))
+        return;
+
+    const double tail = getTailSeconds(probe, settings);
+    plan.outputLength = plan.inputLength + static_cast<juce::int64>(std::ceil(tail * plan.sampleRate));
+    plan.latency = probe.getLatencySamples();
+    plan.chunkLength = static_cast<juce::int64>(settings.chunkSeconds * plan.sampleRate);
+    const double preroll = settings.prerollSeconds >= 0.0 ? settings.prerollSeconds
+                                                          : juce::jlimit(1.0, maxTailSeconds, probe.getTailLengthSeconds());
+    plan.prerollLength = static_cast<juce::int64>(std::ceil(preroll * plan.sampleRate));
+    plan.crossfadeLength = juce::jmax(1, static_cast<int>(crossfadeSeconds * plan.sampleRate));
+    plan.numChunks = juce::jmax(1, static_cast<int>((plan.outputLength + plan.chunkLength - 1) / plan.chunkLength));
+    plan.chunksLeft = plan.numChunks;
+}
+
+// Renders one chunk, with its pre-roll and crossfade overlap, into a 32-bit float part file.
+juce::String renderChunk(ChunkPlan& plan, int chunk, Chain& chain, const RenderSettings& settings, juce::AudioFormatManager& formats,
+                         juce::AudioBuffer<float>& block)
+{
+    const auto start = juce::Time::getHighResolutionTicks();
+    const auto reader = openReader(formats, plan.input->file);
+    if (reader == nullptr)
+        return "unreadable or unsupported format";
+    if (! chain.prepare(plan.numChannels, plan.sampleRate, settings.blockSize, settings.offline))
+        return juce::String(plan.numChannels) + " channels are not supported by every stage";
+
+    juce::String problem;
+    auto writer = createWavWriter(plan.partFile(chunk), plan.sampleRate, plan.numChannels, 32, problem);
+    if (writer == nullptr)
+        return problem;
+
+    // The pre-roll starts on the serial render's block grid, so every block boundary the chunk
+    // sees is one the serial render sees too.
+    const auto begin = chunk * plan.chunkLength;
+    const auto end = juce::jmin(plan.outputLength, begin + plan.chunkLength + plan.crossfadeLength);
+    const auto processStart = juce::jmax(static_cast<juce::int64>(0), begin + plan.latency - plan.prerollLength)
+                            / settings.blockSize * settings.blockSize;
+    problem = streamThroughChain(*reader, chain, block, settings.blockSize, processStart, begin, end, plan.latency,
+        [](const juce::AudioBuffer<float>&, int) {},
+        [&](const juce::AudioBuffer<float>& out, int startSample, int num) -> juce::String
+        {
+            return writer->writeFromAudioSampleBuffer(out, startSample, num) ? juce::String() : "write failed for " + plan.partFile(chunk).getFullPathName();
+        });
+    plan.renderTicks.fetch_add(juce::Time::getHighResolutionTicks() - start);
+    return problem;
+}
+
+// Joins the parts into the output file: each chunk's first crossfadeLength samples fade
+// linearly from the previous chunk's overlap to its own. The sidecar metrics are taken here,
+// in the same blocks as a serial render would take them.
+juce::String stitchChunks(ChunkPlan& plan, const RenderSettings& settings, juce::AudioFormatManager& formats,
+                          juce::AudioBuffer<float>& block, double& audioSeconds)
+{
+    const auto start = juce::Time::getHighResolutionTicks();
+    const auto source = openReader(formats, plan.input->file);
+    if (source == nullptr)
+        return "unreadable or unsupported format";
+    juce::String problem;
+    auto writer = createWavWriter(plan.output, plan.sampleRate, plan.numChannels, settings.bitsPerSample, problem);
+    if (writer == nullptr)
+        return problem;
+
+    const int analysedChannels = juce::jmin(2, plan.numChannels);
+    JuicinessAnalyzer inputAnalyzer, outputAnalyzer;
+    inputAnalyzer.prepare(plan.sampleRate, settings.blockSize, analysedChannels);
+    outputAnalyzer.prepare(plan.sampleRate, settings.blockSize, analysedChannels);
+    MetricsSummary inputMetrics, outputMetrics;
+    for (juce::int64 position = 0; position < plan.inputLength; position += settings.blockSize)
+    {
+        const auto num = static_cast<int>(juce::jmin(static_cast<juce::int64>(settings.blockSize), plan.inputLength - position));
+        block.setSize(plan.numChannels, num, false, false, true);
+        if (! source->read(&block, 0, num, position, true, true))
+            return "read failed at sample " + juce::String(position);
+        inputAnalyzer.beginBlock();
+        inputAnalyzer.accumulate(block, 0, num);
+        inputMetrics.add(inputAnalyzer.finishBlock());
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> previous, current;
+    juce::AudioBuffer<float> overlap;
+    for (int chunk = 0; chunk < plan.numChunks; ++chunk)
+    {
+        previous = std::move(current);
+        current = openReader(formats, plan.partFile(chunk));
+        if (current == nullptr)
+            return "cannot read " + plan.partFile(chunk).getFullPathName();
+
+        const auto begin = chunk * plan.chunkLength;
+        const auto end = juce::jmin(plan.outputLength, begin + plan.chunkLength);
+        for (auto position = begin; position < end; position += settings.blockSize)
+        {
+            const auto num = static_cast<int>(juce::jmin(static_cast<juce::int64>(settings.blockSize), end - position));
+            block.setSize(plan.numChannels, num, false, false, true);
+            if (! current->read(&block, 0, num, position - begin, true, true))
+                return "cannot read " + plan.partFile(chunk).getFullPathName();
+
+            const auto fade = previous != nullptr ? static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(num),
+                                                                                  plan.crossfadeLength - (position - begin)))
+                                                  : 0;
+            if (fade > 0)
+            {
+                overlap.setSize(plan.numChannels, fade, false, false, true);
+                if (! previous->read(&overlap, 0, fade, position - (begin - plan.chunkLength), true, true))
+                    return "cannot read " + plan.partFile(chunk - 1).getFullPathName();
+                for (int ch = 0; ch < plan.numChannels; ++ch)
+                {
+                    auto* x = block.getWritePointer(ch);
+                    const auto* before = overlap.getReadPointer(ch);
+                    for (int i = 0; i < fade; ++i)
+                    {
+                        const auto weight = static_cast<float>((static_cast<double>(position - begin + i) + 0.5) / plan.crossfadeLength);
+                        x[i] = before[i] + weight * (x[i] - before[i]);
+                    }
+                }
+            }
+
+            if (! writer->writeFromAudioSampleBuffer(block, 0, num))
+                return "write failed for " + plan.output.getFullPathName();
+            outputAnalyzer.beginBlock();
+            outputAnalyzer.accumulate(block, 0, num);
+            outputMetrics.add(outputAnalyzer.finishBlock());
+        }
+    }
+    writer.reset();
+    plan.renderTicks.fetch_add(juce::Time::getHighResolutionTicks() - start);
+
+    audioSeconds = static_cast<double>(plan.outputLength) / plan.sampleRate;
+    const double renderSeconds = juce::Time::highResolutionTicksToSeconds(plan.renderTicks.load());
+    return writeSidecar(plan.output, *plan.input, plan.sampleRate, plan.numChannels, plan.inputLength, plan.outputLength, plan.latency,
+                        plan.numChunks, renderSeconds, inputMetrics, outputMetrics);
+}
+
+// Renders the file again in one pass and compares it with the stitched output, sample by
+// sample. Fails when any difference is above the threshold; report gets the largest
+// difference overall and within the crossfades.
+juce::String verifyChunks(ChunkPlan& plan, Chain& chain, const RenderSettings& settings, juce::AudioFormatManager& formats,
+                          juce::AudioBuffer<float>& block, juce::String& report)
+{
+    const auto serial = plan.output.withFileExtension("serial.wav");
+    double ignored = 0.0;
+    auto problem = renderFile(*plan.input, serial, chain, settings, formats, block, ignored);
+    float overall = 0.0f, seams = 0.0f;
+    if (problem.isEmpty())
+    {
+        const auto chunked = openReader(formats, plan.output);
+        const auto reference = openReader(formats, serial);
+        juce::AudioBuffer<float> expected;
+        for (juce::int64 position = 0; chunked != nullptr && reference != nullptr && position < plan.outputLength; position += settings.blockSize)
+        {
+            const auto num = static_cast<int>(juce::jmin(static_cast<juce::int64>(settings.blockSize), plan.outputLength - position));
+            block.setSize(plan.numChannels, num, false, false, true);
+            expected.setSize(plan.numChannels, num, false, false, true);
+            if (! chunked->read(&block, 0, num, position, true, true) || ! reference->read(&expected, 0, num, position, true, true))
+                break;
+            for (int ch = 0; ch < plan.numChannels; ++ch)
+            {
+                const auto* x = block.getReadPointer(ch);
+                const auto* y = expected.getReadPointer(ch);
+                for (int i = 0; i < num; ++i)
+                {
+                    const float difference = std::abs(x[i] - y[i]);
+                    overall = juce::jmax(overall, difference);
+                    const auto t = position + i;
+                    if (t >= plan.chunkLength && t % plan.chunkLength < plan.crossfadeLength)
+                        seams = juce::jmax(seams, difference);
+                }
+            }
+        }
+        if (chunked == nullptr || reference == nullptr)
+            problem = "cannot read back the renders to verify";
+    }
+    serial.deleteFile();
+    serial.withFileExtension("metrics.json").deleteFile();
+    if (problem.isNotEmpty())
+        return "verify: " + problem;
+
+    const float overallDb = juce::Decibels::gainToDecibels(overall, -200.0f);
+    report = juce::String(plan.numChunks) + " chunks, largest difference from the serial render " + juce::String(overallDb, 1)
+           + " dB, " + juce::String(juce::Decibels::gainToDecibels(seams, -200.0f), 1) + " dB in the crossfades";
+    if (overallDb > settings.verifyThresholdDb)
+        return "chunked render differs from the serial render by " + juce::String(overallDb, 1) + " dB";
+    return {};
+}
+
+// "punch:Crater Impact,texture" -> stages; an unknown processor name is an error.
+bool parseChain(const juce::String& text, std::vector<StageSpec>& stages)
+{
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", "\""))
+    {
+        const auto key = token.upToFirstOccurrenceOf(":", false, false).trim().toLowerCase();
+        const auto it = std::find_if(std::begin(processorTypes), std::end(processorTypes), [&key](const ProcessorType& type) { return key == type.key; });
+        if (it == std::end(processorTypes))
+        {
+            std::fprintf(stderr, "unknown processor \"%s\"; use infer, punch, saturator, width, cohere, texture or motion\n", key.toRawUTF8());
+            return false;
+        }
+        stages.push_back({ it, token.fromFirstOccurrenceOf(":", false, false).trim() });
+    }
+    return ! stages.empty();
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    const auto option = [&args](const char* name) -> juce::String
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    RenderSettings settings;
+    juce::StringArray paths;
+    for (int i = 0; i < args.size(); ++i)
+    {
+        if (args[i] == "--realtime")
+        {
+            settings.offline = false;
+        }
+        else if (args[i] == "--verify")
+        {
+            settings.verify = true;
+        }
+        else if (args[i] == "--set" && i + 1 < args.size())
+        {
+            const auto assignment = args[++i];
+            const auto target = assignment.upToFirstOccurrenceOf("=", false, false);
+            settings.overrides.push_back({ target.upToFirstOccurrenceOf(".", false, false).toLowerCase(),
+                                           target.fromFirstOccurrenceOf(".", false, false),
+                                           assignment.fromFirstOccurrenceOf("=", false, false).getFloatValue() });
+        }
+        else if (args[i].startsWith("--"))
+        {
+            ++i;
+        }
+        else
+        {
+            paths.add(args[i]);
+        }
+    }
+
+    if (paths.isEmpty() || option("--chain").isEmpty() || option("--out").isEmpty())
+    {
+        std::fprintf(stderr, "usage: juicy-render <file|dir>... --chain \"punch:Crater Impact,texture\" --out dir [--set stage.param=value]... "
+                             "[--block n] [--threads n] [--bits 16|24|32] [--tail seconds] [--realtime] "
+                             "[--chunk seconds [--preroll seconds] [--verify [--verify-db dB]]]\n");
+        return 2;
+    }
+    if (! parseChain(option("--chain"), settings.stages))
+        return 2;
+
+    settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(option("--out"));
+    if (option("--block").isNotEmpty())
+        settings.blockSize = juce::jlimit(16, 65536, option("--block").getIntValue());
+    if (option("--threads").isNotEmpty())
+        settings.numThreads = juce::jmax(1, option("--threads").getIntValue());
+    if (option("--bits").isNotEmpty())
+        settings.bitsPerSample = option("--bits").getIntValue();
+    if (option("--tail").isNotEmpty())
+        settings.tailSeconds = juce::jmax(0.0, option("--tail").getDoubleValue());
+    if (option("--chunk").isNotEmpty())
+        settings.chunkSeconds = juce::jmax(1.0, option("--chunk").getDoubleValue());
+    if (option("--preroll").isNotEmpty())
+        settings.prerollSeconds = juce::jmax(0.0, option("--preroll").getDoubleValue());
+    if (option("--verify-db").isNotEmpty())
+        settings.verifyThresholdDb = option("--verify-db").getDoubleValue();
+
+    // Chunks only line up with each other on the offline path: real-time processing lets the
+    // quality governor change the DSP with the load, differently in every chunk.
+    if (settings.chunkSeconds > 0.0 && ! settings.offline)
+    {
+        std::fprintf(stderr, "--chunk needs the offline path; drop --realtime\n");
+        return 2;
+    }
+
+    // Catches bad presets and parameter names once, before any worker starts.
+    {
+        Chain probe;
+        const auto problem = probe.create(settings);
+        if (problem.isNotEmpty())
+        {
+            std::fprintf(stderr, "%s\n", problem.toRawUTF8());
+            return 2;
+        }
+    }
+
+    juce::AudioFormatManager probeFormats;
+    probeFormats.registerBasicFormats();
+    const auto inputs = collectInputs(paths, probeFormats.getWildcardForAllFormats());
+
+    // Largest files first, then whichever worker is free takes the next piece of work: a whole
+    // file, or one chunk of a file long enough to split.
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&inputs](size_t a, size_t b) { return inputs[a].size > inputs[b].size; });
+
+    std::vector<std::unique_ptr<ChunkPlan>> plans;
+    std::vector<std::pair<ChunkPlan*, int>> work;
+    {
+        Chain probe;
+        probe.create(settings);
+        for (const auto index : order)
+        {
+            auto plan = std::make_unique<ChunkPlan>();
+            plan->input = &inputs[index];
+            plan->output = settings.outputDirectory.getChildFile(inputs[index].name).withFileExtension("wav");
+            planChunks(*plan, probe, settings, probeFormats);
+            for (int chunk = 0; chunk < plan->numChunks; ++chunk)
+                work.emplace_back(plan.get(), chunk);
+            plans.push_back(std::move(plan));
+        }
+    }
+
+    std::atomic<size_t> nextWork { 0 };
+    std::atomic<int> failures { 0 };
+    std::mutex reportMutex;
+    double totalAudioSeconds = 0.0;
+    const auto worker = [&]
+    {
+        Chain chain;
+        chain.create(settings);
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        juce::AudioBuffer<float> block;
+        double workerAudioSeconds = 0.0;
+
+        for (size_t next = nextWork.fetch_add(1); next < work.size(); next = nextWork.fetch_add(1))
+        {
+            auto& plan = *work[next].first;
+            const int chunk = work[next].second;
+            juce::String problem, report;
+            double audioSeconds = 0.0;
+            if (plan.numChunks == 1)
+            {
+                problem = renderFile(*plan.input, plan.output, chain, settings, formats, block, audioSeconds);
+            }
+            else
+            {
+                const auto chunkProblem = renderChunk(plan, chunk, chain, settings, formats, block);
+                if (chunkProblem.isNotEmpty())
+                    plan.fail(chunkProblem);
+                if (plan.chunksLeft.fetch_sub(1) != 1)
+                    continue;
+
+                {
+                    const std::lock_guard<std::mutex> lock(plan.errorMutex);
+                    problem = plan.error;
+                }
+                if (problem.isEmpty())
+                    problem = stitchChunks(plan, settings, formats, block, audioSeconds);
+                if (problem.isEmpty() && settings.verify)
+                    problem = verifyChunks(plan, chain, settings, formats, block, report);
+                for (int part = 0; part < plan.numChunks; ++part)
+                    plan.partFile(part).deleteFile();
+            }
+
+            workerAudioSeconds += audioSeconds;
+            if (report.isNotEmpty())
+            {
+                const std::lock_guard<std::mutex> lock(reportMutex);
+                std::printf("%s: %s\n", plan.input->name.toRawUTF8(), report.toRawUTF8());
+            }
+            if (problem.isNotEmpty())
+            {
+                failures.fetch_add(1);
+                const std::lock_guard<std::mutex> lock(reportMutex);
+                std::fprintf(stderr, "FAIL %s: %s\n", plan.input->name.toRawUTF8(), problem.toRawUTF8());
+            }
+        }
+
+        const std::lock_guard<std::mutex> lock(reportMutex);
+        totalAudioSeconds += workerAudioSeconds;
+    };
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < juce::jmin(settings.numThreads, static_cast<int>(work.size())); ++thread)
+        workers.emplace_back(worker);
+    for (auto& thread : workers)
+        thread.join();
+    const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    std::printf("%d files, %d failed, %.1f s of audio in %.1f s (%.1fx real time) on %d threads\n", static_cast<int>(inputs.size()),
+                failures.load(), totalAudioSeconds, wallSeconds, totalAudioSeconds / juce::jmax(wallSeconds, 1.0e-12),
+                static_cast<int>(workers.size()));
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include "shared/JuicyWorkerPool.h"
+#include <atomic>
+#include <cstdio>
+
+#if defined(__linux__) && defined(__GLIBC__)
+ #define JUICY_RT_CHECK_HOOKS 1
+ #include <cerrno>
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <new>
+ #include <pthread.h>
+ #include <unistd.h>
+#else
+ #define JUICY_RT_CHECK_HOOKS 0
+#endif
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+// Everything a real-time audio call must not do is funnelled through reportViolation(): the
+// allocator entry points and mutex locking are replaced for the whole process, and only count
+// while the calling thread is inside a CheckedCall. The worker pool reports each job a worker
+// picks up, so its threads count as inside the call that dispatched the job.
+namespace
+{
+thread_local int checkedDepth = 0;
+thread_local bool reporting = false;
+thread_local bool reportedThisCall = false;
+thread_local const char* currentCall = "";
+std::atomic<const char*> dispatchingCall { "" };
+std::atomic<int> violations { 0 };
+std::atomic<bool> checkLocks { true };
+
+void reportViolation(const char* what) noexcept
+{
+    if (checkedDepth == 0 || reporting || reportedThisCall)
+        return;
+
+    reporting = true;
+    reportedThisCall = true;
+    violations.fetch_add(1);
+#if JUICY_RT_CHECK_HOOKS
+    char message[256];
+    const int length = std::snprintf(message, sizeof(message), "\nRT VIOLATION: %s inside %s\n", what, currentCall);
+    if (length > 0)
+        juce::ignoreUnused(::write(2, message, static_cast<size_t>(juce::jmin(length, static_cast<int>(sizeof(message)) - 1))));
+    void* frames[48];
+    backtrace_symbols_fd(frames, backtrace(frames, 48), 2);
+#else
+    juce::ignoreUnused(what);
+#endif
+    reporting = false;
+}
+
+struct CheckedCall
+{
+    explicit CheckedCall(const char* name) noexcept
+    {
+        currentCall = name;
+        dispatchingCall.store(name);
+        reportedThisCall = false;
+        ++checkedDepth;
+    }
+
+    ~CheckedCall() { --checkedDepth; }
+};
+
+void observeWorkerTask(bool entering) noexcept
+{
+    if (! entering)
+    {
+        --checkedDepth;
+        return;
+    }
+
+    currentCall = dispatchingCall.load();
+    reportedThisCall = false;
+    ++checkedDepth;
+}
+}
+
+#if JUICY_RT_CHECK_HOOKS
+extern "C"
+{
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void __libc_free(void*);
+
+void* malloc(size_t size)
+{
+    reportViolation("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    reportViolation("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    reportViolation("realloc");
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer)
+{
+    if (pointer != nullptr)
+        reportViolation("free");
+    __libc_free(pointer);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size)
+{
+    reportViolation("posix_memalign");
+    *result = __libc_memalign(alignment, size);
+    return *result != nullptr || size == 0 ? 0 : ENOMEM;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    reportViolation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+using MutexFunction = int (*)(pthread_mutex_t*);
+MutexFunction realMutexLock = nullptr;
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    if (checkLocks.load(std::memory_order_relaxed))
+        reportViolation("pthread_mutex_lock");
+    if (realMutexLock == nullptr)
+        realMutexLock = reinterpret_cast<MutexFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    return realMutexLock(mutex);
+}
+}
+
+void* operator new(size_t size)
+{
+    reportViolation("operator new");
+    if (auto* memory = __libc_malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    reportViolation("operator new[]");
+    if (auto* memory = __libc_malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    reportViolation("operator new");
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    reportViolation("operator new[]");
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        reportViolation("operator delete");
+    __libc_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        reportViolation("operator delete[]");
+    __libc_free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete[](pointer); }
+#endif
+
+namespace
+{
+struct CheckSettings
+{
+    int blocksPerLayout = 2000;
+    int maxBlockSize = 2048;
+    juce::int64 seed = 0x52544348;
+    bool forceWorkers = false;
+};
+
+juce::Array<juce::AudioChannelSet> candidateLayouts()
+{
+    return { juce::AudioChannelSet::mono(), juce::AudioChannelSet::stereo(), juce::AudioChannelSet::createLCR(),
+             juce::AudioChannelSet::create5point1(), juce::AudioChannelSet::create7point1(),
+             juce::AudioChannelSet::discreteChannels(16), juce::AudioChannelSet::discreteChannels(32),
+             juce::AudioChannelSet::discreteChannels(48) };
+}
+
+// Noise bursts with long silent stretches, so the idle paths switch on and off as well.
+void fillRandomBlock(juce::AudioBuffer<float>& block, juce::Random& random, bool silent)
+{
+    for (int ch = 0; ch < block.getNumChannels(); ++ch)
+        for (int i = 0; i < block.getNumSamples(); ++i)
+            block.setSample(ch, i, silent ? 0.0f : 0.7f * (2.0f * random.nextFloat() - 1.0f));
+}
+
+// Runs one layout with random block sizes, automation, bypass switching and state reloads.
+// Everything the host would do off the audio thread happens outside a CheckedCall.
+int checkLayout(const juce::AudioChannelSet& layout, const CheckSettings& settings, juce::Random& random)
+{
+    std::unique_ptr<juce::AudioProcessor> processor(createPluginFilter());
+    juce::AudioProcessor::BusesLayout buses;
+    buses.inputBuses.add(layout);
+    buses.outputBuses.add(layout);
+    if (! processor->setBusesLayout(buses))
+        return -1;
+
+    // A threshold of one sends every layout with more than one channel group through the pool.
+    if (settings.forceWorkers)
+        if (auto* parallel = dynamic_cast<JuicyParallelProcessor*>(processor.get()))
+            parallel->setParallelChannelThreshold(1);
+
+    const double rates[] = { 44100.0, 48000.0, 96000.0 };
+    const double sampleRate = rates[random.nextInt(3)];
+    processor->setNonRealtime(random.nextBool());
+    processor->setRateAndBufferSizeDetails(sampleRate, settings.maxBlockSize);
+    processor->prepareToPlay(sampleRate, settings.maxBlockSize);
+
+    const auto& parameters = processor->getParameters();
+    juce::AudioBuffer<float> block(layout.size(), settings.maxBlockSize);
+    juce::MidiBuffer midi;
+    juce::MemoryBlock state;
+    const int before = violations.load();
+    bool bypassed = false;
+    bool silent = false;
+    bool stateJustLoaded = false;
+
+    for (int b = 0; b < settings.blocksPerLayout; ++b)
+    {
+        const int num = 1 + random.nextInt(settings.maxBlockSize);
+        block.setSize(layout.size(), num, false, false, true);
+        if (random.nextInt(40) == 0)
+            silent = ! silent;
+        fillRandomBlock(block, random, silent);
+
+        if (! parameters.isEmpty() && random.nextInt(4) == 0)
+            parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+        if (random.nextInt(60) == 0)
+            bypassed = ! bypassed;
+        if (random.nextInt(150) == 0)
+        {
+            processor->getStateInformation(state);
+            processor->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            stateJustLoaded = true;
+        }
+
+        if (bypassed)
+        {
+            const CheckedCall call("processBlockBypassed");
+            processor->processBlockBypassed(block, midi);
+        }
+        else
+        {
+            const CheckedCall call(stateJustLoaded ? "processBlock after setStateInformation" : "processBlock");
+            processor->processBlock(block, midi);
+        }
+        stateJustLoaded = false;
+    }
+
+    processor->releaseResources();
+    return violations.load() - before;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+#if ! JUICY_RT_CHECK_HOOKS
+    std::printf("%s RtCheck: allocator and lock hooks are only available on Linux with glibc\n", JucePlugin_Name);
+    return 2;
+#else
+    // Resolve everything the hooks and the reporter need before the first checked call.
+    realMutexLock = reinterpret_cast<MutexFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    void* warmUp[4];
+    juce::ignoreUnused(backtrace(warmUp, 4));
+
+    const auto option = [&args](const char* name, int fallback)
+    {
+        const int index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1].getIntValue() : fallback;
+    };
+
+    CheckSettings settings;
+    settings.blocksPerLayout = juce::jmax(1, option("--blocks", settings.blocksPerLayout));
+    settings.maxBlockSize = juce::jmax(1, option("--max-block", settings.maxBlockSize));
+    settings.seed = option("--seed", static_cast<int>(settings.seed));
+    settings.forceWorkers = args.contains("--workers");
+    checkLocks.store(! args.contains("--allow-locks"));
+    JuicyWorkerPool::setTaskObserver(observeWorkerTask);
+
+    juce::Random random(settings.seed);
+    int total = 0;
+    for (const auto& layout : candidateLayouts())
+    {
+        const int found = checkLayout(layout, settings, random);
+        if (found < 0)
+        {
+            std::printf("%-20s unsupported\n", layout.getDescription().toRawUTF8());
+            continue;
+        }
+        std::printf("%-20s %s\n", layout.getDescription().toRawUTF8(),
+                    found == 0 ? "ok" : (juce::String(found) + " violating calls").toRawUTF8());
+        total += found;
+    }
+
+    std::printf("%s: %d real-time violations\n", JucePlugin_Name, total);
+    return total == 0 ? 0 : 1;
+#endif
+}